@@ -55,6 +55,22 @@ void MixedArithmetic01Sym2(benchmark::State& state)
     }
 }
 
+void MixedArithmetic01Sym2Lazy(benchmark::State& state)
+{
+    using sym2::operator""_ex;
+    const sym2::FixedExpr<1> a{"a"};
+    const sym2::FixedExpr<1> b{"b"};
+    sym2::StackBuffer<2048> arena;
+
+    for (auto _ : state) {
+        const sym2::Expr c = sym2::autoSimplify(a + a + 2_ex*b + 2_ex*a/3_ex, &arena);
+        const sym2::Expr d = sym2::autoSimplify(3_ex*b*b*c + 2_ex*a - 4_ex*b, &arena);
+        const sym2::Expr e = sym2::autoSimplify(2_ex*a/7_ex*b*c*c - 2_ex*b, &arena);
+
+        benchmark::DoNotOptimize(e);
+    }
+}
+
 void MixedArithmetic01GiNaC(benchmark::State& state)
 {
     const GiNaC::symbol a{"a"};
@@ -70,6 +86,7 @@ void MixedArithmetic01GiNaC(benchmark::State& state)
 }
 
 BENCHMARK(MixedArithmetic01Sym2);
+BENCHMARK(MixedArithmetic01Sym2Lazy);
 BENCHMARK(MixedArithmetic01GiNaC);
 BENCHMARK(AddTwoSymbolsSym2);
 BENCHMARK(AddTwoSymbolsGiNaC);
@@ -7,10 +7,12 @@ void PolyDegree01Sym2(benchmark::State& state)
 {
     const auto n = static_cast<std::int32_t>(state.range(0));
     const sym2::FixedExpr<1> a{"a"};
-    sym2::Expr x{0, {}};
+    sym2::SumAccumulator acc{{}};
 
     for (std::int32_t i = 1; i < n; ++i)
-        x = sym2::autoSum(x, sym2::autoPower(a, sym2::FixedExpr<1>{i}, {}), {});
+        acc.add(sym2::autoPower(a, sym2::FixedExpr<1>{i}, {}));
+
+    const sym2::Expr x = acc.finalize({});
 
     for (auto _ : state) {
         const std::int32_t result = sym2::degree(x, a);
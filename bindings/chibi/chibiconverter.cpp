@@ -13,16 +13,9 @@
 #include <variant>
 #include "sym2/get.h"
 #include "sym2/query.h"
+#include "sym2/visit.h"
 
 namespace sym2 {
-    template <class... Ts>
-    struct overloaded : Ts... {
-        using Ts::operator()...;
-    };
-
-    template <class... Ts>
-    overloaded(Ts...) -> overloaded<Ts...>;
-
     template <class T, class Container>
     struct ScopedPushPop {
         ScopedPushPop(std::stack<T, Container>& target, PreservedSexp&& toPush)
@@ -288,18 +281,13 @@ sym2::FromExprToChibi::FromExprToChibi(sexp ctx, Expr::allocator_type allocator)
 
 sexp sym2::FromExprToChibi::convert(ExprView<> from)
 {
-    if (is<symbol>(from))
-        return symbolFrom(from);
-    else if (is<number>(from))
-        return dispatchOver(from);
-    else if (is<constant>(from))
-        return symbolDoubleListFrom(from);
-    else if (is<function>(from))
-        return compositeFromFunction(from);
-    else
-        return compositeFromSumProductOrPower(from);
-
-    throw FailedConversionToSexp{"Can't convert to chibi type", Expr{from, alloc}};
+    return visit(from,
+      overloaded{[this](ExprView<symbol> from) { return symbolFrom(from); },
+        [this](ExprView<number> from) { return dispatchOver(from); },
+        [this](ExprView<constant> from) { return symbolDoubleListFrom(from); },
+        [this](ExprView<function> from) { return compositeFromFunction(from); },
+        // Sum, product or power:
+        [this](auto from) { return compositeFromSumProductOrPower(from); }});
 }
 
 sym2::PreservedSexp sym2::FromExprToChibi::preserve(sexp what)
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include "allocator.h"
+#include "expr.h"
+#include "exprvector.h"
+#include "exprview.h"
+
+namespace sym2 {
+    // Collects the summands of a sum and constructs the simplified sum once in the end. Summands
+    // with equal non-constant terms are combined upon insertion through a hash map, e.g. 2*a*b and
+    // 3*a*b to 5*a*b. Adding n summands hence costs O(n) on average, plus sorting the result once,
+    // while repeatedly calling autoSum copies and merges the growing sum every time. Summands must
+    // be simplified, and the result is the same as the one of autoSum.
+    class SumAccumulator {
+      public:
+        using allocator_type = LocalAlloc<>;
+
+        explicit SumAccumulator(allocator_type allocator);
+
+        // Sums are added operand by operand:
+        void add(ExprView<> summand);
+        Expr finalize(Expr::allocator_type allocator) const;
+
+      private:
+        Expr constant;
+        // Non-constant terms and their numeric coefficients, at the same index:
+        ExprVector terms;
+        ScopedLocalVec<Expr> coefficients;
+        // Hash values of terms (as operands of a product) to their index:
+        std::unordered_multimap<std::size_t, std::uint32_t, std::hash<std::size_t>,
+          std::equal_to<std::size_t>, LocalAlloc<std::pair<const std::size_t, std::uint32_t>>>
+          indices;
+    };
+
+    // Collects the factors of a product like SumAccumulator, combining factors with equal bases,
+    // e.g. a^2 and a^b to a^(2 + b). Factors must be simplified, and the result is the same as the
+    // one of autoProduct.
+    class ProductAccumulator {
+      public:
+        using allocator_type = LocalAlloc<>;
+
+        explicit ProductAccumulator(allocator_type allocator);
+
+        // Products are multiplied operand by operand:
+        void multiply(ExprView<> factor);
+        Expr finalize(Expr::allocator_type allocator) const;
+
+      private:
+        Expr coefficient;
+        // Bases and their exponents, at the same index:
+        ExprVector bases;
+        ScopedLocalVec<Expr> exponents;
+        std::unordered_multimap<std::size_t, std::uint32_t, std::hash<std::size_t>,
+          std::equal_to<std::size_t>, LocalAlloc<std::pair<const std::size_t, std::uint32_t>>>
+          indices;
+    };
+}
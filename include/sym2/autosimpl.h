@@ -1,11 +1,23 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <initializer_list>
 #include <span>
 #include "expr.h"
+#include "exprvector.h"
 #include "exprview.h"
+#include "simplificationcache.h"
+#include "simplificationcontext.h"
 
 namespace sym2 {
+    // Canonical results order the operands of sums and products by Cohen's order relation. Results
+    // of the fastIntermediate mode are simplified in the same way, but their operands are ordered
+    // by structural hash values, which is cheaper to establish. Such results must only be combined
+    // with each other or with scalars, and can be turned into canonical ones with canonicalize once
+    // all steps are done. Composites that differ in their mode must not be mixed, see reorder.
+    enum class SimplificationMode { canonical, fastIntermediate };
+
     Expr autoSum(ExprView<> lhs, ExprView<> rhs, Expr::allocator_type allocator);
     Expr autoSum(std::span<const ExprView<>> ops, Expr::allocator_type allocator);
     Expr autoSum(std::initializer_list<ExprView<>> ops, Expr::allocator_type allocator);
@@ -19,4 +31,102 @@ namespace sym2 {
     Expr autoOneOver(ExprView<> arg, Expr::allocator_type allocator);
 
     Expr autoComplex(ExprView<> real, ExprView<> imag, Expr::allocator_type allocator);
+
+    Expr autoSum(
+      ExprView<> lhs, ExprView<> rhs, SimplificationMode mode, Expr::allocator_type allocator);
+    Expr autoSum(
+      std::span<const ExprView<>> ops, SimplificationMode mode, Expr::allocator_type allocator);
+    Expr autoSum(std::initializer_list<ExprView<>> ops, SimplificationMode mode,
+      Expr::allocator_type allocator);
+
+    Expr autoProduct(
+      ExprView<> lhs, ExprView<> rhs, SimplificationMode mode, Expr::allocator_type allocator);
+    Expr autoProduct(
+      std::span<const ExprView<>> ops, SimplificationMode mode, Expr::allocator_type allocator);
+    Expr autoProduct(std::initializer_list<ExprView<>> ops, SimplificationMode mode,
+      Expr::allocator_type allocator);
+
+    Expr autoPower(
+      ExprView<> base, ExprView<> exp, SimplificationMode mode, Expr::allocator_type allocator);
+
+    // Canonical simplification, where the results of all intermediate steps are looked up in and
+    // added to the given cache:
+    Expr autoSum(
+      ExprView<> lhs, ExprView<> rhs, SimplificationCache& cache, Expr::allocator_type allocator);
+    Expr autoSum(
+      std::span<const ExprView<>> ops, SimplificationCache& cache, Expr::allocator_type allocator);
+    Expr autoSum(std::initializer_list<ExprView<>> ops, SimplificationCache& cache,
+      Expr::allocator_type allocator);
+
+    Expr autoProduct(
+      ExprView<> lhs, ExprView<> rhs, SimplificationCache& cache, Expr::allocator_type allocator);
+    Expr autoProduct(
+      std::span<const ExprView<>> ops, SimplificationCache& cache, Expr::allocator_type allocator);
+    Expr autoProduct(std::initializer_list<ExprView<>> ops, SimplificationCache& cache,
+      Expr::allocator_type allocator);
+
+    Expr autoPower(
+      ExprView<> base, ExprView<> exp, SimplificationCache& cache, Expr::allocator_type allocator);
+
+    // Canonical simplification within the limits of the given context, see SimplificationContext.
+    // Throws SimplificationAborted when a limit is exceeded.
+    Expr autoSum(ExprView<> lhs, ExprView<> rhs, SimplificationContext& context,
+      Expr::allocator_type allocator);
+    Expr autoSum(std::span<const ExprView<>> ops, SimplificationContext& context,
+      Expr::allocator_type allocator);
+    Expr autoSum(std::initializer_list<ExprView<>> ops, SimplificationContext& context,
+      Expr::allocator_type allocator);
+
+    Expr autoProduct(ExprView<> lhs, ExprView<> rhs, SimplificationContext& context,
+      Expr::allocator_type allocator);
+    Expr autoProduct(std::span<const ExprView<>> ops, SimplificationContext& context,
+      Expr::allocator_type allocator);
+    Expr autoProduct(std::initializer_list<ExprView<>> ops, SimplificationContext& context,
+      Expr::allocator_type allocator);
+
+    Expr autoPower(ExprView<> base, ExprView<> exp, SimplificationContext& context,
+      Expr::allocator_type allocator);
+
+    // Configuration of the parallel simplification of large sums and products, see below.
+    struct ParallelSimplification {
+        // Sums and products with fewer operands are simplified sequentially:
+        std::size_t minOperands = 4096;
+        // Number of consecutive operands that are simplified as one unit of work:
+        std::size_t chunkSize = 512;
+    };
+
+    // Canonical simplification, where chunks of consecutive operands are simplified with
+    // parallelFor, and the partial results are then merged pairwise in a fixed order, again in
+    // parallel. The result is identical to the sequential one, which relies on the uniqueness of
+    // canonical sums and products. Inputs that violate this are simplified sequentially: those
+    // with floating-point numbers, which can be combined in a different order, and products with
+    // powers of numbers or products, where merged factors like sqrt(2)*sqrt(2) or
+    // (a*b)^(1/2)*(a*b)^(1/2) yield yet another number or product.
+    Expr autoSum(std::span<const ExprView<>> ops, ParallelSimplification policy,
+      Expr::allocator_type allocator);
+    Expr autoProduct(std::span<const ExprView<>> ops, ParallelSimplification policy,
+      Expr::allocator_type allocator);
+
+    enum class BatchOperation { sum, product, power };
+
+    // Canonical simplification of many independent expressions with parallelFor. Every input is
+    // an unsimplified sum, product or power, e.g. constructed with ExprBuilder, whose operands are
+    // simplified already. It's simplified as autoSum, autoProduct or autoPower would with its
+    // operands, and inputs of another type than the operation are taken as a single operand. Each
+    // unit of work simplifies consecutive inputs, each with an arena on the worker's stack, and
+    // collects the results in an arena of its own. They are then copied into slots reserved in the
+    // output, in the order of the inputs. Nothing is appended when a simplification throws.
+    void simplifyBatch(std::span<const ExprView<>> in, BatchOperation op, ExprVector& out);
+
+    // Sorts the operands of all sums and products in the given expression as the given mode does.
+    // Nothing is simplified, as results of both modes are simplified to the same operands.
+    Expr reorder(ExprView<> e, SimplificationMode mode, Expr::allocator_type allocator);
+    // Same as reorder with the canonical mode, for finishing a sequence of fastIntermediate steps:
+    Expr canonicalize(ExprView<> e, Expr::allocator_type allocator);
+
+    // Same as replaceOperand, but the ancestors of the replaced operand are simplified again, from
+    // the innermost one up to the root. All other subtrees are assumed to be simplified already and
+    // aren't touched. Functions are kept as they are apart from the replaced argument.
+    Expr autoReplaceOperand(ExprView<> root, std::span<const std::uint16_t> path,
+      ExprView<> replacement, Expr::allocator_type allocator);
 }
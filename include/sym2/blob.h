@@ -1,77 +1,250 @@
 #pragma once
 
 #include <array>
+#include <bit>
+#include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <numeric>
 #include <span>
+#include <stdexcept>
 #include <string_view>
 #include <vector>
-#include "blob.h"
+#include "blobtype.h"
 #include "largeint.h"
 #include "largerational.h"
+#include "modularint.h"
 #include "compositetype.h"
 #include "domainflag.h"
 #include "doublefctptr.h"
 #include "allocator.h"
+#include "blobvec.h"
 #include "smallrational.h"
+#include "symboltable.h"
 
 namespace sym2 {
-    struct alignas(double) Blob {
-        std::array<std::byte, 8> bytes;
-    };
+    namespace detail {
+        inline constexpr std::size_t smallSymbolNameLength = 6;
+
+        // Assembles a header in the byte layout of DataLayout::SelfDescribing in blob.cpp, but
+        // without the union, so that it can be used in constant expressions.
+        constexpr Blob header(Type classifier, std::array<std::byte, 3> pre,
+          std::array<std::byte, 4> main) noexcept
+        {
+            return Blob{{static_cast<std::byte>(classifier), pre[0], pre[1], pre[2], main[0],
+              main[1], main[2], main[3]}};
+        }
+
+        // The main part is either a small rational or an offset/extent pair, two 16 bit integers
+        // in native byte order:
+        template <class T>
+        constexpr std::array<std::byte, 4> mainBytes(T first, T second) noexcept
+        {
+            static_assert(sizeof(T) == 2);
+
+            const auto lhs = std::bit_cast<std::array<std::byte, 2>>(first);
+            const auto rhs = std::bit_cast<std::array<std::byte, 2>>(second);
+
+            return {lhs[0], lhs[1], rhs[0], rhs[1]};
+        }
+
+        constexpr Type toType(CompositeType composite) noexcept
+        {
+            switch (composite) {
+                case CompositeType::sum:
+                    return Type::sum;
+                case CompositeType::product:
+                    return Type::product;
+                case CompositeType::power:
+                    return Type::power;
+                case CompositeType::complexNumber:
+                    return Type::complexNumber;
+            }
+
+            assert(false && "Unhandled composite type");
+            return Type::sum; // Random choice
+        }
+    }
 
     // For choosing the single-Blob symbol construction vs. constructing a sequence.
-    bool isSmallName(std::string_view name) noexcept;
+    constexpr bool isSmallName(std::string_view name) noexcept
+    {
+        return name.size() <= detail::smallSymbolNameLength;
+    }
+
+    // The following single Blob constructions are constexpr, which allows for constants that
+    // don't need any initialisation at runtime, see FixedExpr.
+    constexpr Blob construct(std::int16_t n) noexcept
+    {
+        return detail::header(Type::smallInt, {}, detail::mainBytes(n, std::int16_t{1}));
+    }
 
-    Blob construct(std::int16_t n) noexcept;
     // Always returns the canonical form of a rational number using gcd, and an integer if denom
     // is one. Negative denominator causes both numerator's and denominator's sign to be
     // flipped. UB if denom is zero.
-    Blob construct(std::int16_t num, std::int16_t denom) noexcept;
+    constexpr Blob construct(std::int16_t num, std::int16_t denom) noexcept
+    {
+        assert(denom != 0);
+
+        if (denom < 0) {
+            num = static_cast<std::int16_t>(-num);
+            denom = static_cast<std::int16_t>(-denom);
+        }
+
+        const auto divisor = std::gcd(num, denom);
+
+        num = static_cast<std::int16_t>(num / divisor);
+        denom = static_cast<std::int16_t>(denom / divisor);
+
+        if (denom == std::int16_t{1})
+            return construct(num);
+        else
+            return detail::header(Type::smallRational, {}, detail::mainBytes(num, denom));
+    }
+
     // Expects a short symbol, where isSmallName(symbolName) returns true (UB otherwise).
-    Blob construct(std::string_view symbolName, DomainFlag domain) noexcept;
+    constexpr Blob construct(std::string_view symbolName, DomainFlag domain) noexcept
+    {
+        assert(isSmallName(symbolName));
+
+        // The name starts right after the domain and may fill the remaining six bytes:
+        std::array<std::byte, 1 + detail::smallSymbolNameLength> bytes{
+          static_cast<std::byte>(domain)};
+
+        for (std::size_t i = 0; i < symbolName.size(); ++i)
+            bytes[i + 1] = static_cast<std::byte>(symbolName[i]);
+
+        return detail::header(Type::shortSymbol, {bytes[0], bytes[1], bytes[2]},
+          {bytes[3], bytes[4], bytes[5], bytes[6]});
+    }
+
+    Blob construct(SymbolId symbol, DomainFlag domain) noexcept;
+    // The distance is relative to the position of the reference itself, and must lead to a header
+    // that isn't a reference (UB otherwise).
+    Blob constructReference(std::int32_t distance) noexcept;
 
     // Construction of composite structures that represent leafs. All these throw std::range_error
     // when the number of Blobs to store exceed 2^16-1.
-    LocalVec<Blob> constructSequence(double value, LocalAlloc<> alloc);
+    BlobVec constructSequence(double value, LocalAlloc<> alloc);
     // Longer symbols are stored as a header and one or more blobs that contain the string data. No
     // restrictions on the name, and always terminated by a null byte. Don't use this function if
     // isSmallName(symbolName) is true.
-    LocalVec<Blob> constructSequence(
+    BlobVec constructSequence(
       std::string_view symbolName, DomainFlag domain, LocalAlloc<> alloc);
     // Constructs a constant, consisting of a constant header blob followed by a symbol blob
     // (short or large, depending on the name length) and a double blob.
-    LocalVec<Blob> constructSequence(std::string_view symbolName, double value, LocalAlloc<> alloc);
+    BlobVec constructSequence(std::string_view symbolName, double value, LocalAlloc<> alloc);
     // The large integer is expected to not fit into the small integer type (i.e. callers should
     // check this first, and potentially construct a small integer instead).
-    LocalVec<Blob> constructSequence(const LargeInt& n, LocalAlloc<> alloc);
+    BlobVec constructSequence(const LargeInt& n, LocalAlloc<> alloc);
     // One of numerator and denominator can fit into a small integer, in which case it is
     // returned as a small integer, but not both of them (callers should check this case and use
     // a small rational type instead).
-    LocalVec<Blob> constructSequence(const LargeRational& n, LocalAlloc<> alloc);
-    // Constructs unary and binary functions:
-    LocalVec<Blob> constructSequence(
+    BlobVec constructSequence(const LargeRational& n, LocalAlloc<> alloc);
+    // The value is expected to be reduced, i.e., smaller than the modulus, and the modulus to be a
+    // prime that is supported by the modular arithmetic (both are not checked here).
+    BlobVec constructSequence(ModularInt n, LocalAlloc<> alloc);
+    // Constructs unary and binary functions. Like sums, products and powers, their extent is
+    // limited to 2^16 - 1, as the first extent byte holds their summary flags. Larger functions
+    // throw std::range_error.
+    BlobVec constructSequence(
       std::string_view function, const Blob* arg, UnaryDoubleFctPtr eval, LocalAlloc<> allocator);
-    LocalVec<Blob> constructSequence(std::string_view function, const Blob* arg1, const Blob* arg2,
+    BlobVec constructSequence(std::string_view function, const Blob* arg1, const Blob* arg2,
       BinaryDoubleFctPtr eval, LocalAlloc<> allocator);
 
-    // Assumes that the follow-up Blobs are placed right after the header blob.
-    Blob constructCompositeHeader(
-      CompositeType composite, std::uint16_t numOperands, std::uint32_t extent) noexcept;
+    // Assumes that the follow-up Blobs are placed right after the header blob. Sums, products and
+    // powers can have an extent of at most 2^16 - 1, complex numbers of at most 2^24 - 1 (throws
+    // std::range_error otherwise). Their summary is not initialised, see computeSummaryInplace.
+    constexpr Blob constructCompositeHeader(
+      CompositeType composite, std::uint16_t numOperands, std::uint32_t extent)
+    {
+        // Sums, products and powers use the first byte for summary flags:
+        const bool summaryByte = composite != CompositeType::complexNumber;
+
+        if (extent >= (summaryByte ? 1u << 16 : 1u << 24))
+            throw std::range_error{"Can't handle composite expression of given size"};
+
+        const auto byte = [extent](int shift) {
+            return static_cast<std::byte>((extent >> shift) & 0xff);
+        };
+
+        return detail::header(detail::toType(composite),
+          {summaryByte ? std::byte{0} : byte(16), byte(8), byte(0)},
+          detail::mainBytes(std::uint16_t{1}, numOperands));
+    }
     // Constructs a duplicate, irrespective of whether the original object is self-contained in a
     // single blob or not.
-    LocalVec<Blob> constructDuplicateSequence(const Blob* from, LocalAlloc<> allocator);
+    BlobVec constructDuplicateSequence(const Blob* from, LocalAlloc<> allocator);
     // Appends a duplicate of the given expression. Works for self-contained single blob expressions
     // and those with additional blobs. The second parameter dictates the index at which the first
     // blob of the duplicate is placed in the output container. If the output container is not large
-    // enough for the new content, it is resized.
-    void appendDuplicateSequence(const Blob* from, std::size_t where, LocalVec<Blob>& output);
+    // enough for the new content, it is resized. When the expression contains references to
+    // subtrees outside of itself, the duplicate shares its repeated subtrees anew.
+    void appendDuplicateSequence(const Blob* from, std::size_t where, BlobVec& output);
+    // Constructs a duplicate in which every repeated sum, product, power or function is stored only
+    // once. Later occurrences are single reference Blobs pointing back to the first one. Throws
+    // std::range_error under the same conditions as the construction of composites.
+    BlobVec constructSharedSequence(const Blob* from, LocalAlloc<> allocator);
+    // Constructs a duplicate in which the operand at the given path, i.e., the logical operand
+    // indices from the root downwards, is replaced by a duplicate of replacement. Only the
+    // ancestors of the operand and the offsets of their subsequent operands are patched, all other
+    // Blobs are copied as they are. Throws std::out_of_range if there is no such operand, and
+    // std::range_error if an ancestor gets too large to be stored.
+    BlobVec constructSplicedSequence(const Blob* root, std::span<const std::uint16_t> path,
+      const Blob* replacement, LocalAlloc<> allocator);
+    // Constructs a duplicate of a sum or product with an additional operand at the given logical
+    // index, or without the operand at the given index. Operands are copied verbatim apart from
+    // their offsets, and the header is updated. UB if the index is out of range or the composite
+    // isn't a sum or product, throws std::range_error if the result is too large to be stored.
+    BlobVec constructInsertedSequence(const Blob* composite, std::uint16_t index,
+      const Blob* operand, LocalAlloc<> allocator);
+    BlobVec constructErasedSequence(
+      const Blob* composite, std::uint16_t index, LocalAlloc<> allocator);
+
+    // Streaming construction of composites, see ExprBuilder. Appends the Blobs that precede the
+    // arguments of a function, i.e., its header, the function pointer and the name. The name is
+    // stored like an operand, with its remote Blobs right after its header Blob.
+    void appendFunctionPrefix(std::string_view name, UnaryDoubleFctPtr eval, BlobVec& output);
+    void appendFunctionPrefix(std::string_view name, BinaryDoubleFctPtr eval, BlobVec& output);
+    // Completes a composite whose header (from constructCompositeHeader or appendFunctionPrefix)
+    // is followed by its operands one after another, each being a root header directly followed by
+    // its remote Blobs. Operand positions are relative to the header, and the last operand ends
+    // with the given range. Root headers are moved in front of all remote Blobs, and the number of
+    // operands, the extent and the summary are set. The name of a function counts as its first
+    // operand here. The scratch space must hold one Blob per operand. Throws std::range_error if
+    // the composite is too large to be stored, without modifying any Blob.
+    void finishCompositeInplace(std::span<Blob> composite,
+      std::span<const std::uint32_t> operandPositions, std::span<Blob> scratch);
+
+    // Summary flags describe all leaves of an expression tree. For sums, products, powers and
+    // functions, they are stored in the header, and must be computed once all operands are in
+    // place (functions do this upon construction). For scalars, they are derived on the fly.
+    enum class SummaryFlag : std::uint8_t {
+        containsSymbol = 0b1,
+        containsFloatingPoint = 0b10, // Includes complex numbers with a floating point part
+        containsComplexNumber = 0b100,
+        // Complex numbers and symbols without domain restriction:
+        containsNonReal = 0b1000,
+        // Real-valued numbers, constants, and symbols with real or positive domain:
+        containsNonComplex = 0b10000,
+        // Sufficient, but not necessary condition for a positive expression. Set for positive
+        // numbers, constants and symbols, sums and products of only positive operands, and powers
+        // with positive base and real-valued exponent.
+        positive = 0b100000,
+        // Not a property of the leaves, but of the encoding: at least one operand in the tree is a
+        // reference to a shared subtree.
+        containsReference = 0b1000000
+    };
+
+    void computeSummaryInplace(Blob* header) noexcept;
+    bool hasSummaryFlag(const Blob* header, SummaryFlag flag) noexcept;
 
     bool isNumberHeader(Blob header) noexcept;
     bool isIntegerHeader(Blob header) noexcept;
     bool isRationalHeader(Blob header) noexcept;
     bool isFloatingPointHeader(Blob header) noexcept;
     bool isComplexNumberHeader(Blob header) noexcept;
+    bool isModularIntHeader(Blob header) noexcept;
     // True for small integer and rationals, false otherwise:
     bool isSmallHeader(Blob header) noexcept;
     // Negation of isSmallHeader:
@@ -79,26 +252,40 @@ namespace sym2 {
     bool isScalarHeader(Blob header) noexcept;
     bool isCompositeHeader(Blob header) noexcept;
     bool isSymbolHeader(Blob header) noexcept;
+    bool isInternedSymbolHeader(Blob header) noexcept;
     bool isConstantHeader(Blob header) noexcept;
     bool isSumHeader(Blob header) noexcept;
     bool isProductHeader(Blob header) noexcept;
     bool isPowerHeader(Blob header) noexcept;
     bool isFunctionHeader(Blob header) noexcept;
 
+    // Returns the header a reference refers to, or the given header if it's not a reference. Only
+    // sums, products, powers and functions are referred to. The structural functions below, i.e.
+    // remoteExtent, belongsTo, nOperands, equal, hasSummaryFlag and the operand accessors, resolve
+    // references on their own, but the classification of headers passed by value doesn't.
+    const Blob* resolveReference(const Blob* header) noexcept;
+
     // The remote extent is the number of blobs stored externally, i.e., in addition, to the root
     // header.
     std::uint32_t remoteExtent(const Blob* header) noexcept;
+    // True if the blob is the given header or one of its remote blobs, i.e., if it's part of the
+    // expression tree rooted at header.
+    bool belongsTo(const Blob* blob, const Blob* header) noexcept;
     // Returns the number of logical operands: zero for scalars, number of function arguments for
     // functions, the number of summands for a sum etc.
     std::uint16_t nOperands(const Blob* header) noexcept;
 
     bool equal(const Blob* lhs, const Blob* rhs) noexcept;
+    // Consistent with equal, i.e., equal expressions have the same hash value:
+    std::size_t hash(const Blob* header) noexcept;
 
     std::int16_t getSmallInt(Blob header) noexcept;
     SmallRational getSmallRational(Blob header) noexcept;
     double getFloatingPoint(const Blob* header) noexcept;
     LargeInt getLargeInt(const Blob* header);
+    ModularInt getModularInt(const Blob* header) noexcept;
     std::string_view getSymbolName(const Blob* header) noexcept;
+    SymbolId getSymbolId(Blob header) noexcept;
     DomainFlag getDomainFlag(const Blob* header) noexcept;
     std::string_view getConstantName(const Blob* header) noexcept;
     std::string_view getFunctionName(const Blob* header) noexcept;
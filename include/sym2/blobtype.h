@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+
+namespace sym2 {
+    struct alignas(double) Blob {
+        std::array<std::byte, 8> bytes;
+    };
+
+    // The first byte of every header blob classifies the expression it's the root of. See blob.cpp
+    // for the layout of the remaining bytes.
+    enum class Type : std::uint8_t {
+        shortSymbol = 1, // Not starting at 0 helps pretty-printing in a debugger
+        longSymbol,
+        constant,
+        smallInt,
+        smallRational,
+        floatingPoint,
+        largeInt,
+        // A large rational can still have one small/inplace integer (either numerator
+        // or denominator):
+        largeRational,
+        complexNumber,
+        sum,
+        product,
+        power,
+        function,
+        // Symbol name stored in the process-wide symbol table, see symboltable.h:
+        internedSymbol,
+        // Operand that refers to an identical subtree stored elsewhere in the same buffer, see
+        // constructSharedSequence. References are resolved before they're wrapped in ExprViews.
+        reference,
+        // Integer modulo a word-sized prime, with value and modulus in two remote Blobs:
+        modularInt
+    };
+
+    // Sets of types, with one bit per type. They allow for classifying a header with a single
+    // load and bit test.
+    using TypeMask = std::uint32_t;
+
+    constexpr TypeMask typeMask(std::same_as<Type> auto... types) noexcept
+    {
+        return (TypeMask{0} | ... | (TypeMask{1} << static_cast<std::uint8_t>(types)));
+    }
+
+    inline Type headerType(const Blob* header) noexcept
+    {
+        return static_cast<Type>(header->bytes[0]);
+    }
+
+    inline bool hasTypeIn(const Blob* header, TypeMask mask) noexcept
+    {
+        return (mask >> static_cast<std::uint8_t>(headerType(header))) & TypeMask{1};
+    }
+
+    constexpr inline TypeMask smallTypes = typeMask(Type::smallInt, Type::smallRational);
+    constexpr inline TypeMask largeTypes = ~smallTypes;
+    constexpr inline TypeMask integerTypes = typeMask(Type::smallInt, Type::largeInt);
+    constexpr inline TypeMask rationalTypes =
+      typeMask(Type::smallInt, Type::smallRational, Type::largeInt, Type::largeRational);
+    constexpr inline TypeMask floatingPointTypes = typeMask(Type::floatingPoint);
+    constexpr inline TypeMask modularIntTypes = typeMask(Type::modularInt);
+    constexpr inline TypeMask numberTypes =
+      rationalTypes | modularIntTypes | typeMask(Type::floatingPoint, Type::complexNumber);
+    constexpr inline TypeMask complexNumberTypes = typeMask(Type::complexNumber);
+    constexpr inline TypeMask symbolTypes =
+      typeMask(Type::shortSymbol, Type::longSymbol, Type::internedSymbol);
+    constexpr inline TypeMask internedSymbolTypes = typeMask(Type::internedSymbol);
+    constexpr inline TypeMask constantTypes = typeMask(Type::constant);
+    constexpr inline TypeMask sumTypes = typeMask(Type::sum);
+    constexpr inline TypeMask productTypes = typeMask(Type::product);
+    constexpr inline TypeMask powerTypes = typeMask(Type::power);
+    constexpr inline TypeMask functionTypes = typeMask(Type::function);
+    constexpr inline TypeMask compositeTypes = sumTypes | productTypes | powerTypes | functionTypes;
+    constexpr inline TypeMask scalarTypes = ~compositeTypes;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <initializer_list>
+#include "allocator.h"
+#include "blobtype.h"
+
+namespace sym2 {
+    // Contiguous sequence of Blobs that keeps the first few of them inline, and only allocates
+    // through the allocator beyond that. Numbers, symbols and small composites like a^2 are hence
+    // stored without any allocation. Allocators never propagate upon assignment, i.e., the
+    // allocator is chosen once at construction, as with std::vector and LocalAlloc. Moving from a
+    // BlobVec with the same allocator takes over its allocated storage, but copies inline Blobs.
+    class BlobVec {
+      public:
+        using allocator_type = LocalAlloc<Blob>;
+
+        static constexpr std::size_t inlineCapacity = 4;
+
+        explicit BlobVec(allocator_type allocator) noexcept;
+        BlobVec(std::size_t n, allocator_type allocator);
+        BlobVec(std::initializer_list<Blob> blobs, allocator_type allocator);
+        BlobVec(const BlobVec& other);
+        BlobVec(const BlobVec& other, allocator_type allocator);
+        BlobVec(BlobVec&& other) noexcept;
+        BlobVec(BlobVec&& other, allocator_type allocator);
+        BlobVec& operator=(const BlobVec& other);
+        BlobVec& operator=(BlobVec&& other);
+        ~BlobVec();
+
+        Blob* data() noexcept;
+        const Blob* data() const noexcept;
+        Blob* begin() noexcept;
+        const Blob* begin() const noexcept;
+        Blob* end() noexcept;
+        const Blob* end() const noexcept;
+        Blob& operator[](std::size_t i) noexcept;
+        const Blob& operator[](std::size_t i) const noexcept;
+        Blob& front() noexcept;
+        const Blob& front() const noexcept;
+        Blob& back() noexcept;
+        const Blob& back() const noexcept;
+
+        std::size_t size() const noexcept;
+        bool empty() const noexcept;
+        std::size_t capacity() const noexcept;
+        // True if no memory has been allocated, i.e., the Blobs are stored inline:
+        bool isInline() const noexcept;
+
+        void reserve(std::size_t n);
+        // New Blobs are initialised with value:
+        void resize(std::size_t n, Blob value = Blob{});
+        void push_back(Blob blob);
+
+        allocator_type get_allocator() const noexcept;
+
+      private:
+        void reallocate(std::size_t newCapacity);
+        void release() noexcept;
+        void assign(const Blob* from, std::size_t n);
+
+        allocator_type allocator;
+        Blob* first;
+        std::size_t count = 0;
+        std::size_t cap = inlineCapacity;
+        Blob inlineBlobs[inlineCapacity];
+    };
+}
@@ -1,12 +1,20 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <complex>
+#include <cstddef>
+#include <functional>
 #include <numeric>
+#include <span>
+#include <vector>
 #include "childiterator.h"
 #include "exprview.h"
 #include "get.h"
+#include "parallel.h"
 #include "query.h"
+#include "visit.h"
 
 namespace sym2 {
     template <class LookupFct>
@@ -39,18 +47,142 @@ namespace sym2 {
     {
         const auto recur = [&symbols](ExprView<> e) { return evalReal(e, symbols); };
 
-        if (is<symbol>(e))
-            return symbols(get<std::string_view>(e));
-        if (is < floatingPoint || constant > (e))
-            return get<double>(e);
-        else if (is < small && (integer || rational) > (e))
-            return get<double>(e);
-        else if (is < large && integer > (e))
-            return static_cast<double>(get<LargeInt>(e));
-        else if (is < large && rational > (e))
-            return static_cast<double>(get<LargeRational>(e));
-        else if (is < complexDomain && number > (e))
-            return recur(real(e));
+        return visit(e,
+          overloaded{[&symbols](ExprView<symbol> s) -> double {
+                         return symbols(get<std::string_view>(s));
+                     },
+            [](ExprView<constant> c) { return get<double>(c); },
+            [&recur](ExprView<number> n) {
+                if (is < floatingPoint || (small && rational) > (n))
+                    return get<double>(n);
+                else if (is<integer>(n))
+                    return static_cast<double>(get<LargeInt>(n));
+                else if (is<rational>(n))
+                    return static_cast<double>(get<LargeRational>(n));
+                else if (is<modularInt>(n))
+                    // The canonical representative in [0, modulus):
+                    return static_cast<double>(get<ModularInt>(n).value);
+
+                assert(is<complexDomain>(n));
+                return recur(real(n));
+            },
+            [&recur](ExprView<sum> s) {
+                return std::transform_reduce(ChildIterator::logicalChildren(s),
+                  ChildIterator::logicalChildrenSentinel(s), 0.0, std::plus<>{}, recur);
+            },
+            [&recur](ExprView<product> p) {
+                return std::transform_reduce(ChildIterator::logicalChildren(p),
+                  ChildIterator::logicalChildrenSentinel(p), 1.0, std::multiplies<>{}, recur);
+            },
+            [&recur](ExprView<power> p) {
+                return std::pow(recur(firstOperand(p)), recur(secondOperand(p)));
+            },
+            [&recur](ExprView<function> f) {
+                assert(nOperands(f) == 1 || nOperands(f) == 2);
+                return nOperands(f) == 1 ?
+                  get<UnaryDoubleFctPtr>(f)(recur(firstOperand(f))) :
+                  get<BinaryDoubleFctPtr>(f)(recur(firstOperand(f)), recur(secondOperand(f)));
+            }});
+    }
+
+    // Configuration of the parallel evaluation of large sums and products, see evalReal below.
+    struct ParallelEvaluation {
+        // Sums and products with fewer operands are evaluated sequentially:
+        std::size_t minOperands = 16384;
+        // Number of consecutive operands that are evaluated as one unit of work:
+        std::size_t chunkSize = 2048;
+    };
+
+    namespace detail {
+        // Neumaier's improved variant of Kahan's compensated summation.
+        class CompensatedSum {
+          public:
+            void add(double summand) noexcept
+            {
+                const double next = sum + summand;
+
+                if (std::abs(sum) >= std::abs(summand))
+                    compensation += (sum - next) + summand;
+                else
+                    compensation += (summand - next) + sum;
+
+                sum = next;
+            }
+
+            double result() const noexcept
+            {
+                return sum + compensation;
+            }
+
+          private:
+            double sum = 0.0;
+            double compensation = 0.0;
+        };
+
+        inline double pairwiseProduct(std::span<const double> factors)
+        {
+            assert(!factors.empty());
+
+            if (factors.size() == 1)
+                return factors.front();
+
+            const std::size_t half = factors.size() / 2;
+
+            return pairwiseProduct(factors.first(half)) * pairwiseProduct(factors.subspan(half));
+        }
+
+        template <class LookupFct>
+        double evalChunked(ExprView<sum || product> e, LookupFct& symbols, std::size_t chunkSize)
+        {
+            const bool isSum = is<sum>(e);
+            const ChildIterator first = ChildIterator::logicalChildren(e);
+            const std::size_t n = nOperands(e);
+            const std::size_t nChunks = (n + chunkSize - 1) / chunkSize;
+            std::vector<double> partials(nChunks);
+
+            parallelFor(nChunks, [&](std::size_t chunk) {
+                const auto begin = first + static_cast<std::ptrdiff_t>(chunk * chunkSize);
+                const auto end =
+                  first + static_cast<std::ptrdiff_t>(std::min(n, (chunk + 1) * chunkSize));
+                const auto recur = [&symbols](ExprView<> e) { return evalReal(e, symbols); };
+
+                if (isSum) {
+                    CompensatedSum result;
+
+                    for (auto op = begin; op != end; ++op)
+                        result.add(recur(*op));
+
+                    partials[chunk] = result.result();
+                } else
+                    partials[chunk] =
+                      std::transform_reduce(begin, end, 1.0, std::multiplies<>{}, recur);
+            });
+
+            if (!isSum)
+                return pairwiseProduct(partials);
+
+            CompensatedSum result;
+
+            for (const double partial : partials)
+                result.add(partial);
+
+            return result.result();
+        }
+    }
+
+    // Same as the sequential evalReal, but large sums and products are split into chunks of
+    // consecutive operands which are evaluated with parallelFor. The lookup function must hence
+    // be safe to invoke concurrently. Chunks don't depend on the number of threads, sums are
+    // accumulated with compensated summation and partial products are combined pairwise, all in a
+    // fixed order. Results are hence reproducible, but can differ in the last bits from the
+    // sequential evalReal.
+    template <class LookupFct>
+    double evalReal(ExprView<> e, LookupFct symbols, ParallelEvaluation policy)
+    {
+        const auto recur = [&](ExprView<> e) { return evalReal(e, symbols, policy); };
+
+        if (is < sum || product > (e) && nOperands(e) >= policy.minOperands)
+            return detail::evalChunked(e, symbols, std::max<std::size_t>(policy.chunkSize, 1));
         else if (is<sum>(e))
             return std::transform_reduce(ChildIterator::logicalChildren(e),
               ChildIterator::logicalChildrenSentinel(e), 0.0, std::plus<>{}, recur);
@@ -59,14 +191,11 @@ namespace sym2 {
               ChildIterator::logicalChildrenSentinel(e), 1.0, std::multiplies<>{}, recur);
         else if (is<power>(e))
             return std::pow(recur(firstOperand(e)), recur(secondOperand(e)));
-        else if (is<function>(e)) {
-            assert(nOperands(e) == 1 || nOperands(e) == 2);
+        else if (is<function>(e))
             return nOperands(e) == 1 ?
               get<UnaryDoubleFctPtr>(e)(recur(firstOperand(e))) :
               get<BinaryDoubleFctPtr>(e)(recur(firstOperand(e)), recur(secondOperand(e)));
-        }
 
-        assert(false);
-        return 0.0;
+        return evalReal(e, symbols);
     }
 }
@@ -1,17 +1,27 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <concepts>
 #include <cstdint>
 #include <initializer_list>
+#include <new>
 #include <span>
+#include <stdexcept>
 #include <string_view>
+#include <type_traits>
+#include <utility>
 #include <vector>
 #include "blob.h"
 #include "compositetype.h"
 #include "doublefctptr.h"
 #include "exprview.h"
 #include "largerational.h"
+#include "modularint.h"
+#include "predicates.h"
 #include "allocator.h"
 #include "domainflag.h"
+#include "symboltable.h"
 
 namespace sym2 {
     class Expr {
@@ -30,16 +40,24 @@ namespace sym2 {
         Expr(std::int32_t num, std::int32_t denom, allocator_type allocator);
 
         Expr(double n, allocator_type allocator);
-        // In case the value fits into a small int, results in a small integer:
+        // In case the value fits into a small int, results in a small integer. Rationals with a
+        // denominator of one result in integers:
         Expr(const LargeInt& n, allocator_type allocator);
         Expr(const LargeRational& n, allocator_type allocator);
+        // The modulus must be an odd prime below 2^63 (throws std::domain_error otherwise), the
+        // value is reduced into [0, modulus):
+        Expr(ModularInt n, allocator_type allocator);
         // Symbol constructors throw std::invalid_argument on empty symbol names:
         Expr(std::string_view symbol, allocator_type allocator);
         Expr(std::string_view symbol, DomainFlag domain, allocator_type allocator);
+        // Interned symbols, see symboltable.h:
+        Expr(SymbolId symbol, allocator_type allocator);
+        Expr(SymbolId symbol, DomainFlag domain, allocator_type allocator);
         // Constructs a constant with given numeric value. The name must be <= 8 bytes, but not
         // empty (throws std::invalid_argument otherwise). The value must be finite (throws
         // std::domain_error otherwise). Only constants in the real domain are supported.
         Expr(std::string_view constant, double value, allocator_type allocator);
+        // Functions throw std::range_error if they exceed 2^16 - 1 Blobs, see blob.h:
         Expr(std::string_view function, ExprView<> arg, UnaryDoubleFctPtr eval,
           allocator_type allocator);
         Expr(std::string_view function, ExprView<> arg1, ExprView<> arg2, BinaryDoubleFctPtr eval,
@@ -67,9 +85,44 @@ namespace sym2 {
         }
 
       private:
-        LocalVec<Blob> buffer;
+        friend class ExprBuilder;
+        friend Expr shareSubtrees(ExprView<> e, allocator_type allocator);
+        friend Expr replaceOperand(ExprView<> root, std::span<const std::uint16_t> path,
+          ExprView<> replacement, allocator_type allocator);
+        friend Expr insertTerm(
+          ExprView<sum || product> composite, ExprView<> term, allocator_type allocator);
+        friend Expr removeTerm(
+          ExprView<sum || product> composite, ExprView<> term, allocator_type allocator);
+
+        explicit Expr(BlobVec&& blobs) noexcept;
+
+        BlobVec buffer;
     };
 
+    // Duplicates e, but stores every sum, product, power or function that occurs more than once
+    // only at its first occurrence. Later occurrences refer back to it, which is transparent to
+    // all queries. Useful for expressions that repeat larger subtrees, e.g. (a + b)^2*sin(a + b).
+    Expr shareSubtrees(ExprView<> e, Expr::allocator_type allocator);
+
+    // Returns a copy of root in which the operand at the given path is replaced. The path consists
+    // of the logical operand indices from the root downwards, e.g. {1, 0} for b in a + b*c. Only
+    // the ancestors of the replaced operand are updated, all other Blobs are copied verbatim,
+    // which makes local edits of large expressions cheap. Nothing is simplified, see
+    // autoReplaceOperand for that. Throws std::out_of_range if there is no such operand.
+    Expr replaceOperand(ExprView<> root, std::span<const std::uint16_t> path,
+      ExprView<> replacement, Expr::allocator_type allocator);
+
+    // Ordered updates of canonical sums and products, the operands of which are sorted by the
+    // order relation. The position of the term is found by binary search, see findTerm, and the
+    // result is a single copy with one operand more or less. insertTerm doesn't simplify, so the
+    // term must be simplified and must not combine with any operand (e.g. 2*a can't be inserted
+    // into a + b, but 2*c can). removeTerm returns the remaining operand if there is only one
+    // left, and an unchanged copy if the term isn't an operand.
+    Expr insertTerm(
+      ExprView<sum || product> composite, ExprView<> term, Expr::allocator_type allocator);
+    Expr removeTerm(
+      ExprView<sum || product> composite, ExprView<> term, Expr::allocator_type allocator);
+
     template <std::size_t N>
     class SmallExpr {
       public:
@@ -117,29 +170,101 @@ namespace sym2 {
         Expr expression;
     };
 
+    // Expression in a fixed-size array of N Blobs, to be used for constants. Small integers,
+    // small rationals and short symbols are constructed at compile time when possible, so that
+    // namespace-scope constants can be constinit and function-local ones don't need a guard.
+    // Everything else is constructed through Expr at runtime. Throws std::bad_alloc if the result
+    // doesn't fit into N Blobs, otherwise like the corresponding Expr constructor.
     template <std::size_t N>
     class FixedExpr {
       public:
         template <class... T>
-        explicit FixedExpr(T&&... args)
-            : storage{nullptr, false}
-            , expression{std::forward<T>(args)..., LocalAlloc{&storage}}
-        {}
+            requires(sizeof...(T) != 1
+              || !(std::same_as<std::remove_cvref_t<T>, FixedExpr> || ...))
+        constexpr explicit FixedExpr(T&&... args)
+        {
+            static_assert(N >= 1);
+
+            if constexpr (sizeof...(T) <= 2
+              && (std::integral<std::remove_cvref_t<T>> && ...))
+                blobs[0] = constructSmall(args...);
+            else if constexpr (sizeof...(T) == 1
+              && (std::convertible_to<T, std::string_view> && ...)) {
+                const std::string_view name{args...};
+
+                if (name.empty())
+                    throw std::invalid_argument{"Empty symbol names are invalid"};
+                else if (isSmallName(name))
+                    blobs[0] = construct(name, DomainFlag::none);
+                else
+                    constructAtRuntime(name);
+            } else
+                constructAtRuntime(std::forward<T>(args)...);
+        }
 
         template <PredicateTag auto tag>
         operator ExprView<tag>() const
         {
-            return static_cast<ExprView<tag>>(expression);
+            return ExprView<tag>{blobs.data()};
         }
 
       private:
-        StackBuffer<N * sizeof(Blob), alignof(Blob)> storage;
-        Expr expression;
+        template <std::integral T>
+        static constexpr std::int16_t toSmall(T n)
+        {
+            if (!std::in_range<std::int16_t>(n))
+                throw std::domain_error("Small integer expressions must fit into 16 bits");
+
+            return static_cast<std::int16_t>(n);
+        }
+
+        static constexpr Blob constructSmall()
+        {
+            return construct(std::int16_t{0});
+        }
+
+        static constexpr Blob constructSmall(std::integral auto n)
+        {
+            return construct(toSmall(n));
+        }
+
+        static constexpr Blob constructSmall(std::integral auto num, std::integral auto denom)
+        {
+            if (denom == 0)
+                throw std::invalid_argument{"Zero denominator during small rational construction"};
+
+            return construct(toSmall(num), toSmall(denom));
+        }
+
+        template <class... T>
+        void constructAtRuntime(T&&... args)
+        {
+            // No fallback allocation, as a larger expression doesn't fit into the Blobs anyhow:
+            StackBuffer<N * sizeof(Blob), alignof(Blob)> buffer{nullptr, false};
+            const Expr e{std::forward<T>(args)..., LocalAlloc<>{&buffer}};
+            const ExprView<> view = e;
+            const std::size_t n = remoteExtent(view.get()) + 1;
+
+            if (n > N)
+                throw std::bad_alloc{};
+
+            std::copy_n(view.get(), n, blobs.begin());
+        }
+
+        std::array<Blob, N> blobs{};
     };
 
     FixedExpr<2> operator"" _ex(long double n);
-    // The string literal must fit into a small symbol, throws std::bad_alloc otherwise.
-    FixedExpr<1> operator"" _ex(const char* str, std::size_t length);
+
+    // The string literal must fit into a short symbol, throws std::bad_alloc otherwise.
+    constexpr FixedExpr<1> operator"" _ex(const char* str, std::size_t length)
+    {
+        return FixedExpr<1>{std::string_view{str, length}};
+    }
+
     // The argument must fit into a std::int16_t, throws std::domain_error otherwise.
-    FixedExpr<1> operator"" _ex(unsigned long long n);
+    constexpr FixedExpr<1> operator"" _ex(unsigned long long n)
+    {
+        return FixedExpr<1>{n};
+    }
 }
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include "allocator.h"
+#include "blobvec.h"
+#include "compositetype.h"
+#include "doublefctptr.h"
+#include "expr.h"
+#include "exprview.h"
+
+namespace sym2 {
+    // Constructs an expression incrementally, directly in its final buffer. Composites are opened,
+    // receive their operands one by one - complete expressions or nested composites - and are
+    // closed again. Compared to collecting operands in a container and passing it to an Expr
+    // constructor, every operand is copied only once, and no temporaries are needed. Nothing is
+    // simplified, the result is identical to the one of the corresponding Expr constructors.
+    class ExprBuilder {
+      public:
+        using allocator_type = LocalAlloc<>;
+
+        explicit ExprBuilder(allocator_type allocator);
+
+        // Throws std::logic_error if a complete expression has already been built, see finish().
+        void open(CompositeType composite);
+        void openFunction(std::string_view name, UnaryDoubleFctPtr eval);
+        void openFunction(std::string_view name, BinaryDoubleFctPtr eval);
+        // Appends a duplicate of e as the next operand of the innermost open composite, or as the
+        // complete expression if there is none. Throws std::logic_error in the latter case if a
+        // complete expression has already been built.
+        void push(ExprView<> e);
+        // Closes the innermost open composite, which must have valid operands as required by the
+        // Expr constructors (throws std::invalid_argument otherwise, and std::range_error if it's
+        // too large). Functions must have one or two arguments as their function pointer. The
+        // composite stays open if an exception is thrown. Throws std::logic_error if nothing is
+        // open.
+        void close();
+        // Number of currently open composites:
+        std::size_t depth() const noexcept;
+
+        // Returns the complete expression and resets the builder. Throws std::logic_error if there
+        // are open composites or nothing has been built.
+        Expr finish();
+
+        allocator_type get_allocator() const noexcept;
+
+      private:
+        struct Frame {
+            std::uint32_t header;
+            // Index of the first operand in operandPositions:
+            std::size_t firstOperand;
+            // Required number of logical operands, or zero for any number of them:
+            std::size_t arity;
+        };
+
+        // Returns the position of the root header of the next operand:
+        std::uint32_t beginOperand() const;
+        void addOperand(std::uint32_t position);
+        void openFrame(std::uint32_t header, std::size_t arity);
+        void validateOperands(const Frame& frame, std::span<const std::uint32_t> operands) const;
+
+        BlobVec blobs;
+        // Positions of the root headers of the operands of all open composites, in order:
+        LocalVec<std::uint32_t> operandPositions;
+        LocalVec<Frame> frames;
+        BlobVec scratch;
+    };
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <boost/stl_interfaces/iterator_interface.hpp>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include "allocator.h"
+#include "blobvec.h"
+#include "exprview.h"
+
+namespace sym2 {
+    // Sequence of expressions that are stored back to back in a single Blob buffer, plus the offset
+    // of each expression into that buffer. Compared to a vector of Exprs, there is no per-element
+    // allocation and no indirection, which matters for large tables of expressions. Elements are
+    // immutable and accessed as ExprViews, which are invalidated by appending, erasing or clearing.
+    class ExprVector {
+      public:
+        using allocator_type = LocalAlloc<>;
+
+        class Iterator : public boost::stl_interfaces::proxy_iterator_interface<Iterator,
+                           std::random_access_iterator_tag, ExprView<>> {
+          public:
+            Iterator() = default;
+
+            ExprView<> operator*() const noexcept;
+            difference_type operator-(Iterator rhs) const noexcept;
+            Iterator& operator+=(difference_type n) noexcept;
+
+          private:
+            friend class ExprVector;
+
+            Iterator(const ExprVector* exprs, std::size_t index) noexcept;
+
+            const ExprVector* exprs = nullptr;
+            std::size_t index = 0;
+        };
+
+        explicit ExprVector(allocator_type allocator);
+
+        // Number of expressions, and number of Blobs they occupy in total:
+        std::size_t size() const noexcept;
+        std::size_t nBlobs() const noexcept;
+        bool empty() const noexcept;
+
+        // UB if the index is out of range.
+        ExprView<> operator[](std::size_t index) const noexcept;
+        Iterator begin() const noexcept;
+        Iterator end() const noexcept;
+
+        void reserve(std::size_t nExprs, std::size_t nBlobs);
+        // The expression is copied, which is fine when it refers to an element of this container.
+        // Throws std::length_error if the total number of Blobs would exceed 2^32 - 1.
+        void push_back(ExprView<> e);
+        // Appends the expressions of all given vectors in order. The slots for all of them are
+        // reserved up front, and the Blobs of each vector are then copied as a whole with
+        // parallelFor. Throws std::length_error as push_back, nothing is appended in this case.
+        void append(std::span<const ExprVector> parts);
+        void pop_back() noexcept;
+        void clear() noexcept;
+
+        // Erases all expressions for which the predicate is true in a single pass, moving the
+        // remaining ones towards the front of the buffer while preserving their order. Returns the
+        // number of erased expressions.
+        template <std::predicate<ExprView<>> Predicate>
+        std::size_t eraseIf(Predicate&& pred)
+        {
+            const std::size_t n = size();
+            std::size_t nKept = 0;
+            std::uint32_t end = 0;
+
+            for (std::size_t i = 0; i < n; ++i)
+                if (!std::invoke(pred, (*this)[i]))
+                    end = moveTowardsFront(i, nKept++, end);
+
+            truncate(nKept, end);
+
+            return n - nKept;
+        }
+
+        allocator_type get_allocator() const noexcept;
+
+      private:
+        // Moves the element at index from to index to, its Blobs starting at the given offset.
+        // Returns the offset right after its Blobs after the move.
+        std::uint32_t moveTowardsFront(std::size_t from, std::size_t to, std::uint32_t offset);
+        void truncate(std::size_t nExprs, std::uint32_t nBlobs) noexcept;
+        std::uint32_t endOf(std::size_t index) const noexcept;
+
+        BlobVec blobs;
+        LocalVec<std::uint32_t> offsets;
+    };
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "expr.h"
+#include "exprview.h"
+
+namespace sym2 {
+    // Replaces every maximal numerically evaluable subtree that contains a floating point number
+    // (directly or as part of a complex number) by its numeric value, e.g. sqrt(2)*1.5 + sin(3)
+    // turns into 2.262... Evaluable operands of sums and products that aren't evaluable as a
+    // whole are folded together when at least one of them is inexact, e.g. a*sqrt(2)*1.5 turns
+    // into 2.121...*a. Exact subtrees are left untouched, as are subtrees that don't evaluate to a
+    // finite number. Composites with folded operands are re-simplified. The input is traversed
+    // once, bottom-up, and only the maximal subtrees are evaluated.
+    Expr foldNumeric(ExprView<> e, Expr::allocator_type allocator);
+}
@@ -5,7 +5,9 @@
 #include "doublefctptr.h"
 #include "exprview.h"
 #include "largerational.h"
+#include "modularint.h"
 #include "smallrational.h"
+#include "symboltable.h"
 
 namespace sym2 {
     template <class T>
@@ -25,8 +27,12 @@ namespace sym2 {
     template <>
     LargeRational get<LargeRational>(ExprView<> e);
     template <>
+    ModularInt get<ModularInt>(ExprView<> e);
+    template <>
     std::string_view get<std::string_view>(ExprView<> e);
     template <>
+    SymbolId get<SymbolId>(ExprView<> e);
+    template <>
     UnaryDoubleFctPtr get<UnaryDoubleFctPtr>(ExprView<> e);
     template <>
     BinaryDoubleFctPtr get<BinaryDoubleFctPtr>(ExprView<> e);
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include "exprview.h"
+#include "operandsview.h"
+
+namespace sym2 {
+    // Hash values are consistent with operator==, i.e., equal expressions have the same hash value.
+    // Shared subtrees are hence transparent, while interned and non-interned symbols of the same
+    // name are distinct, as they are upon comparison.
+    std::size_t hash(ExprView<> e) noexcept;
+    // Combines the hash values of all operands in order:
+    std::size_t hash(OperandsView ops) noexcept;
+
+    // For unordered containers:
+    struct ExprHash {
+        std::size_t operator()(ExprView<> e) const noexcept
+        {
+            return hash(e);
+        }
+    };
+}
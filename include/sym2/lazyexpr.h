@@ -0,0 +1,324 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include "allocator.h"
+#include "autosimpl.h"
+#include "expr.h"
+#include "exprview.h"
+
+namespace sym2 {
+    // Operators that record arithmetic on expressions instead of simplifying every step, in the
+    // spirit of expression templates. The recorded tree is simplified upon conversion to Expr or
+    // with autoSimplify, where every maximal chain of additions and subtractions becomes a single
+    // autoSum call, and every chain of multiplications, divisions and negations a single
+    // autoProduct call. Subtraction adds the product with -1, division multiplies with the power
+    // to -1. Nodes refer to their leaves, so they must be simplified within the full expression
+    // that creates them. Hence, nodes can't be copied, and all operators, the conversion and
+    // autoSimplify only accept them as rvalues: a node stored with auto is an lvalue, and using
+    // it any further doesn't compile. The one exception is returning such a node from a function,
+    // which implicitly moves it. For example,
+    //
+    //     const Expr c = a + a + 2_ex*b - 2_ex*a/3_ex;
+    //
+    // is the same as autoSum({a, a, autoProduct(2_ex, b), autoProduct({-1, 2_ex, a, 1/3})}).
+    template <class Node>
+    class LazyExpr;
+
+    namespace detail {
+        template <class Node>
+        Expr simplify(const LazyExpr<Node>& node, Expr::allocator_type allocator);
+    }
+
+    template <class Node>
+    class LazyExpr {
+      public:
+        LazyExpr() = default;
+        LazyExpr(const LazyExpr&) = delete;
+        LazyExpr& operator=(const LazyExpr&) = delete;
+        LazyExpr(LazyExpr&&) noexcept = default;
+        LazyExpr& operator=(LazyExpr&&) = delete;
+        ~LazyExpr() = default;
+
+        // Simplifies with the default allocator, use autoSimplify for any other:
+        operator Expr() &&
+        {
+            return detail::simplify(*this, Expr::allocator_type{});
+        }
+    };
+
+    template <class Lhs, class Rhs>
+    struct LazySum : LazyExpr<LazySum<Lhs, Rhs>> {
+        LazySum(Lhs lhs, Rhs rhs)
+            : lhs{std::move(lhs)}
+            , rhs{std::move(rhs)}
+        {}
+
+        Lhs lhs;
+        Rhs rhs;
+    };
+
+    template <class Lhs, class Rhs>
+    struct LazyProduct : LazyExpr<LazyProduct<Lhs, Rhs>> {
+        LazyProduct(Lhs lhs, Rhs rhs)
+            : lhs{std::move(lhs)}
+            , rhs{std::move(rhs)}
+        {}
+
+        Lhs lhs;
+        Rhs rhs;
+    };
+
+    template <class Base, class Exp>
+    struct LazyPower : LazyExpr<LazyPower<Base, Exp>> {
+        LazyPower(Base base, Exp exp)
+            : base{std::move(base)}
+            , exp{std::move(exp)}
+        {}
+
+        Base base;
+        Exp exp;
+    };
+
+    template <class Arg>
+    struct LazyNegation : LazyExpr<LazyNegation<Arg>> {
+        explicit LazyNegation(Arg arg)
+            : arg{std::move(arg)}
+        {}
+
+        Arg arg;
+    };
+
+    template <class Arg>
+    struct LazyReciprocal : LazyExpr<LazyReciprocal<Arg>> {
+        explicit LazyReciprocal(Arg arg)
+            : arg{std::move(arg)}
+        {}
+
+        Arg arg;
+    };
+
+    template <class T>
+    concept LazyNode = std::derived_from<std::remove_cvref_t<T>, LazyExpr<std::remove_cvref_t<T>>>;
+
+    // Expressions and their views are leaves, anything else must be a node. T is deduced from a
+    // forwarding reference, so nodes are only accepted as rvalues:
+    template <class T>
+    concept LazyOperand = (LazyNode<T> && !std::is_lvalue_reference_v<T>)
+      || (!LazyNode<T> && std::convertible_to<const T&, ExprView<>>);
+
+    template <class Node>
+    Expr autoSimplify(LazyExpr<Node>&& node, Expr::allocator_type allocator)
+    {
+        return detail::simplify(node, allocator);
+    }
+
+    namespace detail {
+        template <class Lhs, class Rhs>
+        Expr simplify(const LazySum<Lhs, Rhs>& sum, Expr::allocator_type allocator);
+        template <class Lhs, class Rhs>
+        Expr simplify(const LazyProduct<Lhs, Rhs>& product, Expr::allocator_type allocator);
+        template <class Arg>
+        Expr simplify(const LazyNegation<Arg>& negation, Expr::allocator_type allocator);
+        template <class Arg>
+        Expr simplify(const LazyReciprocal<Arg>& reciprocal, Expr::allocator_type allocator);
+        template <class Base, class Exp>
+        Expr simplify(const LazyPower<Base, Exp>& power, Expr::allocator_type allocator);
+
+        template <class Node>
+        Expr simplify(const LazyExpr<Node>& node, Expr::allocator_type allocator)
+        {
+            return simplify(static_cast<const Node&>(node), allocator);
+        }
+
+        template <class T>
+        using LazyOperandType =
+          std::conditional_t<LazyNode<T>, std::remove_cvref_t<T>, ExprView<>>;
+
+        template <class T>
+        LazyOperandType<T> lazyOperand(T&& operand)
+        {
+            if constexpr (LazyNode<T>)
+                return std::move(operand);
+            else
+                return static_cast<ExprView<>>(operand);
+        }
+
+        // Number of operands the top-level autoSum or autoProduct call receives:
+        template <class Node>
+        inline constexpr std::size_t nSummands = 1;
+        template <class Lhs, class Rhs>
+        inline constexpr std::size_t nSummands<LazySum<Lhs, Rhs>> =
+          nSummands<Lhs> + nSummands<Rhs>;
+
+        template <class Node>
+        inline constexpr std::size_t nFactors = 1;
+        template <class Lhs, class Rhs>
+        inline constexpr std::size_t nFactors<LazyProduct<Lhs, Rhs>> =
+          nFactors<Lhs> + nFactors<Rhs>;
+        template <class Arg>
+        inline constexpr std::size_t nFactors<LazyNegation<Arg>> = 1 + nFactors<Arg>;
+
+        inline constinit const FixedExpr<1> lazyMinusOne{-1};
+
+        // Leaves are referred to, other operands are simplified first and owned. The storage is
+        // reserved upfront, so that views of owned operands stay valid.
+        struct LazyOperands {
+            LazyOperands(std::size_t n, LocalAlloc<> allocator)
+                : owned{allocator}
+                , views{allocator}
+            {
+                owned.reserve(n);
+                views.reserve(n);
+            }
+
+            void append(ExprView<> leaf)
+            {
+                views.push_back(leaf);
+            }
+
+            template <LazyNode Node>
+            void append(const Node& node)
+            {
+                owned.push_back(simplify(node, owned.get_allocator()));
+                views.push_back(owned.back());
+            }
+
+            ScopedLocalVec<Expr> owned;
+            LocalVec<ExprView<>> views;
+        };
+
+        template <class Node>
+        void appendSummands(const Node& node, LazyOperands& ops)
+        {
+            ops.append(node);
+        }
+
+        template <class Lhs, class Rhs>
+        void appendSummands(const LazySum<Lhs, Rhs>& sum, LazyOperands& ops)
+        {
+            appendSummands(sum.lhs, ops);
+            appendSummands(sum.rhs, ops);
+        }
+
+        template <class Node>
+        void appendFactors(const Node& node, LazyOperands& ops)
+        {
+            ops.append(node);
+        }
+
+        template <class Lhs, class Rhs>
+        void appendFactors(const LazyProduct<Lhs, Rhs>& product, LazyOperands& ops)
+        {
+            appendFactors(product.lhs, ops);
+            appendFactors(product.rhs, ops);
+        }
+
+        template <class Arg>
+        void appendFactors(const LazyNegation<Arg>& negation, LazyOperands& ops)
+        {
+            ops.append(lazyMinusOne);
+            appendFactors(negation.arg, ops);
+        }
+
+        template <class Node>
+        Expr simplifyFactors(const Node& node, Expr::allocator_type allocator)
+        {
+            StackBuffer<1024> arena;
+            LazyOperands ops{nFactors<Node>, &arena};
+
+            appendFactors(node, ops);
+
+            return autoProduct(ops.views, allocator);
+        }
+    }
+
+    template <class Lhs, class Rhs>
+    Expr detail::simplify(const LazySum<Lhs, Rhs>& sum, Expr::allocator_type allocator)
+    {
+        StackBuffer<1024> arena;
+        LazyOperands ops{nSummands<LazySum<Lhs, Rhs>>, &arena};
+
+        appendSummands(sum, ops);
+
+        return autoSum(ops.views, allocator);
+    }
+
+    template <class Lhs, class Rhs>
+    Expr detail::simplify(const LazyProduct<Lhs, Rhs>& product, Expr::allocator_type allocator)
+    {
+        return simplifyFactors(product, allocator);
+    }
+
+    template <class Arg>
+    Expr detail::simplify(const LazyNegation<Arg>& negation, Expr::allocator_type allocator)
+    {
+        return simplifyFactors(negation, allocator);
+    }
+
+    template <class Arg>
+    Expr detail::simplify(const LazyReciprocal<Arg>& reciprocal, Expr::allocator_type allocator)
+    {
+        StackBuffer<512> arena;
+        LazyOperands ops{2, &arena};
+
+        ops.append(reciprocal.arg);
+        ops.append(lazyMinusOne);
+
+        return autoPower(ops.views[0], ops.views[1], allocator);
+    }
+
+    template <class Base, class Exp>
+    Expr detail::simplify(const LazyPower<Base, Exp>& power, Expr::allocator_type allocator)
+    {
+        StackBuffer<1024> arena;
+        LazyOperands ops{2, &arena};
+
+        ops.append(power.base);
+        ops.append(power.exp);
+
+        return autoPower(ops.views[0], ops.views[1], allocator);
+    }
+
+    template <LazyOperand Lhs, LazyOperand Rhs>
+    auto operator+(Lhs&& lhs, Rhs&& rhs)
+    {
+        return LazySum{detail::lazyOperand(std::forward<Lhs>(lhs)),
+          detail::lazyOperand(std::forward<Rhs>(rhs))};
+    }
+
+    template <LazyOperand Arg>
+    auto operator-(Arg&& arg)
+    {
+        return LazyNegation{detail::lazyOperand(std::forward<Arg>(arg))};
+    }
+
+    template <LazyOperand Lhs, LazyOperand Rhs>
+    auto operator-(Lhs&& lhs, Rhs&& rhs)
+    {
+        return LazySum{detail::lazyOperand(std::forward<Lhs>(lhs)), -std::forward<Rhs>(rhs)};
+    }
+
+    template <LazyOperand Lhs, LazyOperand Rhs>
+    auto operator*(Lhs&& lhs, Rhs&& rhs)
+    {
+        return LazyProduct{detail::lazyOperand(std::forward<Lhs>(lhs)),
+          detail::lazyOperand(std::forward<Rhs>(rhs))};
+    }
+
+    template <LazyOperand Lhs, LazyOperand Rhs>
+    auto operator/(Lhs&& lhs, Rhs&& rhs)
+    {
+        return LazyProduct{detail::lazyOperand(std::forward<Lhs>(lhs)),
+          LazyReciprocal{detail::lazyOperand(std::forward<Rhs>(rhs))}};
+    }
+
+    template <LazyOperand Base, LazyOperand Exp>
+    auto pow(Base&& base, Exp&& exp)
+    {
+        return LazyPower{detail::lazyOperand(std::forward<Base>(base)),
+          detail::lazyOperand(std::forward<Exp>(exp))};
+    }
+}
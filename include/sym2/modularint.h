@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+
+namespace sym2 {
+    // Integer modulo a prime, see Expr(ModularInt, allocator_type) for the supported moduli.
+    struct ModularInt {
+        std::uint64_t value;
+        std::uint64_t modulus;
+
+        friend bool operator==(const ModularInt&, const ModularInt&) = default;
+    };
+}
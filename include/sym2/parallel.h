@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include "functionview.h"
+
+namespace sym2 {
+    // Invokes fct(i) for all i in [0, n), distributed over a process-wide pool of worker threads
+    // and the calling thread, and blocks until all invocations have finished. The pool is created
+    // on first use with one worker per additional hardware thread. Indices are handed out
+    // dynamically, so fct must not make assumptions about the thread an index is processed on.
+    // Nested calls from within fct are fine, they are distributed over the same pool. When fct
+    // throws, indices that haven't been started are skipped, and the first exception is rethrown
+    // in the calling thread.
+    void parallelFor(std::size_t n, FunctionView<void(std::size_t)> fct);
+
+    // Number of threads parallelFor distributes work over, including the calling thread:
+    std::size_t concurrency();
+}
@@ -5,6 +5,7 @@
 #include <boost/hana/size.hpp>
 #include <boost/hana/unpack.hpp>
 #include <concepts>
+#include <cstdint>
 #include <functional>
 #include <type_traits>
 
@@ -149,31 +150,112 @@ namespace sym2 {
     template <class T>
     concept PredicateTag = PredicateOperand<T> || std::is_same_v<T, AnyFlag>;
 
-    namespace detail
-    {
+    namespace detail {
+        // Predicates that only depend on the classification of their single argument can opt in to
+        // be folded into one bitmask at compile time. This requires a specialisation with a
+        // static constexpr std::uint32_t member `mask`, and an ADL-found function
+        // matchesClassification(arg, mask) that performs the bit test for the argument.
+        template <auto fct>
+        struct ClassificationMask {};
+
+        template <class T>
+        struct Classification {
+            static constexpr bool foldable = false;
+            static constexpr std::uint32_t mask = 0;
+        };
+
+        template <auto fct, class... Arg>
+        requires requires { ClassificationMask<fct>::mask; }
+        struct Classification<Predicate<fct, Arg...>> {
+            static constexpr bool foldable = true;
+            static constexpr std::uint32_t mask = ClassificationMask<fct>::mask;
+        };
+
+        template <PredicateExprType Kind, class... T>
+        struct Classification<PredicateExpr<Kind, T...>> {
+            static constexpr bool foldable = (Classification<T>::foldable && ...);
+            static constexpr std::uint32_t mask = []() -> std::uint32_t {
+                if constexpr (!foldable)
+                    return 0;
+                else if constexpr (Kind == PredicateExprType::logicalNot)
+                    return (~Classification<T>::mask, ...);
+                else if constexpr (Kind == PredicateExprType::logicalAnd)
+                    return (~std::uint32_t{0} & ... & Classification<T>::mask);
+                else
+                    return (std::uint32_t{0} | ... | Classification<T>::mask);
+            }();
+        };
+
+        // The masks of all foldable operands of a logical and/or, combined with the logical
+        // operation (all bits set for and/no bits set for or if there are no foldable operands).
+        template <bool isAnd, class... T>
+        constexpr std::uint32_t combinedFoldableMask()
+        {
+            constexpr std::uint32_t neutral = isAnd ? ~std::uint32_t{0} : std::uint32_t{0};
+
+            if constexpr (isAnd)
+                return (neutral & ...
+                  & (Classification<T>::foldable ? Classification<T>::mask : neutral));
+            else
+                return (neutral | ...
+                  | (Classification<T>::foldable ? Classification<T>::mask : neutral));
+        }
+
         template <auto fct, class... Arg, class... Actual>
         auto invokeEval(const Predicate<fct, Arg...>&, Actual&&... arg)
         {
-            return std::invoke(fct, std::forward<Actual>(arg)...);
+            if constexpr (Classification<Predicate<fct, Arg...>>::foldable)
+                return matchesClassification(
+                  std::forward<Actual>(arg)..., ClassificationMask<fct>::mask);
+            else
+                return std::invoke(fct, std::forward<Actual>(arg)...);
+        }
+
+        template <PredicateExprType Kind, class... T, class... Arg>
+        auto invokeEval(const PredicateExpr<Kind, T...>& expr, Arg&&... arg);
+
+        // Used for the operands of a logical and/or, after the foldable operands have been tested
+        // in one go. Returns the neutral element of the logical operation for these.
+        template <bool neutral, class Operand, class... Arg>
+        bool invokeUnlessFoldable(const Operand& op, Arg&&... arg)
+        {
+            if constexpr (Classification<Operand>::foldable)
+                return neutral;
+            else
+                return invokeEval(op, std::forward<Arg>(arg)...);
         }
 
         template <PredicateExprType Kind, class... T, class... Arg>
         auto invokeEval(const PredicateExpr<Kind, T...>& expr, Arg&&... arg)
         {
-            if constexpr (Kind == PredicateExprType::leaf)
+            using Self = Classification<PredicateExpr<Kind, T...>>;
+            constexpr bool anyFoldable = (Classification<T>::foldable || ...);
+
+            if constexpr (Self::foldable)
+                return matchesClassification(std::forward<Arg>(arg)..., Self::mask);
+            else if constexpr (Kind == PredicateExprType::leaf)
                 return invokeEval(
                   boost::hana::at(expr.operands, boost::hana::int_c<0>), std::forward<Arg>(arg)...);
             else if constexpr (Kind == PredicateExprType::logicalNot)
                 return !invokeEval(
                   boost::hana::at(expr.operands, boost::hana::int_c<0>), std::forward<Arg>(arg)...);
-            else if constexpr (Kind == PredicateExprType::logicalAnd)
+            else if constexpr (Kind == PredicateExprType::logicalAnd) {
+                if constexpr (anyFoldable)
+                    if (!matchesClassification(arg..., combinedFoldableMask<true, T...>()))
+                        return false;
+
                 return boost::hana::unpack(expr.operands, [&arg...](auto&&... op) {
-                    return (... && invokeEval(op, std::forward<Arg>(arg)...));
+                    return (... && invokeUnlessFoldable<true>(op, std::forward<Arg>(arg)...));
                 });
-            else if constexpr (Kind == PredicateExprType::logicalOr)
+            } else if constexpr (Kind == PredicateExprType::logicalOr) {
+                if constexpr (anyFoldable)
+                    if (matchesClassification(arg..., combinedFoldableMask<false, T...>()))
+                        return true;
+
                 return boost::hana::unpack(expr.operands, [&arg...](auto&&... op) {
-                    return (... || invokeEval(op, std::forward<Arg>(arg)...));
+                    return (... || invokeUnlessFoldable<false>(op, std::forward<Arg>(arg)...));
                 });
+            }
         }
 
         template <PredicateOperand auto what>
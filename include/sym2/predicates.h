@@ -1,5 +1,6 @@
 #pragma once
 
+#include "blobtype.h"
 #include "exprview.h"
 #include "predicateexpr.h"
 
@@ -10,11 +11,13 @@ namespace sym2 {
     bool isInteger(ExprView<> e) noexcept;
     bool isRational(ExprView<> e) noexcept;
     bool isFloatingPoint(ExprView<> e) noexcept;
+    bool isModularInt(ExprView<> e) noexcept;
     bool isSmall(ExprView<> e) noexcept;
     bool isLarge(ExprView<> e) noexcept;
     bool isScalar(ExprView<> e) noexcept;
     bool isComposite(ExprView<> e) noexcept;
     bool isSymbol(ExprView<> e) noexcept;
+    bool isInternedSymbol(ExprView<> e) noexcept;
     bool isConstant(ExprView<> e) noexcept;
     bool isSum(ExprView<> e) noexcept;
     bool isProduct(ExprView<> e) noexcept;
@@ -24,17 +27,66 @@ namespace sym2 {
     bool isPositive(ExprView<> e) noexcept;
     bool isNegative(ExprView<> e) noexcept;
 
+    // Predicates that only depend on the header type are folded into a single bit test when used
+    // in PredicateExprs, see detail::ClassificationMask.
+    inline bool matchesClassification(ExprView<> e, TypeMask mask) noexcept
+    {
+        return hasTypeIn(e.get(), mask);
+    }
+
+    namespace detail {
+        template <TypeMask value>
+        struct TypeMaskConstant {
+            static constexpr TypeMask mask = value;
+        };
+
+        template <>
+        struct ClassificationMask<isNumber> : TypeMaskConstant<numberTypes> {};
+        template <>
+        struct ClassificationMask<isInteger> : TypeMaskConstant<integerTypes> {};
+        template <>
+        struct ClassificationMask<isRational> : TypeMaskConstant<rationalTypes> {};
+        template <>
+        struct ClassificationMask<isFloatingPoint> : TypeMaskConstant<floatingPointTypes> {};
+        template <>
+        struct ClassificationMask<isModularInt> : TypeMaskConstant<modularIntTypes> {};
+        template <>
+        struct ClassificationMask<isSmall> : TypeMaskConstant<smallTypes> {};
+        template <>
+        struct ClassificationMask<isLarge> : TypeMaskConstant<largeTypes> {};
+        template <>
+        struct ClassificationMask<isScalar> : TypeMaskConstant<scalarTypes> {};
+        template <>
+        struct ClassificationMask<isComposite> : TypeMaskConstant<compositeTypes> {};
+        template <>
+        struct ClassificationMask<isSymbol> : TypeMaskConstant<symbolTypes> {};
+        template <>
+        struct ClassificationMask<isInternedSymbol> : TypeMaskConstant<internedSymbolTypes> {};
+        template <>
+        struct ClassificationMask<isConstant> : TypeMaskConstant<constantTypes> {};
+        template <>
+        struct ClassificationMask<isSum> : TypeMaskConstant<sumTypes> {};
+        template <>
+        struct ClassificationMask<isProduct> : TypeMaskConstant<productTypes> {};
+        template <>
+        struct ClassificationMask<isPower> : TypeMaskConstant<powerTypes> {};
+        template <>
+        struct ClassificationMask<isFunction> : TypeMaskConstant<functionTypes> {};
+    }
+
     constexpr inline auto realDomain = predicate<isRealDomain>();
     constexpr inline auto complexDomain = predicate<isComplexDomain>();
     constexpr inline auto number = predicate<isNumber>();
     constexpr inline auto integer = predicate<isInteger>();
     constexpr inline auto rational = predicate<isRational>();
     constexpr inline auto floatingPoint = predicate<isFloatingPoint>();
+    constexpr inline auto modularInt = predicate<isModularInt>(); // See modularint.h
     constexpr inline auto small = predicate<isSmall>();
     constexpr inline auto large = predicate<isLarge>();
     constexpr inline auto composite = predicate<isComposite>(); // Sum, product, power, function.
     constexpr inline auto scalar = predicate<isScalar>(); // Not a composite
     constexpr inline auto symbol = predicate<isSymbol>();
+    constexpr inline auto internedSymbol = predicate<isInternedSymbol>(); // See symboltable.h
     constexpr inline auto constant = predicate<isConstant>();
     constexpr inline auto sum = predicate<isSum>();
     constexpr inline auto product = predicate<isProduct>();
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <optional>
 #include <span>
 #include <string_view>
 #include <utility>
@@ -32,6 +33,11 @@ namespace sym2 {
     ExprView<> secondOperand(ExprView<!small> e);
     std::size_t nOperands(ExprView<> e);
 
+    // Returns the index of the operand equal to term by binary search, i.e., with a logarithmic
+    // number of comparisons. The operands must be sorted by the order relation, as they are in
+    // simplified sums and products.
+    std::optional<std::uint16_t> findTerm(ExprView<sum || product> composite, ExprView<> term);
+
     // Returns the real part if the argument is a complex number, and the argument itself otherwise.
     ExprView<number> real(ExprView<number> n);
     // Returns the imaginary part if the argument is a complex number, and zero (backed by static
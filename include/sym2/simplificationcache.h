@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+#include "expr.h"
+#include "exprvector.h"
+#include "exprview.h"
+
+namespace sym2 {
+    // Size-bounded memoization of simplification results, keyed by the operation and the structural
+    // hash values of its operands. Hash collisions are resolved by comparing the operands. When the
+    // capacity is exhausted, the least recently used result is evicted. Operands and results are
+    // stored back to back in a buffer owned by the cache, which is compacted once evicted entries
+    // make up half of it. Results are only meaningful for simplifiers with the same dependencies,
+    // so a cache must not be shared between different order relations or numeric policies.
+    //
+    // A cache can be used by a single thread, or shared by several of them, in which case every
+    // member function is guarded by a mutex. Results are always copied out, so eviction or
+    // compaction never invalidates anything that has been handed out before.
+    class SimplificationCache {
+      public:
+        enum class Operation : std::uint8_t { sum, product, power };
+        enum class Sharing { singleThread, shared };
+
+        struct Statistics {
+            std::size_t hits = 0;
+            std::size_t misses = 0;
+            std::size_t evictions = 0;
+        };
+
+        // The capacity is the maximal number of cached results, a capacity of zero caches nothing:
+        explicit SimplificationCache(std::size_t capacity, Sharing sharing = Sharing::singleThread);
+        SimplificationCache(const SimplificationCache&) = delete;
+        SimplificationCache& operator=(const SimplificationCache&) = delete;
+        ~SimplificationCache() = default;
+
+        // Counts a hit or a miss. A hit marks the result as most recently used.
+        std::optional<Expr> lookup(
+          Operation op, std::span<const ExprView<>> ops, Expr::allocator_type allocator);
+        // Does nothing but marking the result as most recently used when it's already cached:
+        void insert(Operation op, std::span<const ExprView<>> ops, ExprView<> result);
+
+        std::size_t size() const;
+        std::size_t capacity() const noexcept;
+        Statistics statistics() const;
+        // Removes all results, statistics are reset separately:
+        void clear();
+        void resetStatistics();
+
+      private:
+        struct Entry {
+            std::size_t key;
+            Operation op;
+            std::size_t nOperands;
+            // Index of the first operand in the storage, the result follows the last operand:
+            std::size_t first;
+        };
+
+        using EntryList = std::list<Entry>;
+
+        std::unique_lock<std::mutex> lockIfShared() const;
+        EntryList::iterator find(std::size_t key, Operation op, std::span<const ExprView<>> ops);
+        void evictLeastRecentlyUsed();
+        void compact();
+
+        const std::size_t maxSize;
+        const Sharing sharing;
+        mutable std::mutex mutex;
+        // Front is the most recently used entry:
+        EntryList entries;
+        std::unordered_multimap<std::size_t, EntryList::iterator> index;
+        ExprVector storage;
+        std::vector<bool> alive;
+        std::size_t nDead = 0;
+        Statistics stats;
+    };
+}
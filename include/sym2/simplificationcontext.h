@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+
+namespace sym2 {
+    // Can be cancelled from any thread, while simplifications that refer to it are running.
+    class CancellationToken {
+      public:
+        void cancel() noexcept;
+        bool isCancelled() const noexcept;
+
+      private:
+        std::atomic<bool> cancelled{false};
+    };
+
+    // Thrown when a simplification runs out of its budget or is cancelled. Any intermediate result
+    // is discarded, the simplification has no effect other than the time and memory it consumed.
+    class SimplificationAborted : public std::runtime_error {
+      public:
+        enum class Reason { deadline, memoryBudget, recursionDepth, cancelled };
+
+        explicit SimplificationAborted(Reason reason);
+
+        Reason reason() const noexcept;
+
+      private:
+        Reason why;
+    };
+
+    struct SimplificationLimits {
+        std::optional<std::chrono::steady_clock::time_point> deadline = std::nullopt;
+        // Upper bound on the accumulated number of Blobs of all intermediate results. Exact
+        // rational powers are additionally charged with an estimate of their size before they are
+        // evaluated, so that a single huge power fails early instead of exhausting the memory.
+        std::optional<std::size_t> maxBlobs = std::nullopt;
+        // Upper bound on the nesting of the recursive merge and power routines. Merging operand
+        // lists recurses once per operand, so long sums and products can exhaust the stack when no
+        // limit is given. The depth is exact, it's not subject to the check interval:
+        std::optional<std::uint32_t> maxDepth = std::nullopt;
+        const CancellationToken* cancellation = nullptr;
+        // The deadline and the token are examined after this many recursive simplification
+        // steps, the memory budget is examined upon every intermediate result:
+        std::uint32_t checkInterval = 64;
+    };
+
+    // Budget of one or more consecutive simplifications, which is checked from within the
+    // recursive merge and power routines. Usage accumulates over all simplifications that share a
+    // context. A context must not be used by several threads at a time, but its cancellation token
+    // can be set from any thread.
+    class SimplificationContext {
+      public:
+        explicit SimplificationContext(SimplificationLimits limits);
+        // No deadline and no memory budget, the simplification stops when the token is cancelled:
+        explicit SimplificationContext(const CancellationToken& cancellation);
+        SimplificationContext(const SimplificationContext&) = delete;
+        SimplificationContext& operator=(const SimplificationContext&) = delete;
+        ~SimplificationContext() = default;
+
+        // Both throw SimplificationAborted when a limit is exceeded:
+        void step()
+        {
+            if (++nSteps % checkInterval == 0)
+                checkDeadlineAndCancellation();
+        }
+
+        void charge(std::size_t nBlobs)
+        {
+            nBlobs += nChargedBlobs;
+            nChargedBlobs = nBlobs < nChargedBlobs ? SIZE_MAX : nBlobs;
+
+            if (limits.maxBlobs && nChargedBlobs > *limits.maxBlobs)
+                throw SimplificationAborted{SimplificationAborted::Reason::memoryBudget};
+        }
+
+        // Marks one level of recursion until destruction, the constructor throws
+        // SimplificationAborted if it exceeds the maximal depth. Nothing is tracked for a nullptr:
+        class [[nodiscard]] Descent {
+          public:
+            explicit Descent(SimplificationContext* context)
+                : context{context}
+            {
+                if (context != nullptr)
+                    context->descend();
+            }
+            Descent(const Descent&) = delete;
+            Descent& operator=(const Descent&) = delete;
+            ~Descent()
+            {
+                if (context != nullptr)
+                    --context->depth;
+            }
+
+          private:
+            SimplificationContext* const context;
+        };
+
+        std::size_t steps() const noexcept;
+        std::size_t chargedBlobs() const noexcept;
+
+      private:
+        void descend()
+        {
+            if (limits.maxDepth && depth >= *limits.maxDepth)
+                throw SimplificationAborted{SimplificationAborted::Reason::recursionDepth};
+
+            ++depth;
+        }
+
+        void checkDeadlineAndCancellation() const;
+
+        const SimplificationLimits limits;
+        const std::uint32_t checkInterval;
+        std::size_t nSteps = 0;
+        std::size_t nChargedBlobs = 0;
+        std::uint32_t depth = 0;
+    };
+}
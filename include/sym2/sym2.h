@@ -1,19 +1,33 @@
 #pragma once
 
+#include "accumulator.h"
 #include "autosimpl.h"
+#include "blobvec.h"
 #include "compositetype.h"
 #include "constants.h"
 #include "domainflag.h"
 #include "doublefctptr.h"
 #include "eval.h"
 #include "expr.h"
+#include "exprbuilder.h"
+#include "exprvector.h"
 #include "exprview.h"
+#include "foldnumeric.h"
 #include "functionview.h"
 #include "get.h"
+#include "hash.h"
+#include "lazyexpr.h"
+#include "modularint.h"
+#include "parallel.h"
 #include "polynomial.h"
 #include "predicateexpr.h"
 #include "predicates.h"
 #include "printengine.h"
+#include "simplificationcache.h"
+#include "simplificationcontext.h"
 #include "query.h"
 #include "smallrational.h"
+#include "symboltable.h"
+#include "traversal.h"
 #include "violationhandler.h"
+#include "visit.h"
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace sym2 {
+    enum class SymbolId : std::uint32_t {};
+
+    // Opt-in, process-wide interning of symbol names. Symbols constructed from a SymbolId are
+    // stored in a single Blob, no matter how long their name is, and two of them compare equal by
+    // their ids. They are a different representation than symbols constructed from a name, so an
+    // interned symbol never compares equal to a non-interned one - code that opts in should do so
+    // consistently. Names are never removed, and the views returned by internedName stay valid
+    // until the process ends. All functions can be called concurrently, only internSymbol takes a
+    // lock.
+    //
+    // Returns the existing id if the name has been interned before. Throws std::invalid_argument
+    // for empty names, and std::length_error if all 2^32 ids are taken.
+    SymbolId internSymbol(std::string_view name);
+    // UB if the id wasn't returned by internSymbol:
+    std::string_view internedName(SymbolId id) noexcept;
+    // Equivalent to internedName(lhs) < internedName(rhs), UB for ids as above. Prefixes of the
+    // names are stored with them and compared first, the names are only read for common prefixes:
+    bool internedNameLess(SymbolId lhs, SymbolId rhs) noexcept;
+    std::size_t nInternedSymbols() noexcept;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include "exprview.h"
+
+namespace sym2 {
+    enum class TraversalOrder : bool { preorder, postorder };
+
+    // Range over all logical nodes of an expression tree, i.e., the root and all operands of sums,
+    // products, powers and functions, recursively. Scalars are leaves (parts of complex numbers or
+    // large rationals aren't visited separately). The traversal never allocates and never recurses.
+    // It keeps the ancestors of the current node in a fixed-size ring of frames. When a tree is
+    // deeper than that, frames that fell out of the ring are restored by descending from the root
+    // again, which is slower, but works for any depth. Subtrees shared through references are
+    // visited once per occurrence. The references on the path to the current node are recorded in
+    // a second ring, so that the descent can follow them. Only when there are more of them than
+    // fit into the ring, frames are restored by counting nodes, which is slower still. Iterators
+    // refer to the range object, which must hence outlive them.
+    class Traversal {
+      public:
+        class Iterator {
+          public:
+            using value_type = ExprView<>;
+            using difference_type = std::ptrdiff_t;
+
+            Iterator() = default;
+
+            ExprView<> operator*() const noexcept;
+            Iterator& operator++() noexcept;
+            void operator++(int) noexcept;
+
+            bool operator==(std::default_sentinel_t) const noexcept;
+
+          private:
+            friend class Traversal;
+
+            explicit Iterator(Traversal* traversal) noexcept;
+
+            Traversal* traversal = nullptr;
+        };
+
+        Traversal(ExprView<> root, TraversalOrder order) noexcept;
+
+        Iterator begin() noexcept;
+        std::default_sentinel_t end() const noexcept;
+
+      private:
+        struct Frame {
+            const Blob* parent;
+            // Next operand of the parent to be visited, and the past-the-end operand:
+            const Blob* next;
+            const Blob* last;
+        };
+
+        static constexpr std::size_t ringSize = 32;
+
+        void advance() noexcept;
+        void advancePreorder() noexcept;
+        void advancePostorder() noexcept;
+        void push(const Blob* parent, const Blob* next) noexcept;
+        void storeFrame(const Blob* parent, const Blob* next) noexcept;
+        Frame& top() noexcept;
+        void pop() noexcept;
+        const Blob* leftmostLeaf(const Blob* from) noexcept;
+        void restoreFrames() noexcept;
+        void restoreFramesByPosition() noexcept;
+        static std::size_t countNodes(const Blob* root) noexcept;
+
+        const Blob* root;
+        const Blob* current;
+        TraversalOrder order;
+        // True if the tree contains references to shared subtrees:
+        bool shared;
+        // Number of ancestors of the current node, and how many of them are in the ring:
+        std::size_t depth = 0;
+        std::size_t cached = 0;
+        // Number of nodes visited before the most recent one:
+        std::size_t position = 0;
+        // Number of references among the ancestors of the current node, and how many are stored:
+        std::size_t nCrossings = 0;
+        std::size_t cachedCrossings = 0;
+        std::array<Frame, ringSize> frames;
+        // The most recent of these references, i.e., the ones closest to the current node:
+        std::array<const Blob*, ringSize> crossings;
+    };
+
+    Traversal preorder(ExprView<> root) noexcept;
+    Traversal postorder(ExprView<> root) noexcept;
+}
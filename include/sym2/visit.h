@@ -0,0 +1,67 @@
+#pragma once
+
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include "blobtype.h"
+#include "exprview.h"
+#include "predicates.h"
+
+namespace sym2 {
+    template <class... Ts>
+    struct overloaded : Ts... {
+        using Ts::operator()...;
+    };
+
+    template <class... Ts>
+    overloaded(Ts...) -> overloaded<Ts...>;
+
+    template <class Handler>
+    using VisitResult = std::common_type_t<std::invoke_result_t<Handler&, ExprView<symbol>>,
+      std::invoke_result_t<Handler&, ExprView<constant>>,
+      std::invoke_result_t<Handler&, ExprView<number>>,
+      std::invoke_result_t<Handler&, ExprView<sum>>,
+      std::invoke_result_t<Handler&, ExprView<product>>,
+      std::invoke_result_t<Handler&, ExprView<power>>,
+      std::invoke_result_t<Handler&, ExprView<function>>>;
+
+    // Invokes the handler with e, tagged as one of symbol, constant, number, sum, product, power or
+    // function. Dispatch is a single switch over the header type instead of a chain of predicate
+    // checks. Tagged views convert into each other, so the handler should either accept all seven
+    // tags, or provide a generic fallback (e.g. a lambda taking auto), which is preferred over a
+    // converting overload. The results of all handlers must have a common type.
+    template <class Handler>
+    VisitResult<Handler> visit(ExprView<> e, Handler&& handler)
+    {
+        using Result = VisitResult<Handler>;
+
+        switch (headerType(e.get())) {
+            case Type::shortSymbol:
+            case Type::longSymbol:
+            case Type::internedSymbol:
+                return static_cast<Result>(std::invoke(handler, ExprView<symbol>{e}));
+            case Type::constant:
+                return static_cast<Result>(std::invoke(handler, ExprView<constant>{e}));
+            case Type::smallInt:
+            case Type::smallRational:
+            case Type::floatingPoint:
+            case Type::largeInt:
+            case Type::largeRational:
+            case Type::complexNumber:
+            case Type::modularInt:
+                return static_cast<Result>(std::invoke(handler, ExprView<number>{e}));
+            case Type::sum:
+                return static_cast<Result>(std::invoke(handler, ExprView<sum>{e}));
+            case Type::product:
+                return static_cast<Result>(std::invoke(handler, ExprView<product>{e}));
+            case Type::power:
+                return static_cast<Result>(std::invoke(handler, ExprView<power>{e}));
+            case Type::function:
+                return static_cast<Result>(std::invoke(handler, ExprView<function>{e}));
+            case Type::reference: // Resolved before being wrapped in ExprViews
+                break;
+        }
+
+        throw std::invalid_argument{"Can't visit unknown expression type"};
+    }
+}
@@ -0,0 +1,181 @@
+
+#include "sym2/accumulator.h"
+#include <algorithm>
+#include <optional>
+#include <span>
+#include "numberarithmetic.h"
+#include "orderrelation.h"
+#include "sym2/autosimpl.h"
+#include "sym2/hash.h"
+#include "sym2/operandsview.h"
+#include "sym2/predicates.h"
+#include "sym2/query.h"
+
+namespace sym2 {
+    namespace {
+        // Returns the index of the stored expression for which the predicate is true, if any:
+        template <class Indices, class Predicate>
+        std::optional<std::uint32_t> findStored(const Indices& indices, std::size_t hashValue,
+          const ExprVector& stored, Predicate&& pred)
+        {
+            const auto [first, last] = indices.equal_range(hashValue);
+
+            for (auto candidate = first; candidate != last; ++candidate)
+                if (pred(stored[candidate->second]))
+                    return candidate->second;
+
+            return std::nullopt;
+        }
+
+        // Non-constant terms are stored as products, or as the single operand they consist of:
+        OperandsView asTerm(ExprView<> e) noexcept
+        {
+            return is<product>(e) ? OperandsView::operandsOf(e) : OperandsView::singleOperand(e);
+        }
+
+        // Operands must be simplified and can't be combined any further, so sorting them results
+        // in a canonical sum or product:
+        Expr sortedComposite(CompositeType composite, std::span<const Expr> ops,
+          Expr::allocator_type allocator)
+        {
+            LocalVec<ExprView<>> sorted{ops.begin(), ops.end(), allocator};
+
+            sortByOrder(sorted, allocator);
+
+            if (sorted.empty())
+                return Expr{composite == CompositeType::sum ? 0 : 1, allocator};
+            else if (sorted.size() == 1)
+                return Expr{sorted.front(), allocator};
+            else
+                return Expr{composite, sorted, allocator};
+        }
+    }
+}
+
+sym2::SumAccumulator::SumAccumulator(allocator_type allocator)
+    : constant{0, allocator}
+    , terms{allocator}
+    , coefficients{allocator}
+    , indices{allocator}
+{}
+
+void sym2::SumAccumulator::add(ExprView<> summand)
+{
+    NumberArithmetic numerics{terms.get_allocator()};
+
+    if (is<sum>(summand)) {
+        for (const ExprView<> op : OperandsView::operandsOf(summand))
+            add(op);
+        return;
+    } else if (is<number>(summand)) {
+        constant = numerics.add(constant, summand);
+        return;
+    }
+
+    const ConstAndTerm split = splitConstTerm(summand);
+    const std::size_t hashValue = hash(split.term);
+    const auto equalTerm = [&split](ExprView<> term) { return asTerm(term) == split.term; };
+
+    if (const auto index = findStored(indices, hashValue, terms, equalTerm)) {
+        coefficients[*index] = numerics.add(coefficients[*index], split.constant);
+        return;
+    }
+
+    if (split.term.size() == 1)
+        terms.push_back(split.term.front());
+    else {
+        const LocalVec<ExprView<>> ops{split.term.begin(), split.term.end(), terms.get_allocator()};
+
+        terms.push_back(Expr{CompositeType::product, ops, terms.get_allocator()});
+    }
+
+    coefficients.emplace_back(split.constant);
+    indices.emplace(hashValue, static_cast<std::uint32_t>(terms.size() - 1));
+}
+
+sym2::Expr sym2::SumAccumulator::finalize(Expr::allocator_type allocator) const
+{
+    ScopedLocalVec<Expr> summands{terms.get_allocator()};
+
+    summands.reserve(terms.size() + 1);
+
+    if (constant != 0_ex)
+        summands.emplace_back(constant);
+
+    for (std::size_t i = 0; i < terms.size(); ++i)
+        if (coefficients[i] == 1_ex)
+            summands.emplace_back(terms[i]);
+        else if (coefficients[i] != 0_ex)
+            summands.push_back(autoProduct(coefficients[i], terms[i], terms.get_allocator()));
+
+    return sortedComposite(CompositeType::sum, summands, allocator);
+}
+
+sym2::ProductAccumulator::ProductAccumulator(allocator_type allocator)
+    : coefficient{1, allocator}
+    , bases{allocator}
+    , exponents{allocator}
+    , indices{allocator}
+{}
+
+void sym2::ProductAccumulator::multiply(ExprView<> factor)
+{
+    if (is<product>(factor)) {
+        for (const ExprView<> op : OperandsView::operandsOf(factor))
+            multiply(op);
+        return;
+    } else if (is<number>(factor)) {
+        coefficient = NumberArithmetic{bases.get_allocator()}.multiply(coefficient, factor);
+        return;
+    }
+
+    const BaseExp split = splitAsPower(factor);
+    const std::size_t hashValue = hash(split.base);
+    const auto equalBase = [&split](ExprView<> base) { return base == split.base; };
+
+    if (const auto index = findStored(indices, hashValue, bases, equalBase)) {
+        Expr& exponent = exponents[*index];
+
+        exponent = autoSum(exponent, split.exponent, bases.get_allocator());
+        return;
+    }
+
+    bases.push_back(split.base);
+    exponents.emplace_back(split.exponent);
+    indices.emplace(hashValue, static_cast<std::uint32_t>(bases.size() - 1));
+}
+
+sym2::Expr sym2::ProductAccumulator::finalize(Expr::allocator_type allocator) const
+{
+    NumberArithmetic numerics{bases.get_allocator()};
+    Expr numeric{coefficient, bases.get_allocator()};
+    ScopedLocalVec<Expr> factors{bases.get_allocator()};
+    // Powers with equal bases are combined, but e.g. (a*b)^(1/2)*(a*b)^(1/2) results in a
+    // product, the operands of which can interfere with others:
+    bool canonical = true;
+
+    factors.reserve(bases.size() + 1);
+
+    for (std::size_t i = 0; i < bases.size(); ++i) {
+        Expr power = autoPower(bases[i], exponents[i], bases.get_allocator());
+
+        if (is<number>(power))
+            numeric = numerics.multiply(numeric, power);
+        else {
+            canonical = canonical && !is<product>(power);
+            factors.push_back(std::move(power));
+        }
+    }
+
+    if (numeric == 0_ex)
+        return Expr{0, allocator};
+    else if (numeric != 1_ex)
+        factors.push_back(std::move(numeric));
+
+    if (canonical)
+        return sortedComposite(CompositeType::product, factors, allocator);
+
+    const LocalVec<ExprView<>> ops{factors.begin(), factors.end(), bases.get_allocator()};
+
+    return autoProduct(ops, allocator);
+}
@@ -1,69 +1,179 @@
 
 #include "sym2/autosimpl.h"
-#include <functional>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
 #include <vector>
 #include "cohenautosimpl.h"
-#include "numberarithmetic.h"
 #include "orderrelation.h"
 #include "sym2/get.h"
+#include "sym2/operandsview.h"
+#include "sym2/parallel.h"
 #include "sym2/predicates.h"
+#include "sym2/query.h"
+#include "sym2/traversal.h"
 
 namespace sym2 {
-    template <class NumericAddFct, class NumericMultiplyFct>
-    struct SimplificationBundle {
-        Expr::allocator_type allocator;
-        NumericAddFct numericAdd;
-        NumericMultiplyFct numericMultiply;
-
-        CohenAutoSimpl::Dependencies callbacks{orderLessThan, numericAdd, numericMultiply};
-        CohenAutoSimpl simplifier{callbacks, allocator};
-    };
+    using OrderLessThanFctPtr = bool (*)(ExprView<>, ExprView<>);
+
+    OrderLessThanFctPtr orderLessThanFor(SimplificationMode mode)
+    {
+        switch (mode) {
+            case SimplificationMode::canonical:
+                return orderLessThan;
+            case SimplificationMode::fastIntermediate:
+                return fastOrderLessThan;
+        }
+
+        assert(false && "Unhandled simplification mode");
+        return orderLessThan;
+    }
+
+    template <OrderLessThanFctPtr lessThan, class Step>
+    Expr runStaticSimplifier(SimplificationCache* cache, SimplificationContext* context,
+      Expr::allocator_type allocator, Step& step)
+    {
+        StackBuffer<1024> arena;
+        BasicCohenAutoSimpl<StaticDependencies<lessThan>> simplifier{
+          StaticDependencies<lessThan>{&arena}, &arena, cache, context};
+        const Expr result = step(simplifier);
+
+        return Expr{result, allocator};
+    }
+
+    // Invokes the step with a simplifier whose dependencies are known at compile time. The mode is
+    // the only thing that's dispatched at runtime, once per call.
+    template <class Step>
+    Expr runSimplifier(SimplificationMode mode, SimplificationCache* cache,
+      Expr::allocator_type allocator, Step&& step)
+    {
+        switch (mode) {
+            case SimplificationMode::canonical:
+                return runStaticSimplifier<orderLessThan>(cache, nullptr, allocator, step);
+            case SimplificationMode::fastIntermediate:
+                return runStaticSimplifier<fastOrderLessThan>(cache, nullptr, allocator, step);
+        }
+
+        assert(false && "Unhandled simplification mode");
+        return runStaticSimplifier<orderLessThan>(cache, nullptr, allocator, step);
+    }
+
+    template <class Simplifier>
+    Expr simplifyJob(Simplifier& simplifier, ExprView<> e, BatchOperation op,
+      Expr::allocator_type allocator)
+    {
+        if (op == BatchOperation::power)
+            return is<power>(e) ? simplifier.simplifyPower(firstOperand(e), secondOperand(e)) :
+                                  Expr{e, allocator};
 
-    auto createSimplificationBundle(Expr::allocator_type allocator)
+        const bool isComposite = op == BatchOperation::sum ? is<sum>(e) : is<product>(e);
+        const OperandsView operands =
+          isComposite ? OperandsView::operandsOf(e) : OperandsView::singleOperand(e);
+        const LocalVec<ExprView<>> ops{operands.begin(), operands.end(), allocator};
+
+        return op == BatchOperation::sum ? simplifier.simplifySum(ops) :
+                                           simplifier.simplifyProduct(ops);
+    }
+
+    bool hasFloatingPointNumbers(ExprView<> e)
     {
-        NumberArithmetic numerics{allocator};
+        for (const ExprView<> node : Traversal{e, TraversalOrder::preorder})
+            if (is<number>(node) && isOneOf<floatingPoint>(real(node), imag(node)))
+                return true;
 
-        return SimplificationBundle{allocator, std::bind_front(&NumberArithmetic::add, numerics),
-          std::bind_front(&NumberArithmetic::multiply, numerics)};
+        return false;
+    }
+
+    // Merging such a power with another one of the same base can yield a number or a product,
+    // e.g. sqrt(2)*sqrt(2) = 2 or (a*b)^(1/2)*(a*b)^(1/2) = a*b, which interferes with factors
+    // that have already been merged:
+    bool isPowerOfNumberOrProduct(ExprView<> e)
+    {
+        return is<power>(e) && is < number || product > (splitAsPower(e).base);
+    }
+
+    bool hasPowerOfNumberOrProductFactor(ExprView<> e)
+    {
+        if (!is<product>(e))
+            return isPowerOfNumberOrProduct(e);
+
+        const OperandsView factors = OperandsView::operandsOf(e);
+
+        return std::any_of(factors.begin(), factors.end(), isPowerOfNumberOrProduct);
+    }
+
+    // The operation is invoked with a span of operands to simplify a chunk, and with two partial
+    // results to merge them, plus an allocator in both cases.
+    template <class Operation>
+    Expr simplifyChunked(std::span<const ExprView<>> ops, std::size_t chunkSize,
+      Expr::allocator_type allocator, Operation simplify)
+    {
+        // Partial results are assigned from different threads, so they must not share an arena:
+        const Expr::allocator_type heap{};
+        const std::size_t nChunks = (ops.size() + chunkSize - 1) / chunkSize;
+        ScopedLocalVec<Expr> partials{heap};
+
+        partials.reserve(nChunks);
+
+        for (std::size_t i = 0; i < nChunks; ++i)
+            partials.emplace_back(0);
+
+        parallelFor(nChunks, [&](std::size_t i) {
+            const std::size_t first = i * chunkSize;
+            const std::size_t count = std::min(chunkSize, ops.size() - first);
+
+            partials[i] = simplify(ops.subspan(first, count), heap);
+        });
+
+        while (partials.size() > 1) {
+            const std::size_t nPairs = partials.size() / 2;
+
+            parallelFor(nPairs, [&](std::size_t i) {
+                partials[2 * i] = simplify(partials[2 * i], partials[2 * i + 1], heap);
+            });
+
+            for (std::size_t i = 2; i < partials.size(); i += 2)
+                partials[i / 2] = std::move(partials[i]);
+
+            const auto nRemaining = static_cast<std::ptrdiff_t>((partials.size() + 1) / 2);
+            partials.erase(partials.begin() + nRemaining, partials.end());
+        }
+
+        return Expr{partials.front(), allocator};
     }
 }
 
 sym2::Expr sym2::autoSum(ExprView<> lhs, ExprView<> rhs, Expr::allocator_type allocator)
 {
-    return autoSum({{lhs, rhs}}, allocator);
+    return autoSum({{lhs, rhs}}, SimplificationMode::canonical, allocator);
 }
 
 sym2::Expr sym2::autoSum(std::span<const ExprView<>> ops, Expr::allocator_type allocator)
 {
-    StackBuffer<1024> arena;
-    auto bundle = createSimplificationBundle(&arena);
-    const Expr result = bundle.simplifier.simplifySum(ops);
-
-    return Expr{result, allocator};
+    return autoSum(ops, SimplificationMode::canonical, allocator);
 }
 
 sym2::Expr sym2::autoSum(std::initializer_list<ExprView<>> ops, Expr::allocator_type allocator)
 {
-    return autoSum(std::span<const ExprView<>>{ops}, allocator);
+    return autoSum(std::span<const ExprView<>>{ops}, SimplificationMode::canonical, allocator);
 }
 
 sym2::Expr sym2::autoProduct(ExprView<> lhs, ExprView<> rhs, Expr::allocator_type allocator)
 {
-    return autoProduct({{lhs, rhs}}, allocator);
+    return autoProduct({{lhs, rhs}}, SimplificationMode::canonical, allocator);
 }
 
 sym2::Expr sym2::autoProduct(std::span<const ExprView<>> ops, Expr::allocator_type allocator)
 {
-    StackBuffer<1024> arena;
-    auto bundle = createSimplificationBundle(&arena);
-    const Expr result = bundle.simplifier.simplifyProduct(ops);
-
-    return Expr{result, allocator};
+    return autoProduct(ops, SimplificationMode::canonical, allocator);
 }
 
 sym2::Expr sym2::autoProduct(std::initializer_list<ExprView<>> ops, Expr::allocator_type allocator)
 {
-    return autoProduct(std::span<const ExprView<>>{ops}, allocator);
+    return autoProduct(std::span<const ExprView<>>{ops}, SimplificationMode::canonical, allocator);
 }
 
 sym2::Expr sym2::autoMinus(ExprView<> arg, Expr::allocator_type allocator)
@@ -73,11 +183,7 @@ sym2::Expr sym2::autoMinus(ExprView<> arg, Expr::allocator_type allocator)
 
 sym2::Expr sym2::autoPower(ExprView<> base, ExprView<> exp, Expr::allocator_type allocator)
 {
-    StackBuffer<1024> arena;
-    auto bundle = createSimplificationBundle(&arena);
-    const Expr result = bundle.simplifier.simplifyPower(base, exp);
-
-    return Expr{result, allocator};
+    return autoPower(base, exp, SimplificationMode::canonical, allocator);
 }
 
 sym2::Expr sym2::autoOneOver(ExprView<> arg, Expr::allocator_type allocator)
@@ -90,3 +196,273 @@ sym2::Expr sym2::autoComplex(ExprView<> real, ExprView<> imag, Expr::allocator_t
     // TODO
     return Expr{CompositeType::complexNumber, real, imag, allocator};
 }
+
+sym2::Expr sym2::autoSum(
+  ExprView<> lhs, ExprView<> rhs, SimplificationMode mode, Expr::allocator_type allocator)
+{
+    return autoSum({{lhs, rhs}}, mode, allocator);
+}
+
+sym2::Expr sym2::autoSum(
+  std::span<const ExprView<>> ops, SimplificationMode mode, Expr::allocator_type allocator)
+{
+    return runSimplifier(mode, nullptr, allocator,
+      [ops](auto& simplifier) { return simplifier.simplifySum(ops); });
+}
+
+sym2::Expr sym2::autoSum(std::initializer_list<ExprView<>> ops, SimplificationMode mode,
+  Expr::allocator_type allocator)
+{
+    return autoSum(std::span<const ExprView<>>{ops}, mode, allocator);
+}
+
+sym2::Expr sym2::autoProduct(
+  ExprView<> lhs, ExprView<> rhs, SimplificationMode mode, Expr::allocator_type allocator)
+{
+    return autoProduct({{lhs, rhs}}, mode, allocator);
+}
+
+sym2::Expr sym2::autoProduct(
+  std::span<const ExprView<>> ops, SimplificationMode mode, Expr::allocator_type allocator)
+{
+    return runSimplifier(mode, nullptr, allocator,
+      [ops](auto& simplifier) { return simplifier.simplifyProduct(ops); });
+}
+
+sym2::Expr sym2::autoProduct(std::initializer_list<ExprView<>> ops, SimplificationMode mode,
+  Expr::allocator_type allocator)
+{
+    return autoProduct(std::span<const ExprView<>>{ops}, mode, allocator);
+}
+
+sym2::Expr sym2::autoPower(
+  ExprView<> base, ExprView<> exp, SimplificationMode mode, Expr::allocator_type allocator)
+{
+    return runSimplifier(mode, nullptr, allocator,
+      [base, exp](auto& simplifier) { return simplifier.simplifyPower(base, exp); });
+}
+
+sym2::Expr sym2::autoSum(
+  ExprView<> lhs, ExprView<> rhs, SimplificationCache& cache, Expr::allocator_type allocator)
+{
+    return autoSum({{lhs, rhs}}, cache, allocator);
+}
+
+sym2::Expr sym2::autoSum(
+  std::span<const ExprView<>> ops, SimplificationCache& cache, Expr::allocator_type allocator)
+{
+    return runSimplifier(SimplificationMode::canonical, &cache, allocator,
+      [ops](auto& simplifier) { return simplifier.simplifySum(ops); });
+}
+
+sym2::Expr sym2::autoSum(std::initializer_list<ExprView<>> ops, SimplificationCache& cache,
+  Expr::allocator_type allocator)
+{
+    return autoSum(std::span<const ExprView<>>{ops}, cache, allocator);
+}
+
+sym2::Expr sym2::autoProduct(
+  ExprView<> lhs, ExprView<> rhs, SimplificationCache& cache, Expr::allocator_type allocator)
+{
+    return autoProduct({{lhs, rhs}}, cache, allocator);
+}
+
+sym2::Expr sym2::autoProduct(
+  std::span<const ExprView<>> ops, SimplificationCache& cache, Expr::allocator_type allocator)
+{
+    return runSimplifier(SimplificationMode::canonical, &cache, allocator,
+      [ops](auto& simplifier) { return simplifier.simplifyProduct(ops); });
+}
+
+sym2::Expr sym2::autoProduct(std::initializer_list<ExprView<>> ops, SimplificationCache& cache,
+  Expr::allocator_type allocator)
+{
+    return autoProduct(std::span<const ExprView<>>{ops}, cache, allocator);
+}
+
+sym2::Expr sym2::autoPower(
+  ExprView<> base, ExprView<> exp, SimplificationCache& cache, Expr::allocator_type allocator)
+{
+    return runSimplifier(SimplificationMode::canonical, &cache, allocator,
+      [base, exp](auto& simplifier) { return simplifier.simplifyPower(base, exp); });
+}
+
+sym2::Expr sym2::autoSum(ExprView<> lhs, ExprView<> rhs, SimplificationContext& context,
+  Expr::allocator_type allocator)
+{
+    return autoSum({{lhs, rhs}}, context, allocator);
+}
+
+sym2::Expr sym2::autoSum(std::span<const ExprView<>> ops, SimplificationContext& context,
+  Expr::allocator_type allocator)
+{
+    const auto step = [ops](auto& simplifier) { return simplifier.simplifySum(ops); };
+
+    return runStaticSimplifier<orderLessThan>(nullptr, &context, allocator, step);
+}
+
+sym2::Expr sym2::autoSum(std::initializer_list<ExprView<>> ops, SimplificationContext& context,
+  Expr::allocator_type allocator)
+{
+    return autoSum(std::span<const ExprView<>>{ops}, context, allocator);
+}
+
+sym2::Expr sym2::autoProduct(ExprView<> lhs, ExprView<> rhs, SimplificationContext& context,
+  Expr::allocator_type allocator)
+{
+    return autoProduct({{lhs, rhs}}, context, allocator);
+}
+
+sym2::Expr sym2::autoProduct(std::span<const ExprView<>> ops, SimplificationContext& context,
+  Expr::allocator_type allocator)
+{
+    const auto step = [ops](auto& simplifier) { return simplifier.simplifyProduct(ops); };
+
+    return runStaticSimplifier<orderLessThan>(nullptr, &context, allocator, step);
+}
+
+sym2::Expr sym2::autoProduct(std::initializer_list<ExprView<>> ops,
+  SimplificationContext& context, Expr::allocator_type allocator)
+{
+    return autoProduct(std::span<const ExprView<>>{ops}, context, allocator);
+}
+
+sym2::Expr sym2::autoPower(ExprView<> base, ExprView<> exp, SimplificationContext& context,
+  Expr::allocator_type allocator)
+{
+    const auto step = [base, exp](auto& simplifier) {
+        return simplifier.simplifyPower(base, exp);
+    };
+
+    return runStaticSimplifier<orderLessThan>(nullptr, &context, allocator, step);
+}
+
+sym2::Expr sym2::autoSum(std::span<const ExprView<>> ops, ParallelSimplification policy,
+  Expr::allocator_type allocator)
+{
+    const std::size_t chunkSize = std::max<std::size_t>(policy.chunkSize, 1);
+
+    if (ops.size() < policy.minOperands || ops.size() <= chunkSize
+      || std::any_of(ops.begin(), ops.end(), hasFloatingPointNumbers))
+        return autoSum(ops, allocator);
+
+    return simplifyChunked(ops, chunkSize, allocator,
+      [](const auto&... args) { return autoSum(args...); });
+}
+
+sym2::Expr sym2::autoProduct(std::span<const ExprView<>> ops, ParallelSimplification policy,
+  Expr::allocator_type allocator)
+{
+    const std::size_t chunkSize = std::max<std::size_t>(policy.chunkSize, 1);
+
+    if (ops.size() < policy.minOperands || ops.size() <= chunkSize
+      || std::any_of(ops.begin(), ops.end(), hasFloatingPointNumbers)
+      || std::any_of(ops.begin(), ops.end(), hasPowerOfNumberOrProductFactor))
+        return autoProduct(ops, allocator);
+
+    return simplifyChunked(ops, chunkSize, allocator,
+      [](const auto&... args) { return autoProduct(args...); });
+}
+
+void sym2::simplifyBatch(std::span<const ExprView<>> in, BatchOperation op, ExprVector& out)
+{
+    constexpr std::size_t chunkSize = 64;
+    // Room for results of 16 Blobs on average, larger ones continue on the heap:
+    constexpr std::size_t nChunkBlobs = 16 * chunkSize;
+    using ChunkArena = StackBuffer<nChunkBlobs * sizeof(Blob) + chunkSize * sizeof(std::uint32_t)
+      + 2 * alignof(std::max_align_t)>;
+    const std::size_t nChunks = (in.size() + chunkSize - 1) / chunkSize;
+    // Chunks are filled by different threads, so each of them gets its own arena:
+    const auto arenas = std::make_unique<ChunkArena[]>(nChunks);
+    LocalVec<ExprVector> chunks{LocalAlloc<ExprVector>{}};
+
+    chunks.reserve(nChunks);
+
+    for (std::size_t i = 0; i < nChunks; ++i)
+        chunks.emplace_back(&arenas[i]);
+
+    parallelFor(nChunks, [&](std::size_t i) {
+        const std::size_t first = i * chunkSize;
+        const std::size_t last = std::min(first + chunkSize, in.size());
+
+        chunks[i].reserve(last - first, nChunkBlobs);
+
+        for (std::size_t j = first; j < last; ++j) {
+            // A fresh arena per input, as its temporaries aren't released in stack order:
+            StackBuffer<4096> arena;
+            BasicCohenAutoSimpl<StaticDependencies<orderLessThan>> simplifier{
+              StaticDependencies<orderLessThan>{&arena}, &arena};
+            const Expr result = simplifyJob(simplifier, in[j], op, &arena);
+
+            chunks[i].push_back(result);
+        }
+    });
+
+    out.append(chunks);
+}
+
+sym2::Expr sym2::reorder(ExprView<> e, SimplificationMode mode, Expr::allocator_type allocator)
+{
+    if (!is<composite>(e))
+        return Expr{e, allocator};
+
+    StackBuffer<1024> arena;
+    const OperandsView operands = OperandsView::operandsOf(e);
+    ScopedLocalVec<Expr> reordered{&arena};
+
+    reordered.reserve(operands.size());
+
+    for (const ExprView<> op : operands)
+        reordered.push_back(reorder(op, mode, &arena));
+
+    LocalVec<ExprView<>> ops{reordered.begin(), reordered.end(), &arena};
+
+    if (is < sum || product > (e)) {
+        if (mode == SimplificationMode::canonical)
+            sortByOrder(ops, &arena);
+        else
+            std::sort(ops.begin(), ops.end(), orderLessThanFor(mode));
+
+        return Expr{is<sum>(e) ? CompositeType::sum : CompositeType::product, ops, allocator};
+    } else if (is<power>(e))
+        return Expr{CompositeType::power, ops[0], ops[1], allocator};
+    else if (ops.size() == 1)
+        return Expr{get<std::string_view>(e), ops[0], get<UnaryDoubleFctPtr>(e), allocator};
+
+    assert(ops.size() == 2);
+
+    return Expr{get<std::string_view>(e), ops[0], ops[1], get<BinaryDoubleFctPtr>(e), allocator};
+}
+
+sym2::Expr sym2::canonicalize(ExprView<> e, Expr::allocator_type allocator)
+{
+    return reorder(e, SimplificationMode::canonical, allocator);
+}
+
+sym2::Expr sym2::autoReplaceOperand(ExprView<> root, std::span<const std::uint16_t> path,
+  ExprView<> replacement, Expr::allocator_type allocator)
+{
+    if (path.empty())
+        return Expr{replacement, allocator};
+    else if (path.front() >= nOperands(root))
+        throw std::out_of_range{"Operand path doesn't exist in the expression"};
+
+    const std::uint16_t index = path.front();
+    const Expr operand =
+      autoReplaceOperand(nthOperand(root, index), path.subspan(1), replacement, allocator);
+
+    if (is<function>(root))
+        return replaceOperand(root, {&index, 1}, operand, allocator);
+
+    const OperandsView operands = OperandsView::operandsOf(root);
+    LocalVec<ExprView<>> ops{operands.begin(), operands.end(), allocator};
+
+    ops[index] = operand;
+
+    if (is<sum>(root))
+        return autoSum(ops, allocator);
+    else if (is<product>(root))
+        return autoProduct(ops, allocator);
+    else
+        return autoPower(ops[0], ops[1], allocator);
+}
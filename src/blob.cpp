@@ -2,33 +2,19 @@
 #include "sym2/blob.h"
 #include <algorithm>
 #include <bit>
+#include <boost/container_hash/hash.hpp>
 #include <boost/iterator/function_output_iterator.hpp>
 #include <cassert>
+#include <concepts>
 #include <cstring>
+#include <functional>
 #include <limits>
-#include <numeric>
+#include <optional>
 #include <stdexcept>
 #include <type_traits>
+#include <unordered_map>
 
 namespace sym2 {
-    enum class Type : std::uint8_t {
-        shortSymbol = 1, // Not starting at 0 helps pretty-printing in a debugger
-        longSymbol,
-        constant,
-        smallInt,
-        smallRational,
-        floatingPoint,
-        largeInt,
-        // A large rational can still have one small/inplace integer (either numerator
-        // or denominator):
-        largeRational,
-        complexNumber,
-        sum,
-        product,
-        power,
-        function
-    };
-
     // There are two options for 8 byte data blobs to capture all desired leaf and composite types.
     // These constraints are subjet to the desired size - larger blob types could circumvent them
     // easily, but we stick to 8 bytes for the sake of a minimal memory footprint and optimal cache
@@ -60,6 +46,7 @@ namespace sym2 {
         char largeSymbolData[8]; // More of a logical placeholder - will rarely be
                                  // used explicitly
         std::uint64_t largeIntData;
+        std::uint64_t modularData; // Value or modulus of a modular integer
         double inexact;
         double (*unaryFctEval)(double);
         double (*binaryFctEval)(double, double);
@@ -74,14 +61,17 @@ namespace sym2 {
             union InplaceDataOrReference {
                 char name[4];
                 SmallRational exact;
+                SymbolId symbol;
                 struct Referral {
                     std::uint16_t offset;
                     std::uint16_t extentOrOperands;
                 } location;
+                // Signed distance from a reference to the header it refers to:
+                std::int32_t distance;
             } main;
         } classified;
 
-        static constexpr std::size_t smallSymbolNameLength = 6;
+        static constexpr std::size_t smallSymbolNameLength = detail::smallSymbolNameLength;
     };
 
     static_assert(std::is_trivial_v<Blob>);
@@ -90,6 +80,13 @@ namespace sym2 {
     static_assert(sizeof(Blob) == sizeof(double));
     static_assert(alignof(Blob) == alignof(double));
     static_assert(alignof(Blob) == alignof(DataLayout));
+    // The classifier must be the first byte, see headerType, and the remaining ones must match
+    // detail::header, which constructs headers without the union:
+    static_assert(offsetof(DataLayout::SelfDescribing, classifier) == 0);
+    static_assert(offsetof(DataLayout::SelfDescribing, pre0) == 1);
+    static_assert(offsetof(DataLayout::SelfDescribing, pre1) == 2);
+    static_assert(offsetof(DataLayout::SelfDescribing, pre2) == 3);
+    static_assert(offsetof(DataLayout::SelfDescribing, main) == 4);
 
     namespace {
         Blob toBlob(const DataLayout data)
@@ -114,33 +111,65 @@ namespace sym2 {
 
         Type type(const Blob header) noexcept
         {
-            return fromBlob(header).classified.classifier;
+            return headerType(&header);
         }
 
         bool isSelfContainedHeader(const Blob header) noexcept
         {
             switch (type(header)) {
                 case Type::shortSymbol:
+                case Type::internedSymbol:
                 case Type::smallInt:
                 case Type::smallRational:
+                case Type::reference:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        // Sums, products, powers and functions use the first of the three bytes for summary flags,
+        // and hence have only 16 bits left for the extent.
+        bool hasSummaryByte(const Blob header) noexcept
+        {
+            switch (type(header)) {
+                case Type::sum:
+                case Type::product:
+                case Type::power:
+                case Type::function:
                     return true;
                 default:
                     return false;
             }
         }
 
+        std::uint8_t unsignedByte(const char c) noexcept
+        {
+            // Bytes must be read as unsigned, sign extension would corrupt the values otherwise.
+            return static_cast<std::uint8_t>(c);
+        }
+
         std::uint32_t extentFromBytes(const DataLayout data)
         {
-            return data.classified.pre0.byte << 16 | data.classified.pre1 << 8
-              | data.classified.pre2;
+            const std::uint32_t lower =
+              unsignedByte(data.classified.pre1) << 8 | unsignedByte(data.classified.pre2);
+
+            if (hasSummaryByte(toBlob(data)))
+                return lower;
+
+            return unsignedByte(data.classified.pre0.byte) << 16 | lower;
         }
 
         void setExtentAsBytes(const std::uint32_t extent, DataLayout& data)
         {
-            if (extent > 1 << 24)
+            if (hasSummaryByte(toBlob(data))) {
+                if (extent > std::numeric_limits<std::uint16_t>::max())
+                    throw std::range_error{"Extent too large to be stored, exceeds limit of 2^16"};
+            } else if (extent >= 1 << 24)
                 throw std::range_error{"Extent too large to be stored, exceeds limit of 2^24"};
+            else
+                data.classified.pre0.byte = static_cast<char>((extent >> 16) & 0xff);
 
-            data.classified.pre0.byte = static_cast<char>((extent >> 16) & 0xff);
             data.classified.pre1 = static_cast<char>((extent >> 8) & 0xff);
             data.classified.pre2 = static_cast<char>(extent & 0xff);
         }
@@ -160,58 +189,25 @@ namespace sym2 {
     }
 }
 
-bool sym2::isSmallName(const std::string_view name) noexcept
+sym2::Blob sym2::construct(const SymbolId symbol, const DomainFlag domain) noexcept
 {
-    return name.size() <= DataLayout::smallSymbolNameLength;
+    return toBlob(DataLayout{.classified = {.classifier = Type::internedSymbol,
+                               .pre0 = {.domain = domain},
+                               .pre1 = '\0',
+                               .pre2 = '\0',
+                               .main = {.symbol = symbol}}});
 }
 
-sym2::Blob sym2::construct(std::int16_t n) noexcept
+sym2::Blob sym2::constructReference(const std::int32_t distance) noexcept
 {
-    return toBlob(DataLayout{.classified = {.classifier = Type::smallInt,
+    return toBlob(DataLayout{.classified = {.classifier = Type::reference,
                                .pre0 = {.byte = '\0'},
                                .pre1 = '\0',
                                .pre2 = '\0',
-                               .main = {.exact = {n, 1}}}});
+                               .main = {.distance = distance}}});
 }
 
-sym2::Blob sym2::construct(std::int16_t num, std::int16_t denom) noexcept
-{
-    assert(denom != 0);
-
-    if (denom < 0) {
-        num = static_cast<std::int16_t>(-num);
-        denom = static_cast<std::int16_t>(-denom);
-    }
-
-    const auto divisor = std::gcd(num, denom);
-
-    num = static_cast<std::int16_t>(num / divisor);
-    denom = static_cast<std::int16_t>(denom / divisor);
-
-    if (denom == std::int16_t{1})
-        return construct(num);
-    else
-        return toBlob(DataLayout{.classified = {.classifier = Type::smallRational,
-                                   .pre0 = {.byte = '\0'},
-                                   .pre1 = '\0',
-                                   .pre2 = '\0',
-                                   .main = {.exact = {num, denom}}}});
-}
-
-sym2::Blob sym2::construct(const std::string_view symbolName, const DomainFlag domain) noexcept
-{
-    DataLayout result{.classified = {.classifier = Type::shortSymbol,
-                        .pre0 = {.domain = domain},
-                        .pre1 = '\0',
-                        .pre2 = '\0',
-                        .main = {.name = {'\0'}}}};
-
-    std::memcpy(&result.classified.pre1, symbolName.data(), symbolName.size());
-
-    return toBlob(result);
-}
-
-sym2::LocalVec<sym2::Blob> sym2::constructSequence(double value, LocalAlloc<> alloc)
+sym2::BlobVec sym2::constructSequence(double value, LocalAlloc<> alloc)
 {
     return {{toBlob(DataLayout{.classified = {.classifier = Type::floatingPoint,
                                  .pre0 = {.byte = '\0'},
@@ -250,7 +246,7 @@ namespace sym2 {
         // This function allocates exactly once. This is important to meet assumptions for
         // expressions backed by a fixed-size buffer.
         void appendLargeSymbol(std::string_view longName, DomainFlag domain,
-          const std::size_t where, LocalVec<Blob>& dest)
+          const std::size_t where, BlobVec& dest)
         {
             // In the general case, we operate on an output containter that might have existing
             // elements, but potentially also not enough elements to assign to dest[where]. Also,
@@ -288,7 +284,7 @@ namespace sym2 {
 
         // Identical to appendLargeSymbol, but also covers the single-blob small symbol case
         void appendSmallOrLargeSymbol(
-          std::string_view name, DomainFlag domain, const std::size_t where, LocalVec<Blob>& dest)
+          std::string_view name, DomainFlag domain, const std::size_t where, BlobVec& dest)
         {
             if (name.length() <= DataLayout::smallSymbolNameLength)
                 dest[where] = construct(name, domain);
@@ -298,24 +294,24 @@ namespace sym2 {
     } // namespace
 } // namespace sym2
 
-sym2::LocalVec<sym2::Blob> sym2::constructSequence(
+sym2::BlobVec sym2::constructSequence(
   std::string_view symbolName, DomainFlag domain, LocalAlloc<> alloc)
 {
-    LocalVec<Blob> result{alloc};
+    BlobVec result{alloc};
 
     appendLargeSymbol(symbolName, domain, 0, result);
 
     return result;
 }
 
-sym2::LocalVec<sym2::Blob> sym2::constructSequence(
+sym2::BlobVec sym2::constructSequence(
   std::string_view constantName, double value, LocalAlloc<> alloc)
 {
     const std::uint16_t nBlobsForSymbol = 1 + numRemoteBlobsForSymbolName(constantName);
     // Double blob + symbol blobs:
     const std::uint32_t remoteExtent = 1 + nBlobsForSymbol;
 
-    LocalVec<Blob> result{1 + remoteExtent, alloc};
+    BlobVec result{1 + remoteExtent, alloc};
 
     result[0] = toBlob(DataLayout{.classified = {.classifier = Type::constant,
                                     .pre0 = {.byte = '\0'},
@@ -333,7 +329,7 @@ sym2::LocalVec<sym2::Blob> sym2::constructSequence(
 
 namespace sym2 {
     namespace {
-        std::uint16_t appendLargeIntData(const LargeInt& n, LocalVec<Blob>& dest)
+        std::uint16_t appendLargeIntData(const LargeInt& n, BlobVec& dest)
         {
             static_assert(sizeof(decltype(*n.backend().limbs())) == sizeof(Blob));
 
@@ -367,9 +363,9 @@ namespace sym2 {
     } // namespace
 } // namespace sym2
 
-sym2::LocalVec<sym2::Blob> sym2::constructSequence(const LargeInt& n, LocalAlloc<> alloc)
+sym2::BlobVec sym2::constructSequence(const LargeInt& n, LocalAlloc<> alloc)
 {
-    LocalVec<Blob> result{alloc};
+    BlobVec result{alloc};
 
     assert(!fitsInto<std::int16_t>(n));
 
@@ -392,7 +388,7 @@ sym2::LocalVec<sym2::Blob> sym2::constructSequence(const LargeInt& n, LocalAlloc
     return result;
 }
 
-sym2::LocalVec<sym2::Blob> sym2::constructSequence(const LargeRational& n, LocalAlloc<> alloc)
+sym2::BlobVec sym2::constructSequence(const LargeRational& n, LocalAlloc<> alloc)
 {
     const auto num = numerator(n);
     const auto denom = denominator(n);
@@ -401,7 +397,7 @@ sym2::LocalVec<sym2::Blob> sym2::constructSequence(const LargeRational& n, Local
 
     const std::size_t requiredSize = num.backend().size() + denom.backend().size();
 
-    LocalVec<Blob> result{alloc};
+    BlobVec result{alloc};
     // Make sure we only allocate once, no matter what callees reserve below.
     result.reserve(1 + requiredSize + 2);
 
@@ -455,7 +451,21 @@ sym2::LocalVec<sym2::Blob> sym2::constructSequence(const LargeRational& n, Local
     return result;
 }
 
-sym2::LocalVec<sym2::Blob> sym2::constructSequence(
+sym2::BlobVec sym2::constructSequence(const ModularInt n, LocalAlloc<> alloc)
+{
+    assert(n.value < n.modulus);
+
+    return {{toBlob(DataLayout{.classified = {.classifier = Type::modularInt,
+                                 .pre0 = {.byte = '\0'},
+                                 .pre1 = '\0',
+                                 .pre2 = '\0',
+                                 .main = {.location = {1, 2}}}}),
+              toBlob(DataLayout{.modularData = n.value}),
+              toBlob(DataLayout{.modularData = n.modulus})},
+      alloc};
+}
+
+sym2::BlobVec sym2::constructSequence(
   std::string_view function, const Blob* arg, UnaryDoubleFctPtr eval, LocalAlloc<> allocator)
 {
     // Single-arg function blobs look like this:
@@ -469,7 +479,7 @@ sym2::LocalVec<sym2::Blob> sym2::constructSequence(
     const auto [argOffset, argExtent] = offsetAndRemoteExtent(arg);
     const std::uint32_t remoteExtent = 3 + argExtent + numRemoteBlobsForSymbolName(function);
 
-    LocalVec<Blob> result{allocator};
+    BlobVec result{allocator};
     // We account for root header, function pointer, symbol blob, plus the argument root blob.
     result.reserve(remoteExtent + 1);
     result.resize(4);
@@ -484,15 +494,17 @@ sym2::LocalVec<sym2::Blob> sym2::constructSequence(
     appendSmallOrLargeSymbol(function, DomainFlag::none, 2, result);
     appendDuplicateSequence(arg, 3, result);
 
-    setExtentAsBytes(remoteExtent, *fromBlob(&result[0]));
+    // Duplicates of arguments with shared subtrees can be larger than their remote extent:
+    setExtentAsBytes(static_cast<std::uint32_t>(result.size() - 1), *fromBlob(&result[0]));
+    computeSummaryInplace(result.data());
 
     return result;
 }
 
-sym2::LocalVec<sym2::Blob> sym2::constructSequence(std::string_view function, const Blob* arg1,
+sym2::BlobVec sym2::constructSequence(std::string_view function, const Blob* arg1,
   const Blob* arg2, BinaryDoubleFctPtr eval, LocalAlloc<> allocator)
 {
-    LocalVec<Blob> result{allocator};
+    BlobVec result{allocator};
     const auto [offset1, extent1] = offsetAndRemoteExtent(arg1);
     const auto [offset2, extent2] = offsetAndRemoteExtent(arg2);
     // Function header, function pointer, symbol root blob, both argument root blobs, and optionally
@@ -515,215 +527,817 @@ sym2::LocalVec<sym2::Blob> sym2::constructSequence(std::string_view function, co
     appendDuplicateSequence(arg1, 3, result);
     appendDuplicateSequence(arg2, 4, result);
 
-    setExtentAsBytes(remoteExtent, *fromBlob(&result[0]));
+    // Duplicates of arguments with shared subtrees can be larger than their remote extent:
+    setExtentAsBytes(static_cast<std::uint32_t>(result.size() - 1), *fromBlob(&result[0]));
+    computeSummaryInplace(result.data());
 
     return result;
 }
 
 namespace sym2 {
     namespace {
-        Type toInternalType(const CompositeType composite)
-        {
-            switch (composite) {
-                case CompositeType::sum:
-                    return Type::sum;
-                case CompositeType::product:
-                    return Type::product;
-                case CompositeType::power:
-                    return Type::power;
-                case CompositeType::complexNumber:
-                    return Type::complexNumber;
-                default:
-                    assert(false && "Unhandled composite type");
-                    return Type::sum; // Random choice
+        // Duplicates a blob and sets the offset to the given new offset. Works only with a header
+        // blob that is followed by additional data, UB otherwise.
+        Blob constructDuplicate(Blob header, std::uint16_t newOffset) noexcept
+        {
+            DataLayout result = fromBlob(header);
+
+            result.classified.main.location.offset = newOffset;
+
+            return toBlob(result);
+        }
+    }
+}
+
+namespace sym2 {
+    namespace {
+        bool hasReferences(const Blob* const header) noexcept
+        {
+            return hasSummaryByte(*header)
+              && hasSummaryFlag(header, SummaryFlag::containsReference);
+        }
+
+        // True if all references in the tree rooted at header refer to Blobs in [first, last).
+        // References aren't followed, as the subtrees they refer to are checked where they're
+        // physically stored.
+        bool referencesWithin(const Blob* header, const Blob* first, const Blob* last) noexcept
+        {
+            const std::less<const Blob*> less{};
+
+            for (const Blob* op = getFirstOperand(header); op != getPastTheEndOperand(header); ++op)
+                if (type(*op) == Type::reference) {
+                    const Blob* const target = resolveReference(op);
+
+                    if (less(target, first) || !less(target, last))
+                        return false;
+                } else if (hasReferences(op) && !referencesWithin(op, first, last))
+                    return false;
+
+            return true;
+        }
+
+        void appendPlainDuplicate(const Blob* from, std::size_t where, BlobVec& output)
+        {
+            if (output.size() < where + 1)
+                output.resize(where + 1);
+
+            if (isSelfContainedHeader(*from)) {
+                output[where] = *from;
+            } else {
+                output[where] =
+                  constructDuplicate(*from, static_cast<std::uint16_t>(output.size() - where));
+
+                const auto [offset, extent] = offsetAndRemoteExtent(from);
+                const std::size_t currentSize = output.size();
+
+                output.resize(currentSize + extent);
+
+                std::copy(from + offset, from + offset + extent, output.begin() + currentSize);
+            }
+        }
+
+        // Hash value consistent with equal(), i.e., equal expressions have identical hash values,
+        // and references are transparent. Sums, products, powers and functions combine the hash
+        // values of their operands as returned by the given function.
+        template <class OperandHash>
+        std::size_t hashImpl(const Blob* header, OperandHash&& hashOperand) noexcept
+        {
+            header = resolveReference(header);
+
+            if (isSelfContainedHeader(*header))
+                return boost::hash_value(std::bit_cast<std::uint64_t>(*header));
+
+            std::size_t seed = boost::hash_value(static_cast<std::uint8_t>(type(*header)));
+
+            if (!hasSummaryByte(*header)) {
+                // Scalars are compared by their type and all remote Blobs:
+                const auto [offset, extent] = offsetAndRemoteExtent(header);
+
+                for (const Blob* remote = header + offset; remote != header + offset + extent;
+                     ++remote)
+                    boost::hash_combine(seed, std::bit_cast<std::uint64_t>(*remote));
+
+                return seed;
+            }
+
+            const Blob* const first = getFirstOperand(header);
+
+            boost::hash_combine(seed, nOperands(header));
+
+            if (isFunctionHeader(*header)) {
+                boost::hash_combine(seed, std::bit_cast<std::uint64_t>(*(first - 2)));
+                boost::hash_combine(seed, hashOperand(first - 1));
+            }
+
+            for (const Blob* op = first; op != getPastTheEndOperand(header); ++op)
+                boost::hash_combine(seed, hashOperand(op));
+
+            return seed;
+        }
+
+        // Subtrees that have already been written to the output, with fingerprints such that equal
+        // expressions have identical fingerprints. Fingerprints of the input are memoised per
+        // header, which keeps their computation linear when the input shares subtrees itself.
+        class SharedSubtrees {
+          public:
+            explicit SharedSubtrees(LocalAlloc<> allocator)
+                : fingerprints{allocator}
+                , written{allocator}
+            {}
+
+            std::size_t fingerprint(const Blob* header)
+            {
+                header = resolveReference(header);
+
+                if (!hasSummaryByte(*header))
+                    return hash(header);
+                else if (const auto known = fingerprints.find(header); known != fingerprints.end())
+                    return known->second;
+
+                const std::size_t seed =
+                  hashImpl(header, [this](const Blob* op) { return fingerprint(op); });
+
+                fingerprints.emplace(header, seed);
+
+                return seed;
+            }
+
+            // Returns the position of an equal subtree in the output, if there is one:
+            std::optional<std::size_t> find(
+              const Blob* header, std::size_t fingerprint, const BlobVec& output) const
+            {
+                const auto [first, last] = written.equal_range(fingerprint);
+
+                for (auto candidate = first; candidate != last; ++candidate)
+                    if (equal(output.data() + candidate->second, header))
+                        return candidate->second;
+
+                return std::nullopt;
+            }
+
+            void add(std::size_t fingerprint, std::size_t position)
+            {
+                written.emplace(fingerprint, position);
             }
+
+          private:
+            std::unordered_map<const Blob*, std::size_t, std::hash<const Blob*>,
+              std::equal_to<const Blob*>, LocalAlloc<std::pair<const Blob* const, std::size_t>>>
+              fingerprints;
+            // Fingerprints and positions of the root headers of subtrees in the output:
+            std::unordered_multimap<std::size_t, std::size_t, std::hash<std::size_t>,
+              std::equal_to<std::size_t>, LocalAlloc<std::pair<const std::size_t, std::size_t>>>
+              written;
+        };
+
+        void appendShared(
+          const Blob* from, std::size_t where, BlobVec& output, SharedSubtrees& shared)
+        {
+            from = resolveReference(from);
+
+            if (!hasSummaryByte(*from)) {
+                appendPlainDuplicate(from, where, output);
+                return;
+            }
+
+            const std::size_t fingerprint = shared.fingerprint(from);
+
+            if (output.size() < where + 1)
+                output.resize(where + 1);
+
+            if (const auto position = shared.find(from, fingerprint, output)) {
+                const auto distance =
+                  static_cast<std::int64_t>(*position) - static_cast<std::int64_t>(where);
+
+                if (distance < std::numeric_limits<std::int32_t>::min()
+                  || distance > std::numeric_limits<std::int32_t>::max())
+                    throw std::range_error{"Can't refer to a subtree that far away"};
+
+                output[where] = constructReference(static_cast<std::int32_t>(distance));
+                return;
+            }
+
+            // Function pointer and name precede the logical operands, and are never shared:
+            const bool function = isFunctionHeader(*from);
+            const std::size_t delta = function ? 2 : 0;
+            const std::size_t remote = output.size();
+            const Blob* const firstOperand = getFirstOperand(from);
+
+            output[where] = constructDuplicate(*from, static_cast<std::uint16_t>(remote - where));
+            output.resize(remote + delta + nOperands(from));
+
+            if (function) {
+                output[remote] = *(firstOperand - 2);
+                appendPlainDuplicate(firstOperand - 1, remote + 1, output);
+            }
+
+            for (std::size_t i = 0; i < nOperands(from); ++i)
+                appendShared(firstOperand + i, remote + delta + i, output, shared);
+
+            setExtentAsBytes(
+              static_cast<std::uint32_t>(output.size() - remote), *fromBlob(&output[where]));
+            computeSummaryInplace(&output[where]);
+
+            shared.add(fingerprint, where);
         }
     }
 }
 
-sym2::Blob sym2::constructCompositeHeader(
-  CompositeType composite, const std::uint16_t numOperands, const std::uint32_t extent) noexcept
+sym2::BlobVec sym2::constructDuplicateSequence(
+  const Blob* from, LocalAlloc<> allocator)
+{
+    BlobVec result{allocator};
+
+    appendDuplicateSequence(from, 0, result);
+
+    return result;
+}
+
+sym2::BlobVec sym2::constructSharedSequence(const Blob* from, LocalAlloc<> allocator)
 {
-    DataLayout data{.classified = {.classifier = toInternalType(composite),
-                      .pre0 = {.byte = '\0'},
-                      .pre1 = '\0',
-                      .pre2 = '\0',
-                      .main = {.location = {1, numOperands}}}};
+    BlobVec result{allocator};
+    SharedSubtrees shared{allocator};
+
+    appendShared(from, 0, result, shared);
+
+    return result;
+}
+
+void sym2::appendDuplicateSequence(const Blob* from, std::size_t where, BlobVec& output)
+{
+    from = resolveReference(from);
+
+    if (hasReferences(from)) {
+        const auto [offset, extent] = offsetAndRemoteExtent(from);
 
-    setExtentAsBytes(extent, data);
+        if (!referencesWithin(from, from + offset, from + offset + extent)) {
+            SharedSubtrees shared{output.get_allocator()};
 
-    return toBlob(data);
+            appendShared(from, where, output, shared);
+            return;
+        }
+    }
+
+    appendPlainDuplicate(from, where, output);
 }
 
 namespace sym2 {
     namespace {
-        // Duplicates a blob and sets the offset to the given new offset. Works only with a header
-        // blob that is followed by additional data, UB otherwise.
-        Blob constructDuplicate(Blob header, std::uint16_t newOffset) noexcept
+        // Appends a duplicate in which references are replaced by the subtrees they refer to:
+        void appendExpanded(const Blob* from, std::size_t where, BlobVec& output)
         {
-            DataLayout result = fromBlob(header);
+            from = resolveReference(from);
 
-            result.classified.main.location.offset = newOffset;
+            if (!hasReferences(from)) {
+                appendPlainDuplicate(from, where, output);
+                return;
+            }
 
-            return toBlob(result);
+            if (output.size() < where + 1)
+                output.resize(where + 1);
+
+            const bool function = isFunctionHeader(*from);
+            const std::size_t delta = function ? 2 : 0;
+            const std::size_t remote = output.size();
+            const Blob* const firstOperand = getFirstOperand(from);
+
+            if (remote - where > std::numeric_limits<std::uint16_t>::max())
+                throw std::range_error{"Can't handle composite expression of given size"};
+
+            output[where] = constructDuplicate(*from, static_cast<std::uint16_t>(remote - where));
+            output.resize(remote + delta + nOperands(from));
+
+            if (function) {
+                output[remote] = *(firstOperand - 2);
+                appendPlainDuplicate(firstOperand - 1, remote + 1, output);
+            }
+
+            for (std::size_t i = 0; i < nOperands(from); ++i)
+                appendExpanded(firstOperand + i, remote + delta + i, output);
+
+            setExtentAsBytes(
+              static_cast<std::uint32_t>(output.size() - remote), *fromBlob(&output[where]));
+            computeSummaryInplace(&output[where]);
+        }
+
+        void shiftOffsetInplace(Blob& header, std::int64_t delta)
+        {
+            const std::int64_t offset = offsetToRemote(header) + delta;
+
+            if (offset < 0 || offset > std::numeric_limits<std::uint16_t>::max())
+                throw std::range_error{"Can't handle composite expression of given size"};
+
+            updateOffsetInplace(header, static_cast<std::uint16_t>(offset));
+        }
+
+        // The remote Blobs of the given operand, or where they would be stored if it has none,
+        // i.e., right before those of subsequent operands, or at the end of the parent:
+        const Blob* remoteBlobsOf(const Blob* parent, const Blob* operand) noexcept
+        {
+            for (const Blob* op = operand; op != getPastTheEndOperand(parent); ++op)
+                if (!isSelfContainedHeader(*op))
+                    return op + offsetToRemote(*op);
+
+            return parent + offsetToRemote(*parent) + remoteExtent(parent);
+        }
+
+        void appendRange(const Blob* first, const Blob* last, BlobVec& output)
+        {
+            const std::size_t currentSize = output.size();
+
+            output.resize(currentSize + static_cast<std::size_t>(last - first));
+            std::copy(first, last, output.begin() + static_cast<std::ptrdiff_t>(currentSize));
+        }
+
+        // Sets the header of a sum or product whose operands have been copied to output already:
+        void finishSumOrProductInplace(const Blob original, std::uint16_t numOperands,
+          BlobVec& output)
+        {
+            const std::size_t extent = output.size() - 1;
+            const CompositeType composite =
+              isSumHeader(original) ? CompositeType::sum : CompositeType::product;
+
+            if (extent > std::numeric_limits<std::uint16_t>::max())
+                throw std::range_error{"Can't handle composite expression of given size"};
+
+            output[0] =
+              constructCompositeHeader(composite, numOperands, static_cast<std::uint32_t>(extent));
+            computeSummaryInplace(output.data());
         }
     }
 }
 
-sym2::LocalVec<sym2::Blob> sym2::constructDuplicateSequence(
-  const Blob* from, LocalAlloc<> allocator)
+sym2::BlobVec sym2::constructSplicedSequence(const Blob* root,
+  std::span<const std::uint16_t> path, const Blob* replacement, LocalAlloc<> allocator)
 {
-    LocalVec<Blob> result{allocator};
+    root = resolveReference(root);
 
-    appendDuplicateSequence(from, 0, result);
+    if (path.empty())
+        return constructDuplicateSequence(replacement, allocator);
+    else if (hasReferences(root)) {
+        // Distances of references across the replaced operand would change, so splice into a
+        // duplicate without any:
+        BlobVec expanded{allocator};
+
+        appendExpanded(root, 0, expanded);
+
+        return constructSplicedSequence(expanded.data(), path, replacement, allocator);
+    }
+
+    LocalVec<const Blob*> ancestors{allocator};
+    const Blob* target = root;
+
+    ancestors.reserve(path.size());
+
+    for (const std::uint16_t index : path) {
+        if (index >= nOperands(target))
+            throw std::out_of_range{"Operand path doesn't exist in the expression"};
+
+        ancestors.push_back(target);
+        target = getFirstOperand(target) + index;
+    }
+
+    const Blob* const first = remoteBlobsOf(ancestors.back(), target);
+    const Blob* const last = first + (isSelfContainedHeader(*target) ? 0 : remoteExtent(target));
+    const Blob* const end = root + remoteExtent(root) + 1;
+    const auto position = [root](const Blob* blob) {
+        return static_cast<std::size_t>(blob - root);
+    };
+    BlobVec result{allocator};
+
+    result.reserve(
+      position(first) + remoteExtent(replacement) + 1 + position(end) - position(last));
+    result.resize(position(first));
+    std::copy(root, first, result.begin());
+
+    appendDuplicateSequence(replacement, position(target), result);
+
+    const auto delta =
+      static_cast<std::int64_t>(result.size()) - static_cast<std::int64_t>(position(last));
+    const std::size_t tail = result.size();
+
+    result.resize(tail + position(end) - position(last));
+    std::copy(last, end, result.begin() + static_cast<std::ptrdiff_t>(tail));
+
+    // Ancestors and their operands are stored before the replaced Blobs, so their positions are
+    // unchanged. Innermost first, such that summaries are computed from updated operands:
+    for (std::size_t k = ancestors.size(); k-- > 0;) {
+        Blob* const ancestor = result.data() + position(ancestors[k]);
+        const Blob* const child = k + 1 < ancestors.size() ? ancestors[k + 1] : target;
+
+        for (const Blob* op = child + 1; op != getPastTheEndOperand(ancestors[k]); ++op)
+            if (!isSelfContainedHeader(*op))
+                shiftOffsetInplace(result[position(op)], delta);
+
+        const std::int64_t extent = remoteExtent(ancestor) + delta;
+
+        setExtentAsBytes(static_cast<std::uint32_t>(extent), *fromBlob(ancestor));
+        computeSummaryInplace(ancestor);
+    }
 
     return result;
 }
 
-void sym2::appendDuplicateSequence(const Blob* from, std::size_t where, LocalVec<Blob>& output)
+sym2::BlobVec sym2::constructInsertedSequence(const Blob* composite, const std::uint16_t index,
+  const Blob* operand, LocalAlloc<> allocator)
 {
-    if (output.size() < where + 1)
-        output.resize(where + 1);
+    composite = resolveReference(composite);
 
-    if (isSelfContainedHeader(*from)) {
-        output[where] = *from;
-    } else {
-        output[where] =
-          constructDuplicate(*from, static_cast<std::uint16_t>(output.size() - where));
+    assert(isSumHeader(*composite) || isProductHeader(*composite));
+    assert(index <= nOperands(composite));
 
-        const auto [offset, extent] = offsetAndRemoteExtent(from);
-        const std::size_t currentSize = output.size();
+    if (hasReferences(composite)) {
+        // Same as for splicing, references after the new operand would change their distance:
+        BlobVec expanded{allocator};
 
-        output.resize(currentSize + extent);
+        appendExpanded(composite, 0, expanded);
 
-        std::copy(from + offset, from + offset + extent, output.begin() + currentSize);
+        return constructInsertedSequence(expanded.data(), index, operand, allocator);
     }
+
+    const std::uint16_t n = nOperands(composite);
+    const Blob* const first = getFirstOperand(composite);
+    const Blob* const split = remoteBlobsOf(composite, first + index);
+    const Blob* const end = composite + offsetToRemote(*composite) + remoteExtent(composite);
+    BlobVec result{allocator};
+
+    result.reserve(remoteExtent(composite) + remoteExtent(operand) + 2);
+    result.resize(1);
+    appendRange(first, first + index, result);
+    result.resize(result.size() + 1);
+    appendRange(first + index, first + n, result);
+    appendRange(first + n, split, result);
+
+    const std::size_t tail = result.size();
+
+    appendDuplicateSequence(operand, index + 1u, result);
+
+    const auto delta = static_cast<std::int64_t>(result.size() - tail);
+
+    appendRange(split, end, result);
+
+    // Preceding operands are shifted by the new operand header, subsequent ones by its remote Blobs:
+    for (std::size_t i = 0; i < n; ++i) {
+        Blob& op = result[1 + i + (i >= index ? 1 : 0)];
+
+        if (!isSelfContainedHeader(op))
+            shiftOffsetInplace(op, i < index ? 1 : delta);
+    }
+
+    finishSumOrProductInplace(*composite, static_cast<std::uint16_t>(n + 1), result);
+
+    return result;
 }
 
-bool sym2::isNumberHeader(const Blob header) noexcept
+sym2::BlobVec sym2::constructErasedSequence(
+  const Blob* composite, const std::uint16_t index, LocalAlloc<> allocator)
 {
-    switch (type(header)) {
-        case Type::smallInt:
-        case Type::smallRational:
-        case Type::floatingPoint:
-        case Type::largeInt:
-        case Type::largeRational:
-        case Type::complexNumber:
-            return true;
-        default:
-            return false;
+    composite = resolveReference(composite);
+
+    assert(isSumHeader(*composite) || isProductHeader(*composite));
+    assert(index < nOperands(composite));
+
+    if (hasReferences(composite)) {
+        BlobVec expanded{allocator};
+
+        appendExpanded(composite, 0, expanded);
+
+        return constructErasedSequence(expanded.data(), index, allocator);
+    }
+
+    const std::uint16_t n = nOperands(composite);
+    const Blob* const first = getFirstOperand(composite);
+    const Blob* const target = first + index;
+    const Blob* const from = remoteBlobsOf(composite, target);
+    const Blob* const to = from + (isSelfContainedHeader(*target) ? 0 : remoteExtent(target));
+    const Blob* const end = composite + offsetToRemote(*composite) + remoteExtent(composite);
+    const auto delta = static_cast<std::int64_t>(to - from);
+    BlobVec result{allocator};
+
+    result.reserve(remoteExtent(composite) - static_cast<std::size_t>(delta));
+    result.resize(1);
+    appendRange(first, target, result);
+    appendRange(target + 1, first + n, result);
+    appendRange(first + n, from, result);
+    appendRange(to, end, result);
+
+    // Preceding operands are shifted by the removed operand header, subsequent ones by its remote
+    // Blobs:
+    for (std::size_t i = 0; i + 1 < n; ++i) {
+        Blob& op = result[1 + i];
+
+        if (!isSelfContainedHeader(op))
+            shiftOffsetInplace(op, i < index ? -1 : -delta);
     }
+
+    finishSumOrProductInplace(*composite, static_cast<std::uint16_t>(n - 1), result);
+
+    return result;
 }
 
-bool sym2::isIntegerHeader(const Blob header) noexcept
+namespace sym2 {
+    namespace {
+        template <class DoubleFctPtr>
+        void appendFunctionPrefixImpl(std::string_view name, DoubleFctPtr eval, BlobVec& output)
+        {
+            output.push_back(toBlob(DataLayout{.classified = {.classifier = Type::function,
+                                                 .pre0 = {.byte = '\0'},
+                                                 .pre1 = '\0',
+                                                 .pre2 = '\0',
+                                                 .main = {.location = {1, 0 /* Set later */}}}}));
+
+            if constexpr (std::same_as<DoubleFctPtr, UnaryDoubleFctPtr>)
+                output.push_back(toBlob(DataLayout{.unaryFctEval = eval}));
+            else
+                output.push_back(toBlob(DataLayout{.binaryFctEval = eval}));
+
+            output.resize(output.size() + 1);
+
+            appendSmallOrLargeSymbol(name, DomainFlag::none, output.size() - 1, output);
+        }
+    }
+}
+
+void sym2::appendFunctionPrefix(std::string_view name, UnaryDoubleFctPtr eval, BlobVec& output)
 {
-    const Type t = type(header);
+    appendFunctionPrefixImpl(name, eval, output);
+}
 
-    return t == Type::smallInt || t == Type::largeInt;
+void sym2::appendFunctionPrefix(std::string_view name, BinaryDoubleFctPtr eval, BlobVec& output)
+{
+    appendFunctionPrefixImpl(name, eval, output);
 }
 
-bool sym2::isRationalHeader(const Blob header) noexcept
+void sym2::finishCompositeInplace(std::span<Blob> composite,
+  std::span<const std::uint32_t> operandPositions, std::span<Blob> scratch)
 {
-    switch (type(header)) {
-        case Type::smallInt:
-        case Type::smallRational:
-        case Type::largeInt:
-        case Type::largeRational:
-            return true;
-        default:
-            return false;
+    Blob* const header = composite.data();
+    const std::size_t extent = composite.size() - 1;
+    const std::size_t n = operandPositions.size();
+    // Function pointer and name precede the logical operands, see appendFunctionPrefix:
+    const bool function = isFunctionHeader(*header);
+    const std::size_t first = function ? 2 : 1;
+
+    assert(scratch.size() >= n);
+    assert(!function || n >= 1);
+    assert(n == 0 || operandPositions.front() == first);
+
+    if (extent >= (hasSummaryByte(*header) ? 1u << 16 : 1u << 24))
+        throw std::range_error{"Can't handle composite expression of given size"};
+
+    // When the root headers move to the front, the remote Blobs of the i-th operand move by the
+    // number of root headers after it, so its distance to the new root header position is:
+    const auto newOffset = [&](std::size_t i) { return operandPositions[i] + n - 2 * i - first; };
+
+    for (std::size_t i = 0; i < n; ++i)
+        if (!isSelfContainedHeader(header[operandPositions[i]])
+          && newOffset(i) > std::numeric_limits<std::uint16_t>::max())
+            throw std::range_error{"Can't handle composite expression of given size"};
+
+    for (std::size_t i = 0; i < n; ++i)
+        scratch[i] = header[operandPositions[i]];
+
+    // Back to front, such that no remote Blobs are overwritten before they're moved:
+    for (std::size_t i = n; i-- > 0;) {
+        const Blob* const remote = header + operandPositions[i] + 1;
+        const Blob* const end = i + 1 < n ? header + operandPositions[i + 1] : header + extent + 1;
+
+        std::copy_backward(remote, end, header + operandPositions[i] + n - i + (end - remote));
     }
+
+    for (std::size_t i = 0; i < n; ++i)
+        header[first + i] = isSelfContainedHeader(scratch[i]) ?
+          scratch[i] :
+          constructDuplicate(scratch[i], static_cast<std::uint16_t>(newOffset(i)));
+
+    updateExtentInplace(*header, static_cast<std::uint16_t>(function ? n - 1 : n));
+    setExtentAsBytes(static_cast<std::uint32_t>(extent), *fromBlob(header));
+    computeSummaryInplace(header);
+}
+
+namespace sym2 {
+    namespace {
+        std::uint8_t bit(const SummaryFlag flag) noexcept
+        {
+            return static_cast<std::uint8_t>(flag);
+        }
+
+        bool isPositiveScalar(const Blob* const header) noexcept
+        {
+            const DataLayout data = fromBlob(*header);
+
+            switch (type(*header)) {
+                case Type::shortSymbol:
+                case Type::longSymbol:
+                case Type::internedSymbol:
+                    return data.classified.pre0.domain == DomainFlag::positive;
+                case Type::smallInt:
+                case Type::smallRational:
+                    return data.classified.main.exact.num > 0;
+                case Type::largeInt:
+                    return data.classified.pre0.byte == 0;
+                case Type::largeRational:
+                    return isPositiveScalar(getNumeratorFromLargeRational(header));
+                case Type::floatingPoint:
+                case Type::constant:
+                    return getFloatingPoint(header) > 0.0;
+                case Type::modularInt: // Residue classes have no sign
+                default:
+                    return false;
+            }
+        }
+
+        std::uint8_t scalarSummary(const Blob* const header) noexcept
+        {
+            std::uint8_t result = isPositiveScalar(header) ? bit(SummaryFlag::positive) : 0;
+
+            if (isSymbolHeader(*header)) {
+                result |= bit(SummaryFlag::containsSymbol);
+                result |= getDomainFlag(header) == DomainFlag::none ?
+                  bit(SummaryFlag::containsNonReal) :
+                  bit(SummaryFlag::containsNonComplex);
+            } else if (isComplexNumberHeader(*header)) {
+                result |= bit(SummaryFlag::containsComplexNumber);
+                result |= bit(SummaryFlag::containsNonReal);
+
+                if (isFloatingPointHeader(*getRealFromCommplexNumber(header))
+                  || isFloatingPointHeader(*getImagFromCommplexNumber(header)))
+                    result |= bit(SummaryFlag::containsFloatingPoint);
+            } else {
+                result |= bit(SummaryFlag::containsNonComplex);
+
+                if (isFloatingPointHeader(*header))
+                    result |= bit(SummaryFlag::containsFloatingPoint);
+            }
+
+            return result;
+        }
+
+        std::uint8_t summary(const Blob* const header) noexcept
+        {
+            if (type(*header) == Type::reference)
+                return summary(resolveReference(header)) | bit(SummaryFlag::containsReference);
+            else if (hasSummaryByte(*header))
+                return unsignedByte(fromBlob(*header).classified.pre0.byte);
+
+            return scalarSummary(header);
+        }
+    }
+}
+
+void sym2::computeSummaryInplace(Blob* const header) noexcept
+{
+    if (!hasSummaryByte(*header))
+        return;
+
+    const std::uint8_t positive = bit(SummaryFlag::positive);
+    const auto containsMask = static_cast<std::uint8_t>(~positive);
+    const Blob* const first = getFirstOperand(header);
+    const Blob* const last = getPastTheEndOperand(header);
+    std::uint8_t result = 0;
+    bool allPositive = true;
+
+    for (const Blob* op = first; op != last; ++op) {
+        const std::uint8_t opSummary = summary(op);
+
+        result |= opSummary & containsMask;
+        allPositive = allPositive && (opSummary & positive);
+    }
+
+    if (isPowerHeader(*header)) {
+        // Composites without non-real leaves can still be non-real, e.g. (-1)^(1/2), so the
+        // exponent is only known to be real if it's a real scalar or positive itself:
+        const Blob* const exp = resolveReference(first + 1);
+        const std::uint8_t expSummary = summary(exp);
+        const bool realExponent = (expSummary & positive)
+          || (isScalarHeader(*exp) && !(expSummary & bit(SummaryFlag::containsNonReal)));
+
+        if ((summary(first) & positive) && realExponent)
+            result |= positive;
+    } else if (!isFunctionHeader(*header) && allPositive)
+        result |= positive;
+
+    fromBlob(header)->classified.pre0.byte = static_cast<char>(result);
+}
+
+bool sym2::hasSummaryFlag(const Blob* const header, const SummaryFlag flag) noexcept
+{
+    return summary(header) & bit(flag);
+}
+
+bool sym2::isNumberHeader(const Blob header) noexcept
+{
+    return hasTypeIn(&header, numberTypes);
+}
+
+bool sym2::isIntegerHeader(const Blob header) noexcept
+{
+    return hasTypeIn(&header, integerTypes);
+}
+
+bool sym2::isRationalHeader(const Blob header) noexcept
+{
+    return hasTypeIn(&header, rationalTypes);
 }
 
 bool sym2::isFloatingPointHeader(const Blob header) noexcept
 {
-    return type(header) == Type::floatingPoint;
+    return hasTypeIn(&header, floatingPointTypes);
 }
 
 bool sym2::isComplexNumberHeader(const Blob header) noexcept
 {
-    return type(header) == Type::complexNumber;
+    return hasTypeIn(&header, complexNumberTypes);
+}
+
+bool sym2::isModularIntHeader(const Blob header) noexcept
+{
+    return hasTypeIn(&header, modularIntTypes);
 }
 
 bool sym2::isSmallHeader(const Blob header) noexcept
 {
-    switch (type(header)) {
-        case Type::smallInt:
-        case Type::smallRational:
-            return true;
-        default:
-            return false;
-    }
+    return hasTypeIn(&header, smallTypes);
 }
 
 bool sym2::isLargeHeader(const Blob header) noexcept
 {
-    return !isSmallHeader(header);
+    return hasTypeIn(&header, largeTypes);
 }
 
 bool sym2::isScalarHeader(const Blob header) noexcept
 {
-    return !isCompositeHeader(header);
+    return hasTypeIn(&header, scalarTypes);
 }
 
 bool sym2::isCompositeHeader(const Blob header) noexcept
 {
-    switch (type(header)) {
-        case Type::sum:
-        case Type::product:
-        case Type::power:
-        case Type::function:
-            return true;
-        default:
-            return false;
-    }
+    return hasTypeIn(&header, compositeTypes);
 }
 
 bool sym2::isSymbolHeader(const Blob header) noexcept
 {
-    const Type t = type(header);
-    return t == Type::shortSymbol || t == Type::longSymbol;
+    return hasTypeIn(&header, symbolTypes);
+}
+
+bool sym2::isInternedSymbolHeader(const Blob header) noexcept
+{
+    return hasTypeIn(&header, internedSymbolTypes);
 }
 
 bool sym2::isConstantHeader(const Blob header) noexcept
 {
-    return type(header) == Type::constant;
+    return hasTypeIn(&header, constantTypes);
 }
 
 bool sym2::isSumHeader(const Blob header) noexcept
 {
-    return type(header) == Type::sum;
+    return hasTypeIn(&header, sumTypes);
 }
 
 bool sym2::isProductHeader(const Blob header) noexcept
 {
-    return type(header) == Type::product;
+    return hasTypeIn(&header, productTypes);
 }
 
 bool sym2::isPowerHeader(const Blob header) noexcept
 {
-    return type(header) == Type::power;
+    return hasTypeIn(&header, powerTypes);
 }
 
 bool sym2::isFunctionHeader(const Blob header) noexcept
 {
-    return type(header) == Type::function;
+    return hasTypeIn(&header, functionTypes);
 }
 
-std::uint32_t sym2::remoteExtent(const Blob* const header) noexcept
+const sym2::Blob* sym2::resolveReference(const Blob* const header) noexcept
 {
+    if (type(*header) != Type::reference)
+        return header;
+
+    return header + fromBlob(*header).classified.main.distance;
+}
+
+std::uint32_t sym2::remoteExtent(const Blob* header) noexcept
+{
+    header = resolveReference(header);
+
     switch (type(*header)) {
         case Type::shortSymbol:
+        case Type::internedSymbol:
         case Type::smallInt:
         case Type::smallRational:
             return 0;
         case Type::floatingPoint:
             return 1;
+        case Type::modularInt:
+            return 2;
         case Type::longSymbol:
         case Type::largeInt:
             return fromBlob(*header).classified.main.location.extentOrOperands;
         case Type::largeRational:
-            return remoteExtent(header + offsetToRemote(*header))
+            // The headers of numerator and denominator, plus their own remote Blobs:
+            return 2 + remoteExtent(header + offsetToRemote(*header))
               + remoteExtent(header + offsetToRemote(*header) + 1);
         case Type::constant:
         case Type::complexNumber:
@@ -738,10 +1352,27 @@ std::uint32_t sym2::remoteExtent(const Blob* const header) noexcept
     }
 }
 
-std::uint16_t sym2::nOperands(const Blob* const header) noexcept
+bool sym2::belongsTo(const Blob* const blob, const Blob* header) noexcept
+{
+    if (blob == header)
+        return true;
+
+    header = resolveReference(header);
+
+    const auto [offset, extent] = offsetAndRemoteExtent(header);
+    const Blob* const first = header + offset;
+
+    // Pointers into unrelated trees can't be compared with the builtin operators:
+    return std::less_equal<>{}(first, blob) && std::less<>{}(blob, first + extent);
+}
+
+std::uint16_t sym2::nOperands(const Blob* header) noexcept
 {
+    header = resolveReference(header);
+
     switch (type(*header)) {
         case Type::shortSymbol:
+        case Type::internedSymbol:
         case Type::smallInt:
         case Type::smallRational:
         case Type::longSymbol:
@@ -750,6 +1381,7 @@ std::uint16_t sym2::nOperands(const Blob* const header) noexcept
         case Type::constant:
         case Type::largeRational:
         case Type::complexNumber:
+        case Type::modularInt:
             return 0;
         case Type::power:
             return 2;
@@ -763,8 +1395,43 @@ std::uint16_t sym2::nOperands(const Blob* const header) noexcept
     }
 }
 
-bool sym2::equal(const Blob* const lhs, const Blob* const rhs) noexcept
+namespace sym2 {
+    namespace {
+        // Compares the logical structure of two composites of the same type, which is necessary
+        // when at least one of them shares subtrees, as its Blobs then differ from those of an
+        // equal tree without references.
+        bool equalOperands(const Blob* const lhs, const Blob* const rhs) noexcept
+        {
+            if (nOperands(lhs) != nOperands(rhs))
+                return false;
+
+            const Blob* lhsOp = getFirstOperand(lhs);
+            const Blob* rhsOp = getFirstOperand(rhs);
+
+            if (isFunctionHeader(*lhs)
+              && (std::memcmp(lhsOp - 2, rhsOp - 2, sizeof(Blob)) != 0
+                || !equal(lhsOp - 1, rhsOp - 1)))
+                return false;
+
+            for (; lhsOp != getPastTheEndOperand(lhs); ++lhsOp, ++rhsOp)
+                if (!equal(lhsOp, rhsOp))
+                    return false;
+
+            return true;
+        }
+    }
+}
+
+std::size_t sym2::hash(const Blob* header) noexcept
 {
+    return hashImpl(header, [](const Blob* op) { return hash(op); });
+}
+
+bool sym2::equal(const Blob* lhs, const Blob* rhs) noexcept
+{
+    lhs = resolveReference(lhs);
+    rhs = resolveReference(rhs);
+
     // Optimisation idea for this function: bitcast both blobs into a 64bit integer, apply a bit
     // mask that zeros out the offset (which must not be compared when there's remote blobs), and
     // compare the integers. However, for a standalone blob like a small rational number, we still
@@ -787,10 +1454,21 @@ bool sym2::equal(const Blob* const lhs, const Blob* const rhs) noexcept
 
     assert(lhsExtent > 0 && rhsExtent > 0);
 
-    if (lhsExtent != rhsExtent || lhsNumOperands != rhsNumOperands)
-        return false;
+    // References only store a distance, so identical Blobs can still refer to different subtrees
+    // when these are stored outside of the compared range:
+    const auto selfContained = [](const Blob* header, std::uint16_t offset, std::uint32_t extent) {
+        return !hasReferences(header)
+          || referencesWithin(header, header + offset, header + offset + extent);
+    };
+
+    if (lhsExtent == rhsExtent && lhsNumOperands == rhsNumOperands
+      && selfContained(lhs, lhsOffset, lhsExtent) && selfContained(rhs, rhsOffset, rhsExtent)
+      && std::memcmp(lhs + lhsOffset, rhs + rhsOffset, lhsExtent * sizeof(Blob)) == 0)
+        return true;
+    else if (hasReferences(lhs) || hasReferences(rhs))
+        return equalOperands(lhs, rhs);
 
-    return std::memcmp(lhs + lhsOffset, rhs + rhsOffset, lhsExtent * sizeof(Blob)) == 0;
+    return false;
 }
 
 std::int16_t sym2::getSmallInt(Blob header) noexcept
@@ -835,11 +1513,22 @@ sym2::LargeInt sym2::getLargeInt(const Blob* const header)
     return result * sign;
 }
 
+sym2::ModularInt sym2::getModularInt(const Blob* const header) noexcept
+{
+    assert(isModularIntHeader(*header));
+
+    const Blob* const remote = std::next(header, offsetToRemote(*header));
+
+    return {fromBlob(remote[0]).modularData, fromBlob(remote[1]).modularData};
+}
+
 std::string_view sym2::getSymbolName(const Blob* const header) noexcept
 {
     assert(isSymbolHeader(*header));
 
-    if (type(*header) == Type::shortSymbol) {
+    if (type(*header) == Type::internedSymbol)
+        return internedName(getSymbolId(*header));
+    else if (type(*header) == Type::shortSymbol) {
         // Important to not use a new object, but alias the given argument in order to return a
         // valid view.
         const std::string_view name{
@@ -853,6 +1542,13 @@ std::string_view sym2::getSymbolName(const Blob* const header) noexcept
     }
 }
 
+sym2::SymbolId sym2::getSymbolId(const Blob header) noexcept
+{
+    assert(isInternedSymbolHeader(header));
+
+    return fromBlob(header).classified.main.symbol;
+}
+
 sym2::DomainFlag sym2::getDomainFlag(const Blob* header) noexcept
 {
     return fromBlob(*header).classified.pre0.domain;
@@ -917,6 +1613,8 @@ const sym2::Blob* sym2::getDenominatorFromLargeRational(const Blob* header) noex
 
 const sym2::Blob* sym2::getFirstOperand(const Blob* e) noexcept
 {
+    e = resolveReference(e);
+
     // See function to create functions, there are physical operands that we don't treat as logical
     // ones.
     const std::uint16_t delta = isFunctionHeader(*e) ? 2 : 0;
@@ -926,6 +1624,8 @@ const sym2::Blob* sym2::getFirstOperand(const Blob* e) noexcept
 
 const sym2::Blob* sym2::getPastTheEndOperand(const Blob* e) noexcept
 {
+    e = resolveReference(e);
+
     const std::uint16_t delta = isFunctionHeader(*e) ? 2 : 0;
 
     return e + offsetToRemote(*e) + nOperands(e) + delta;
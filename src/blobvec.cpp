@@ -0,0 +1,236 @@
+
+#include "sym2/blobvec.h"
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+sym2::BlobVec::BlobVec(allocator_type allocator) noexcept
+    : allocator{allocator}
+    , first{inlineBlobs}
+{}
+
+sym2::BlobVec::BlobVec(std::size_t n, allocator_type allocator)
+    : BlobVec{allocator}
+{
+    // Fixed-size buffers are allocated with exactly the requested size:
+    reserve(n);
+    resize(n);
+}
+
+sym2::BlobVec::BlobVec(std::initializer_list<Blob> blobs, allocator_type allocator)
+    : BlobVec{allocator}
+{
+    assign(blobs.begin(), blobs.size());
+}
+
+sym2::BlobVec::BlobVec(const BlobVec& other)
+    : BlobVec{other, other.allocator}
+{}
+
+sym2::BlobVec::BlobVec(const BlobVec& other, allocator_type allocator)
+    : BlobVec{allocator}
+{
+    assign(other.data(), other.size());
+}
+
+sym2::BlobVec::BlobVec(BlobVec&& other) noexcept
+    : BlobVec{other.allocator}
+{
+    if (other.isInline())
+        assign(other.data(), other.size());
+    else {
+        first = std::exchange(other.first, other.inlineBlobs);
+        count = std::exchange(other.count, 0);
+        cap = std::exchange(other.cap, inlineCapacity);
+    }
+}
+
+sym2::BlobVec::BlobVec(BlobVec&& other, allocator_type allocator)
+    : BlobVec{allocator}
+{
+    if (!other.isInline() && this->allocator == other.allocator)
+        *this = std::move(other);
+    else
+        assign(other.data(), other.size());
+}
+
+sym2::BlobVec& sym2::BlobVec::operator=(const BlobVec& other)
+{
+    if (this != &other)
+        assign(other.data(), other.size());
+
+    return *this;
+}
+
+sym2::BlobVec& sym2::BlobVec::operator=(BlobVec&& other)
+{
+    if (this == &other)
+        return *this;
+    else if (other.isInline() || allocator != other.allocator) {
+        assign(other.data(), other.size());
+        return *this;
+    }
+
+    release();
+
+    first = std::exchange(other.first, other.inlineBlobs);
+    count = std::exchange(other.count, 0);
+    cap = std::exchange(other.cap, inlineCapacity);
+
+    return *this;
+}
+
+sym2::BlobVec::~BlobVec()
+{
+    release();
+}
+
+sym2::Blob* sym2::BlobVec::data() noexcept
+{
+    return first;
+}
+
+const sym2::Blob* sym2::BlobVec::data() const noexcept
+{
+    return first;
+}
+
+sym2::Blob* sym2::BlobVec::begin() noexcept
+{
+    return first;
+}
+
+const sym2::Blob* sym2::BlobVec::begin() const noexcept
+{
+    return first;
+}
+
+sym2::Blob* sym2::BlobVec::end() noexcept
+{
+    return first + count;
+}
+
+const sym2::Blob* sym2::BlobVec::end() const noexcept
+{
+    return first + count;
+}
+
+sym2::Blob& sym2::BlobVec::operator[](std::size_t i) noexcept
+{
+    assert(i < count);
+
+    return first[i];
+}
+
+const sym2::Blob& sym2::BlobVec::operator[](std::size_t i) const noexcept
+{
+    assert(i < count);
+
+    return first[i];
+}
+
+sym2::Blob& sym2::BlobVec::front() noexcept
+{
+    return (*this)[0];
+}
+
+const sym2::Blob& sym2::BlobVec::front() const noexcept
+{
+    return (*this)[0];
+}
+
+sym2::Blob& sym2::BlobVec::back() noexcept
+{
+    return (*this)[count - 1];
+}
+
+const sym2::Blob& sym2::BlobVec::back() const noexcept
+{
+    return (*this)[count - 1];
+}
+
+std::size_t sym2::BlobVec::size() const noexcept
+{
+    return count;
+}
+
+bool sym2::BlobVec::empty() const noexcept
+{
+    return count == 0;
+}
+
+std::size_t sym2::BlobVec::capacity() const noexcept
+{
+    return cap;
+}
+
+bool sym2::BlobVec::isInline() const noexcept
+{
+    return first == inlineBlobs;
+}
+
+void sym2::BlobVec::reserve(std::size_t n)
+{
+    if (n > cap)
+        reallocate(n);
+}
+
+void sym2::BlobVec::resize(std::size_t n, Blob value)
+{
+    // Callers mostly append by growing the size, so the capacity grows geometrically, too:
+    if (n > cap)
+        reallocate(std::max(n, 2 * cap));
+
+    if (n > count)
+        std::fill(first + count, first + n, value);
+
+    count = n;
+}
+
+void sym2::BlobVec::push_back(Blob blob)
+{
+    if (count == cap)
+        reallocate(2 * cap);
+
+    first[count++] = blob;
+}
+
+sym2::BlobVec::allocator_type sym2::BlobVec::get_allocator() const noexcept
+{
+    return allocator;
+}
+
+void sym2::BlobVec::reallocate(std::size_t newCapacity)
+{
+    assert(newCapacity > inlineCapacity && newCapacity >= count);
+
+    Blob* const storage = allocator.allocate(newCapacity);
+
+    std::copy(first, first + count, storage);
+    release();
+
+    first = storage;
+    cap = newCapacity;
+}
+
+void sym2::BlobVec::release() noexcept
+{
+    if (!isInline())
+        allocator.deallocate(first, cap);
+
+    first = inlineBlobs;
+    cap = inlineCapacity;
+}
+
+void sym2::BlobVec::assign(const Blob* from, std::size_t n)
+{
+    if (n > cap) {
+        // Nothing needs to be preserved, so the old storage can be released first:
+        release();
+        count = 0;
+        reallocate(n);
+    }
+
+    std::copy(from, from + n, first);
+    count = n;
+}
@@ -29,7 +29,7 @@ sym2::ChildIterator sym2::ChildIterator::ChildIterator::singleChildSentinel(Expr
 
 sym2::ExprView<> sym2::ChildIterator::operator*() const noexcept
 {
-    return ExprView<>{op};
+    return ExprView<>{resolveReference(op)};
 }
 
 sym2::ChildIterator::difference_type sym2::ChildIterator::operator-(
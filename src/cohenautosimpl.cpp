@@ -1,5 +1,6 @@
 
 #include "cohenautosimpl.h"
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cmath>
@@ -9,6 +10,7 @@
 #include "sym2/expr.h"
 #include "sym2/get.h"
 #include "sym2/query.h"
+#include "modulararithmetic.h"
 
 namespace sym2 {
     std::optional<LargeInt> exactPower(const LargeInt& n, const std::uint32_t expDenom)
@@ -21,18 +23,74 @@ namespace sym2 {
         else
             return std::nullopt;
     }
+
+    // Exact zero, including the zero of a residue class:
+    bool isZero(ExprView<> e)
+    {
+        return e == 0_ex || (is<modularInt>(e) && get<ModularInt>(e).value == 0);
+    }
+
+    std::size_t nBlobs(ExprView<> e)
+    {
+        return remoteExtent(e.get()) + 1;
+    }
+
+    // Upper bound on the number of Blobs of the large integer n^exp:
+    std::size_t estimatedBlobs(const LargeInt& n, std::int32_t exp)
+    {
+        const std::size_t nBits = n == 0 ? 1 : boost::multiprecision::msb(abs(n)) + 1;
+        const auto absExp = static_cast<std::size_t>(std::abs(static_cast<std::int64_t>(exp)));
+
+        return nBits * absExp / 64 + 2;
+    }
 }
 
-sym2::CohenAutoSimpl::CohenAutoSimpl(Dependencies callbacks, Expr::allocator_type allocator)
+template <class Policy>
+sym2::BasicCohenAutoSimpl<Policy>::BasicCohenAutoSimpl(
+  Dependencies callbacks, Expr::allocator_type allocator, SimplificationCache* cache,
+  SimplificationContext* context)
     : callbacks{std::move(callbacks)}
     , allocator{allocator}
+    , cache{cache}
+    , context{context}
 {}
 
-sym2::Expr sym2::CohenAutoSimpl::simplifySum(std::span<const ExprView<>> ops)
+template <class Policy>
+template <class Simplify>
+sym2::Expr sym2::BasicCohenAutoSimpl<Policy>::memoized(
+  SimplificationCache::Operation op, std::span<const ExprView<>> ops, Simplify&& simplify)
+{
+    if (cache == nullptr && context == nullptr)
+        return simplify();
+
+    if (cache != nullptr) {
+        if (std::optional<Expr> cached = cache->lookup(op, ops, allocator))
+            return Expr{std::move(*cached), allocator};
+    }
+
+    Expr result = simplify();
+
+    if (context != nullptr)
+        context->charge(nBlobs(result));
+    if (cache != nullptr)
+        cache->insert(op, ops, result);
+
+    return Expr{std::move(result), allocator};
+}
+
+template <class Policy>
+sym2::Expr sym2::BasicCohenAutoSimpl<Policy>::simplifySum(std::span<const ExprView<>> ops)
 {
     if (ops.size() == 1)
         return Expr{ops.front(), allocator};
 
+    return memoized(
+      SimplificationCache::Operation::sum, ops, [this, ops]() { return computeSum(ops); });
+}
+
+template <class Policy>
+sym2::Expr sym2::BasicCohenAutoSimpl<Policy>::computeSum(std::span<const ExprView<>> ops)
+{
     const auto res = simplSumIntermediate(ops);
 
     if (res.empty())
@@ -43,12 +101,14 @@ sym2::Expr sym2::CohenAutoSimpl::simplifySum(std::span<const ExprView<>> ops)
         return {CompositeType::sum, std::move(res), allocator};
 }
 
-sym2::Expr sym2::CohenAutoSimpl::simplifySum(ExprView<> lhs, ExprView<> rhs)
+template <class Policy>
+sym2::Expr sym2::BasicCohenAutoSimpl<Policy>::simplifySum(ExprView<> lhs, ExprView<> rhs)
 {
     return simplifySum({{lhs, rhs}});
 }
 
-sym2::ScopedLocalVec<sym2::Expr> sym2::CohenAutoSimpl::simplSumIntermediate(
+template <class Policy>
+sym2::ScopedLocalVec<sym2::Expr> sym2::BasicCohenAutoSimpl<Policy>::simplSumIntermediate(
   std::span<const ExprView<>> ops)
 {
     if (ops.size() == 2)
@@ -57,7 +117,8 @@ sym2::ScopedLocalVec<sym2::Expr> sym2::CohenAutoSimpl::simplSumIntermediate(
         return simplMoreThanTwoSummands(ops);
 }
 
-sym2::ScopedLocalVec<sym2::Expr> sym2::CohenAutoSimpl::simplTwoSummands(
+template <class Policy>
+sym2::ScopedLocalVec<sym2::Expr> sym2::BasicCohenAutoSimpl<Policy>::simplTwoSummands(
   ExprView<> lhs, ExprView<> rhs)
 {
     static const auto asSumOperands = [](ExprView<> e) {
@@ -65,12 +126,14 @@ sym2::ScopedLocalVec<sym2::Expr> sym2::CohenAutoSimpl::simplTwoSummands(
     };
 
     if (is<sum>(lhs) || is<sum>(rhs))
-        return merge(asSumOperands(lhs), asSumOperands(rhs), &CohenAutoSimpl::simplTwoSummands);
+        return merge(
+          asSumOperands(lhs), asSumOperands(rhs), &BasicCohenAutoSimpl::simplTwoSummands);
     else
         return binarySum(lhs, rhs);
 }
 
-sym2::ScopedLocalVec<sym2::Expr> sym2::CohenAutoSimpl::binarySum(
+template <class Policy>
+sym2::ScopedLocalVec<sym2::Expr> sym2::BasicCohenAutoSimpl<Policy>::binarySum(
   ExprView<!sum> lhs, ExprView<!sum> rhs)
 {
     const auto haveEqualNonConstTerm = [lhs, rhs]() {
@@ -81,13 +144,13 @@ sym2::ScopedLocalVec<sym2::Expr> sym2::CohenAutoSimpl::binarySum(
     };
     ScopedLocalVec<Expr> result{allocator};
 
-    if (lhs == 0_ex)
+    if (isZero(lhs))
         result.emplace_back(rhs);
-    else if (rhs == 0_ex)
+    else if (isZero(rhs))
         result.emplace_back(lhs);
     else if (areAll<number>(lhs, rhs)) {
         Expr numSum = callbacks.numericAdd(lhs, rhs);
-        if (numSum != 0_ex)
+        if (!isZero(numSum))
             result.push_back(std::move(numSum));
     } else if (haveEqualNonConstTerm()) {
         // Contract equal non-numeric terms, e.g. 2*a*b + 3*a*b = 5*a*b
@@ -99,7 +162,7 @@ sym2::ScopedLocalVec<sym2::Expr> sym2::CohenAutoSimpl::binarySum(
         assert(is<number>(factor));
 
         // Check for zero summands, e.g. a + b - b = a + 0.
-        if (factor != 0_ex)
+        if (!isZero(factor))
             result.push_back(product);
     } else if (callbacks.orderLessThan(lhs, rhs)) {
         result.emplace_back(lhs);
@@ -112,7 +175,8 @@ sym2::ScopedLocalVec<sym2::Expr> sym2::CohenAutoSimpl::binarySum(
     return result;
 }
 
-sym2::ScopedLocalVec<sym2::Expr> sym2::CohenAutoSimpl::simplMoreThanTwoSummands(
+template <class Policy>
+sym2::ScopedLocalVec<sym2::Expr> sym2::BasicCohenAutoSimpl<Policy>::simplMoreThanTwoSummands(
   std::span<const ExprView<>> ops)
 {
     assert(ops.size() > 2);
@@ -122,14 +186,15 @@ sym2::ScopedLocalVec<sym2::Expr> sym2::CohenAutoSimpl::simplMoreThanTwoSummands(
 
     if (is<sum>(u1))
         return merge(
-          OperandsView::operandsOf(u1), simplifiedRest, &CohenAutoSimpl::simplTwoSummands);
+          OperandsView::operandsOf(u1), simplifiedRest, &BasicCohenAutoSimpl::simplTwoSummands);
     else
         return merge(
-          OperandsView::singleOperand(u1), simplifiedRest, &CohenAutoSimpl::simplTwoSummands);
+          OperandsView::singleOperand(u1), simplifiedRest, &BasicCohenAutoSimpl::simplTwoSummands);
 }
 
+template <class Policy>
 template <class View, class BinarySimplMember>
-sym2::ScopedLocalVec<sym2::Expr> sym2::CohenAutoSimpl::merge(
+sym2::ScopedLocalVec<sym2::Expr> sym2::BasicCohenAutoSimpl<Policy>::merge(
   OperandsView p, View q, BinarySimplMember reduce)
 {
     const auto construct = [this](const auto& from) {
@@ -152,10 +217,16 @@ sym2::ScopedLocalVec<sym2::Expr> sym2::CohenAutoSimpl::merge(
         return mergeNonEmpty(p, q, reduce);
 }
 
+template <class Policy>
 template <class View, class BinarySimplMember>
-sym2::ScopedLocalVec<sym2::Expr> sym2::CohenAutoSimpl::mergeNonEmpty(
+sym2::ScopedLocalVec<sym2::Expr> sym2::BasicCohenAutoSimpl<Policy>::mergeNonEmpty(
   OperandsView p, View q, BinarySimplMember reduce)
 {
+    const SimplificationContext::Descent descent{context};
+
+    if (context != nullptr)
+        context->step();
+
     const auto [p1, pRest] = frontAndRest(p);
     const auto [q1, qRest] = frontAndRest(q);
     const ScopedLocalVec<Expr> firstTwo = std::invoke(reduce, this, p1, q1);
@@ -177,7 +248,8 @@ sym2::ScopedLocalVec<sym2::Expr> sym2::CohenAutoSimpl::mergeNonEmpty(
         return prepend(q1, merge(p, qRest, reduce));
 }
 
-sym2::ScopedLocalVec<sym2::Expr> sym2::CohenAutoSimpl::prepend(
+template <class Policy>
+sym2::ScopedLocalVec<sym2::Expr> sym2::BasicCohenAutoSimpl<Policy>::prepend(
   ExprView<> first, ScopedLocalVec<Expr>&& rest)
 {
     ScopedLocalVec<Expr> result{allocator};
@@ -190,13 +262,22 @@ sym2::ScopedLocalVec<sym2::Expr> sym2::CohenAutoSimpl::prepend(
     return result;
 }
 
-sym2::Expr sym2::CohenAutoSimpl::simplifyProduct(std::span<const ExprView<>> ops)
+template <class Policy>
+sym2::Expr sym2::BasicCohenAutoSimpl<Policy>::simplifyProduct(std::span<const ExprView<>> ops)
 {
     if (ops.size() == 1)
         return Expr{ops.front(), allocator};
-    else if (std::any_of(ops.begin(), ops.end(), [](const ExprView<> op) { return op == 0_ex; }))
-        return Expr{0, allocator};
+    else if (const auto zero = std::find_if(ops.begin(), ops.end(), isZero); zero != ops.end())
+        // A modular zero is returned as it is, so that the result stays in its residue class:
+        return Expr{*zero, allocator};
+
+    return memoized(SimplificationCache::Operation::product, ops,
+      [this, ops]() { return computeProduct(ops); });
+}
 
+template <class Policy>
+sym2::Expr sym2::BasicCohenAutoSimpl<Policy>::computeProduct(std::span<const ExprView<>> ops)
+{
     const ScopedLocalVec<Expr> res = simplProductIntermediate(ops);
 
     if (res.empty())
@@ -207,12 +288,14 @@ sym2::Expr sym2::CohenAutoSimpl::simplifyProduct(std::span<const ExprView<>> ops
         return {CompositeType::product, std::move(res), allocator};
 }
 
-sym2::Expr sym2::CohenAutoSimpl::simplifyProduct(ExprView<> lhs, ExprView<> rhs)
+template <class Policy>
+sym2::Expr sym2::BasicCohenAutoSimpl<Policy>::simplifyProduct(ExprView<> lhs, ExprView<> rhs)
 {
     return simplifyProduct({{lhs, rhs}});
 }
 
-sym2::Expr sym2::CohenAutoSimpl::simplifyProduct(ExprView<> first, OperandsView rest)
+template <class Policy>
+sym2::Expr sym2::BasicCohenAutoSimpl<Policy>::simplifyProduct(ExprView<> first, OperandsView rest)
 {
     ScopedLocalVec<ExprView<>> allOperands{allocator};
     allOperands.reserve(rest.size() + 1);
@@ -223,7 +306,8 @@ sym2::Expr sym2::CohenAutoSimpl::simplifyProduct(ExprView<> first, OperandsView
     return simplifyProduct(allOperands);
 }
 
-sym2::ScopedLocalVec<sym2::Expr> sym2::CohenAutoSimpl::simplProductIntermediate(
+template <class Policy>
+sym2::ScopedLocalVec<sym2::Expr> sym2::BasicCohenAutoSimpl<Policy>::simplProductIntermediate(
   std::span<const ExprView<>> ops)
 {
     if (ops.size() == 2)
@@ -232,7 +316,8 @@ sym2::ScopedLocalVec<sym2::Expr> sym2::CohenAutoSimpl::simplProductIntermediate(
         return simplMoreThanTwoFactors(ops);
 }
 
-sym2::ScopedLocalVec<sym2::Expr> sym2::CohenAutoSimpl::simplTwoFactors(
+template <class Policy>
+sym2::ScopedLocalVec<sym2::Expr> sym2::BasicCohenAutoSimpl<Policy>::simplTwoFactors(
   ExprView<> lhs, ExprView<> rhs)
 {
     static const auto asProductOperands = [](ExprView<> e) {
@@ -241,12 +326,13 @@ sym2::ScopedLocalVec<sym2::Expr> sym2::CohenAutoSimpl::simplTwoFactors(
 
     if (is<product>(lhs) || is<product>(rhs))
         return merge(
-          asProductOperands(lhs), asProductOperands(rhs), &CohenAutoSimpl::simplTwoFactors);
+          asProductOperands(lhs), asProductOperands(rhs), &BasicCohenAutoSimpl::simplTwoFactors);
     else
         return binaryProduct(lhs, rhs);
 }
 
-sym2::ScopedLocalVec<sym2::Expr> sym2::CohenAutoSimpl::binaryProduct(
+template <class Policy>
+sym2::ScopedLocalVec<sym2::Expr> sym2::BasicCohenAutoSimpl<Policy>::binaryProduct(
   ExprView<!product> lhs, ExprView<!product> rhs)
 {
     ScopedLocalVec<Expr> result{allocator};
@@ -277,7 +363,8 @@ sym2::ScopedLocalVec<sym2::Expr> sym2::CohenAutoSimpl::binaryProduct(
     return result;
 }
 
-sym2::ScopedLocalVec<sym2::Expr> sym2::CohenAutoSimpl::simplMoreThanTwoFactors(
+template <class Policy>
+sym2::ScopedLocalVec<sym2::Expr> sym2::BasicCohenAutoSimpl<Policy>::simplMoreThanTwoFactors(
   std::span<const ExprView<>> ops)
 {
     assert(ops.size() > 2);
@@ -287,18 +374,39 @@ sym2::ScopedLocalVec<sym2::Expr> sym2::CohenAutoSimpl::simplMoreThanTwoFactors(
 
     if (is<product>(u1))
         return merge(
-          OperandsView::operandsOf(u1), simplifiedRest, &CohenAutoSimpl::simplTwoFactors);
+          OperandsView::operandsOf(u1), simplifiedRest, &BasicCohenAutoSimpl::simplTwoFactors);
     else
         return merge(
-          OperandsView::singleOperand(u1), simplifiedRest, &CohenAutoSimpl::simplTwoFactors);
+          OperandsView::singleOperand(u1), simplifiedRest, &BasicCohenAutoSimpl::simplTwoFactors);
+}
+
+template <class Policy>
+sym2::Expr sym2::BasicCohenAutoSimpl<Policy>::simplifyPower(ExprView<> base, ExprView<> exp)
+{
+    const std::array<ExprView<>, 2> ops{base, exp};
+
+    return memoized(SimplificationCache::Operation::power, ops,
+      [this, base, exp]() { return computePower(base, exp); });
 }
 
-sym2::Expr sym2::CohenAutoSimpl::simplifyPower(ExprView<> base, ExprView<> exp)
+template <class Policy>
+sym2::Expr sym2::BasicCohenAutoSimpl<Policy>::computePower(ExprView<> base, ExprView<> exp)
 {
     // This might not be fully compliant with Cohen's algorithm outline, but needs to take complex
     // numbers into account and hence some more logic. Trivial cases first...
+    const SimplificationContext::Descent descent{context};
+
+    if (context != nullptr)
+        context->step();
+
     if (base == 1_ex)
         return Expr{base, allocator};
+    // ... modular integers are raised to integer powers within their residue class, but aren't
+    // combined with any other exponent or base...
+    else if (is<modularInt>(base) && is<integer>(exp))
+        return computePowerModularToInt(base, exp);
+    else if (isOneOf<modularInt>(base, exp))
+        return Expr{CompositeType::power, base, exp, allocator};
     else if (base == 0_ex && exp == 0_ex)
         throw std::invalid_argument{"Invalid power with zero base and zero exponent"};
     else if (exp == 0_ex)
@@ -354,7 +462,8 @@ sym2::Expr sym2::CohenAutoSimpl::simplifyPower(ExprView<> base, ExprView<> exp)
     return Expr{CompositeType::power, base, exp, allocator};
 }
 
-sym2::Expr sym2::CohenAutoSimpl::computePowerRationalToInt(
+template <class Policy>
+sym2::Expr sym2::BasicCohenAutoSimpl<Policy>::computePowerRationalToInt(
   ExprView<rational> base, std::int16_t exp)
 {
     assert(exp != 0);
@@ -377,7 +486,8 @@ sym2::Expr sym2::CohenAutoSimpl::computePowerRationalToInt(
     }
 }
 
-sym2::Expr sym2::CohenAutoSimpl::computePowerRationalToUnsigned(
+template <class Policy>
+sym2::Expr sym2::BasicCohenAutoSimpl<Policy>::computePowerRationalToUnsigned(
   ExprView<rational> base, std::uint16_t exp)
 {
     // Copied and adjusted from https://stackoverflow.com/questions/101439.
@@ -385,6 +495,9 @@ sym2::Expr sym2::CohenAutoSimpl::computePowerRationalToUnsigned(
     Expr result{1, allocator};
 
     while (true) {
+        if (context != nullptr)
+            context->step();
+
         if (exp & 1)
             result = simplifyProduct(result, increasingBase);
 
@@ -399,7 +512,8 @@ sym2::Expr sym2::CohenAutoSimpl::computePowerRationalToUnsigned(
     return {std::move(result), allocator};
 }
 
-sym2::Expr sym2::CohenAutoSimpl::simplPowerRationalToRational(
+template <class Policy>
+sym2::Expr sym2::BasicCohenAutoSimpl<Policy>::simplPowerRationalToRational(
   ExprView<rational> base, ExprView<rational && !integer> exp)
 {
     const auto rationalBase = get<LargeRational>(base);
@@ -441,6 +555,12 @@ sym2::Expr sym2::CohenAutoSimpl::simplPowerRationalToRational(
     if (numDenomPart && denomDenomPart) {
         // Now compute the numerator part
         const auto primitiveExpNum = static_cast<std::int32_t>(expNum);
+
+        // Account for the result before it's evaluated, it can be arbitrarily large:
+        if (context != nullptr)
+            context->charge(estimatedBlobs(*numDenomPart, primitiveExpNum)
+              + estimatedBlobs(*denomDenomPart, primitiveExpNum));
+
         const LargeInt newNum = pow(*numDenomPart, primitiveExpNum);
         const LargeInt newDenom = pow(*denomDenomPart, primitiveExpNum);
 
@@ -452,3 +572,29 @@ sym2::Expr sym2::CohenAutoSimpl::simplPowerRationalToRational(
     } else
         return Expr{CompositeType::power, base, exp, allocator};
 }
+
+template <class Policy>
+sym2::Expr sym2::BasicCohenAutoSimpl<Policy>::computePowerModularToInt(
+  ExprView<modularInt> base, ExprView<integer> exp)
+{
+    const auto [value, modulus] = get<ModularInt>(base);
+    const LargeInt n = get<LargeInt>(exp);
+
+    if (value == 0 && n <= 0)
+        throw std::invalid_argument{"Invalid power with zero base and non-positive exponent"};
+    else if (value == 0)
+        return Expr{base, allocator};
+
+    // By Fermat's little theorem, only the exponent modulo p - 1 matters. A negative exponent
+    // hence becomes a positive one, which is a power of the inverse:
+    const LargeInt reducedExp = n % (modulus - 1);
+    const auto positiveExp =
+      static_cast<std::uint64_t>(reducedExp < 0 ? reducedExp + (modulus - 1) : reducedExp);
+    const ModularArithmetic arithmetic{modulus};
+
+    return Expr{ModularInt{arithmetic.power(value, positiveExp), modulus}, allocator};
+}
+
+template class sym2::BasicCohenAutoSimpl<sym2::RuntimeDependencies>;
+template class sym2::BasicCohenAutoSimpl<sym2::StaticDependencies<sym2::orderLessThan>>;
+template class sym2::BasicCohenAutoSimpl<sym2::StaticDependencies<sym2::fastOrderLessThan>>;
@@ -6,23 +6,71 @@
 #include "sym2/expr.h"
 #include "sym2/functionview.h"
 #include "sym2/predicates.h"
+#include "sym2/simplificationcache.h"
+#include "sym2/simplificationcontext.h"
+#include "numberarithmetic.h"
+#include "orderrelation.h"
 
 namespace sym2 {
-    class CohenAutoSimpl {
+    // Callbacks that are dispatched at runtime, for injecting arbitrary order relations and numeric
+    // operations, e.g. in tests:
+    struct RuntimeDependencies {
+        FunctionView<bool(ExprView<>, ExprView<>)> orderLessThan;
+        FunctionView<Expr(ExprView<number>, ExprView<number>)> numericAdd;
+        FunctionView<Expr(ExprView<number>, ExprView<number>)> numericMultiply;
+    };
+
+    // The same as above, but resolved at compile time, so that the calls are direct and can be
+    // inlined into the binary simplification steps:
+    template <bool (*lessThan)(ExprView<>, ExprView<>)>
+    struct StaticDependencies {
+        explicit StaticDependencies(Expr::allocator_type allocator)
+            : numerics{allocator}
+        {}
+
+        bool orderLessThan(ExprView<> lhs, ExprView<> rhs) const
+        {
+            return lessThan(lhs, rhs);
+        }
+
+        Expr numericAdd(ExprView<number> lhs, ExprView<number> rhs)
+        {
+            return numerics.add(lhs, rhs);
+        }
+
+        Expr numericMultiply(ExprView<number> lhs, ExprView<number> rhs)
+        {
+            return numerics.multiply(lhs, rhs);
+        }
+
+        NumberArithmetic numerics;
+    };
+
+    // The policy must provide orderLessThan, numericAdd and numericMultiply with the signatures of
+    // RuntimeDependencies. Instantiations exist for RuntimeDependencies and for StaticDependencies
+    // with orderLessThan and fastOrderLessThan.
+    template <class Policy>
+    class BasicCohenAutoSimpl {
       public:
-        struct Dependencies {
-            FunctionView<bool(ExprView<>, ExprView<>)> orderLessThan;
-            FunctionView<Expr(ExprView<number>, ExprView<number>)> numericAdd;
-            FunctionView<Expr(ExprView<number>, ExprView<number>)> numericMultiply;
-        };
+        using Dependencies = Policy;
 
-        CohenAutoSimpl(Dependencies callbacks, Expr::allocator_type allocator);
+        // Results of the public simplification functions are looked up in and added to the cache,
+        // if there is one. This includes the recursive steps, e.g. powers with merged exponents.
+        // When there is a context, every merge and power step as well as every intermediate result
+        // is accounted for, and SimplificationAborted is thrown once a limit is exceeded.
+        BasicCohenAutoSimpl(Dependencies callbacks, Expr::allocator_type allocator,
+          SimplificationCache* cache = nullptr, SimplificationContext* context = nullptr);
 
         Expr simplifySum(std::span<const ExprView<>> ops);
         Expr simplifyProduct(std::span<const ExprView<>> ops);
         Expr simplifyPower(ExprView<> base, ExprView<> exp);
 
       private:
+        template <class Simplify>
+        Expr memoized(
+          SimplificationCache::Operation op, std::span<const ExprView<>> ops, Simplify&& simplify);
+
+        Expr computeSum(std::span<const ExprView<>> ops);
         Expr simplifySum(ExprView<> lhs, ExprView<> rhs);
         ScopedLocalVec<Expr> simplSumIntermediate(std::span<const ExprView<>> ops);
         ScopedLocalVec<Expr> simplTwoSummands(ExprView<> lhs, ExprView<> rhs);
@@ -35,6 +83,7 @@ namespace sym2 {
         ScopedLocalVec<Expr> mergeNonEmpty(OperandsView p, View q, BinarySimplMember reduce);
         ScopedLocalVec<Expr> prepend(ExprView<> first, ScopedLocalVec<Expr>&& rest);
 
+        Expr computeProduct(std::span<const ExprView<>> ops);
         Expr simplifyProduct(ExprView<> lhs, ExprView<> rhs);
         Expr simplifyProduct(ExprView<> first, OperandsView rest);
         ScopedLocalVec<Expr> simplProductIntermediate(std::span<const ExprView<>> ops);
@@ -42,13 +91,24 @@ namespace sym2 {
         ScopedLocalVec<Expr> binaryProduct(ExprView<!product> lhs, ExprView<!product> rhs);
         ScopedLocalVec<Expr> simplMoreThanTwoFactors(std::span<const ExprView<>> ops);
 
+        Expr computePower(ExprView<> base, ExprView<> exp);
         // The exponent must not be zero:
         Expr computePowerRationalToInt(ExprView<rational> base, std::int16_t exp);
         Expr computePowerRationalToUnsigned(ExprView<rational> base, std::uint16_t exp);
         Expr simplPowerRationalToRational(
           ExprView<rational> base, ExprView<rational && !integer> exp);
+        // Throws std::invalid_argument for a zero base and an exponent <= 0:
+        Expr computePowerModularToInt(ExprView<modularInt> base, ExprView<integer> exp);
 
         Dependencies callbacks;
         Expr::allocator_type allocator;
+        SimplificationCache* cache;
+        SimplificationContext* context;
     };
+
+    extern template class BasicCohenAutoSimpl<RuntimeDependencies>;
+    extern template class BasicCohenAutoSimpl<StaticDependencies<orderLessThan>>;
+    extern template class BasicCohenAutoSimpl<StaticDependencies<fastOrderLessThan>>;
+
+    using CohenAutoSimpl = BasicCohenAutoSimpl<RuntimeDependencies>;
 }
@@ -8,8 +8,32 @@
 #include <numeric>
 #include <stdexcept>
 #include <type_traits>
+#include "modulararithmetic.h"
+#include "orderrelation.h"
 #include "sym2/blob.h"
+#include "sym2/operandsview.h"
 #include "sym2/predicates.h"
+#include "sym2/query.h"
+
+namespace sym2 {
+    namespace {
+        // The primality test dominates the construction of a modular integer, but consecutive
+        // constructions almost always share their modulus:
+        bool isValidModulus(std::uint64_t modulus) noexcept
+        {
+            thread_local std::uint64_t lastValid = 0;
+
+            if (modulus == lastValid)
+                return true;
+            else if (!isSupportedModulus(modulus))
+                return false;
+
+            lastValid = modulus;
+
+            return true;
+        }
+    }
+}
 
 sym2::Expr::Expr(allocator_type allocator)
     : Expr{std::int16_t{0}, allocator}
@@ -53,7 +77,7 @@ sym2::Expr::Expr(double n, allocator_type allocator)
 }
 
 sym2::Expr::Expr(const LargeInt& n, allocator_type allocator)
-    : buffer{[=]() -> LocalVec<Blob> {
+    : buffer{[=]() -> BlobVec {
                  if (fitsInto<std::int16_t>(n))
                      return {{construct(static_cast<std::int16_t>(n))}, allocator};
                  else
@@ -63,24 +87,35 @@ sym2::Expr::Expr(const LargeInt& n, allocator_type allocator)
 {}
 
 sym2::Expr::Expr(const LargeRational& n, allocator_type allocator)
-    : buffer{[=]() -> LocalVec<Blob> {
+    : buffer{[=]() -> BlobVec {
         const auto num = numerator(n);
         const auto denom = denominator(n);
 
         if (fitsInto<std::int16_t>(num) && fitsInto<std::int16_t>(denom))
             return {{construct(static_cast<std::int16_t>(num), static_cast<std::int16_t>(denom))},
               allocator};
+        else if (denom == 1)
+            return constructSequence(num, allocator);
 
         return constructSequence(n, allocator);
     }()}
 {}
 
+sym2::Expr::Expr(ModularInt n, allocator_type allocator)
+    : buffer{[=]() -> BlobVec {
+        if (!isValidModulus(n.modulus))
+            throw std::domain_error{"Modulus must be an odd prime below 2^63"};
+
+        return constructSequence(ModularInt{n.value % n.modulus, n.modulus}, allocator);
+    }()}
+{}
+
 sym2::Expr::Expr(std::string_view symbol, allocator_type allocator)
     : Expr{symbol, DomainFlag::none, allocator}
 {}
 
 sym2::Expr::Expr(std::string_view symbol, DomainFlag domain, allocator_type allocator)
-    : buffer{[=]() -> LocalVec<Blob> {
+    : buffer{[=]() -> BlobVec {
         if (isSmallName(symbol))
             return {{construct(symbol, domain)}, allocator};
         else
@@ -91,8 +126,16 @@ sym2::Expr::Expr(std::string_view symbol, DomainFlag domain, allocator_type allo
         throw std::invalid_argument{"Empty symbol names are invalid"};
 }
 
+sym2::Expr::Expr(SymbolId symbol, allocator_type allocator)
+    : Expr{symbol, DomainFlag::none, allocator}
+{}
+
+sym2::Expr::Expr(SymbolId symbol, DomainFlag domain, allocator_type allocator)
+    : buffer{{construct(symbol, domain)}, allocator}
+{}
+
 sym2::Expr::Expr(std::string_view constant, double value, allocator_type allocator)
-    : buffer{[=]() -> LocalVec<Blob> {
+    : buffer{[=]() -> BlobVec {
         if (constant.empty())
             throw std::invalid_argument{"Constant name must be non-empty"};
         if (!std::isfinite(value))
@@ -120,13 +163,14 @@ namespace sym2 {
     namespace {
         template <class T, class BlobRetrieveFct>
         void constructComposite(CompositeType composite, const std::span<const T> ops,
-          LocalVec<Blob>& buffer, BlobRetrieveFct&& get)
+          BlobVec& buffer, BlobRetrieveFct&& get)
         {
             if (composite == CompositeType::complexNumber
               && (ops.size() != 2
-                || !std::all_of(ops.begin(), ops.end(), is < number && realDomain >)))
-                throw std::invalid_argument(
-                  "Complex numbers must be created with two numeric real-valued arguments");
+                || !std::all_of(
+                  ops.begin(), ops.end(), is < number && !modularInt && realDomain >)))
+                throw std::invalid_argument("Complex numbers must be created with two numeric "
+                                            "real-valued, non-modular arguments");
             else if (composite == CompositeType::power && ops.size() != 2)
                 throw std::invalid_argument("Powers must be created with exactly two operands");
 
@@ -144,13 +188,21 @@ namespace sym2 {
             // operands should be copied.
             buffer.resize(numOperands + 1, Blob{});
 
-            buffer[0] = constructCompositeHeader(composite, numOperands, totalExtent);
-
             for (std::uint16_t i = 0; i < numOperands; ++i) {
                 const Blob* const src = get(ops[i]);
 
                 appendDuplicateSequence(src, i + 1, buffer);
             }
+
+            // Duplicates of operands with shared subtrees can be larger than their remote extent:
+            const auto extent = static_cast<std::uint32_t>(buffer.size() - 1);
+
+            if (extent > std::numeric_limits<std::uint16_t>::max())
+                throw std::range_error{"Can't handle composite expression of given size"};
+
+            buffer[0] = constructCompositeHeader(composite, numOperands, extent);
+
+            computeSummaryInplace(buffer.data());
         }
     }
 }
@@ -171,28 +223,53 @@ sym2::Expr::Expr(CompositeType composite, ExprView<> op1, ExprView<> op2, alloca
     : Expr{composite, {{op1, op2}}, allocator}
 {}
 
-sym2::Expr::Expr(const Expr& other, allocator_type allocator)
-    : buffer{other.buffer, allocator}
+sym2::Expr::Expr(BlobVec&& blobs) noexcept
+    : buffer{std::move(blobs)}
 {}
 
-sym2::Expr::Expr(Expr&& other, allocator_type allocator)
-    : buffer{std::move(other.buffer), allocator}
-{}
+sym2::Expr sym2::shareSubtrees(ExprView<> e, Expr::allocator_type allocator)
+{
+    return Expr{constructSharedSequence(e.get(), allocator)};
+}
 
-sym2::FixedExpr<2> sym2::operator"" _ex(const long double n)
+sym2::Expr sym2::replaceOperand(ExprView<> root, std::span<const std::uint16_t> path,
+  ExprView<> replacement, Expr::allocator_type allocator)
 {
-    return FixedExpr<2>{static_cast<double>(n)};
+    return Expr{constructSplicedSequence(root.get(), path, replacement.get(), allocator)};
 }
 
-sym2::FixedExpr<1> sym2::operator"" _ex(const char* str, const std::size_t length)
+sym2::Expr sym2::insertTerm(
+  ExprView<sum || product> composite, ExprView<> term, Expr::allocator_type allocator)
 {
-    return FixedExpr<1>{std::string_view{str, length}};
+    const OperandsView ops = OperandsView::operandsOf(composite);
+    const auto position = std::lower_bound(ops.begin(), ops.end(), term, orderLessThan);
+    const auto index = static_cast<std::uint16_t>(position - ops.begin());
+
+    return Expr{constructInsertedSequence(composite.get(), index, term.get(), allocator)};
 }
 
-sym2::FixedExpr<1> sym2::operator"" _ex(const unsigned long long n)
+sym2::Expr sym2::removeTerm(
+  ExprView<sum || product> composite, ExprView<> term, Expr::allocator_type allocator)
 {
-    if (n > static_cast<unsigned long long>(std::numeric_limits<std::int16_t>::max()))
-        throw std::domain_error("Small integers must fit into 16 bits");
+    const auto index = findTerm(composite, term);
+
+    if (!index)
+        return Expr{composite, allocator};
+    else if (nOperands(composite) == 2)
+        return Expr{nthOperand(composite, *index == 0 ? 1 : 0), allocator};
+
+    return Expr{constructErasedSequence(composite.get(), *index, allocator)};
+}
+
+sym2::Expr::Expr(const Expr& other, allocator_type allocator)
+    : buffer{other.buffer, allocator}
+{}
+
+sym2::Expr::Expr(Expr&& other, allocator_type allocator)
+    : buffer{std::move(other.buffer), allocator}
+{}
 
-    return FixedExpr<1>{static_cast<std::int16_t>(n)};
+sym2::FixedExpr<2> sym2::operator"" _ex(const long double n)
+{
+    return FixedExpr<2>{static_cast<double>(n)};
 }
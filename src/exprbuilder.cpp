@@ -0,0 +1,157 @@
+
+#include "sym2/exprbuilder.h"
+#include <algorithm>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include "sym2/blob.h"
+#include "sym2/predicates.h"
+
+sym2::ExprBuilder::ExprBuilder(allocator_type allocator)
+    : blobs{allocator}
+    , operandPositions{allocator}
+    , frames{allocator}
+    , scratch{allocator}
+{}
+
+void sym2::ExprBuilder::open(CompositeType composite)
+{
+    const std::uint32_t position = beginOperand();
+    const bool binary =
+      composite == CompositeType::power || composite == CompositeType::complexNumber;
+
+    blobs.push_back(constructCompositeHeader(composite, 0, 0));
+
+    openFrame(position, binary ? 2 : 0);
+}
+
+void sym2::ExprBuilder::openFunction(std::string_view name, UnaryDoubleFctPtr eval)
+{
+    const std::uint32_t position = beginOperand();
+
+    appendFunctionPrefix(name, eval, blobs);
+
+    openFrame(position, 1);
+}
+
+void sym2::ExprBuilder::openFunction(std::string_view name, BinaryDoubleFctPtr eval)
+{
+    const std::uint32_t position = beginOperand();
+
+    appendFunctionPrefix(name, eval, blobs);
+
+    openFrame(position, 2);
+}
+
+void sym2::ExprBuilder::push(ExprView<> e)
+{
+    const std::uint32_t position = beginOperand();
+
+    try {
+        appendDuplicateSequence(e.get(), position, blobs);
+        addOperand(position);
+    } catch (...) {
+        blobs.resize(position);
+        throw;
+    }
+}
+
+void sym2::ExprBuilder::close()
+{
+    if (frames.empty())
+        throw std::logic_error{"There is no open composite to close"};
+
+    const Frame frame = frames.back();
+    const std::span<const std::uint32_t> operands{
+      operandPositions.begin() + static_cast<std::ptrdiff_t>(frame.firstOperand),
+      operandPositions.end()};
+
+    validateOperands(frame, operands);
+
+    scratch.resize(operands.size());
+
+    finishCompositeInplace(std::span<Blob>{blobs.begin() + frame.header, blobs.end()}, operands,
+      std::span<Blob>{scratch.begin(), scratch.end()});
+
+    operandPositions.resize(frame.firstOperand);
+    frames.pop_back();
+}
+
+std::size_t sym2::ExprBuilder::depth() const noexcept
+{
+    return frames.size();
+}
+
+sym2::Expr sym2::ExprBuilder::finish()
+{
+    if (!frames.empty())
+        throw std::logic_error{"Can't finish an expression with open composites"};
+    else if (blobs.empty())
+        throw std::logic_error{"Can't finish an empty expression"};
+
+    BlobVec result{std::move(blobs)};
+
+    // Inline Blobs are copied upon moving, so the source isn't necessarily empty:
+    blobs.resize(0);
+
+    return Expr{std::move(result)};
+}
+
+sym2::ExprBuilder::allocator_type sym2::ExprBuilder::get_allocator() const noexcept
+{
+    return blobs.get_allocator();
+}
+
+std::uint32_t sym2::ExprBuilder::beginOperand() const
+{
+    if (frames.empty() && !blobs.empty())
+        throw std::logic_error{"The builder already holds a complete expression"};
+    else if (blobs.size() > std::numeric_limits<std::uint32_t>::max())
+        throw std::length_error{"ExprBuilder can't hold more than 2^32 - 1 Blobs"};
+
+    return static_cast<std::uint32_t>(blobs.size());
+}
+
+void sym2::ExprBuilder::addOperand(std::uint32_t position)
+{
+    // Positions are relative to the header of the innermost open composite, as required by
+    // finishCompositeInplace:
+    if (!frames.empty())
+        operandPositions.push_back(position - frames.back().header);
+}
+
+void sym2::ExprBuilder::openFrame(std::uint32_t header, std::size_t arity)
+{
+    addOperand(header);
+    frames.push_back({header, operandPositions.size(), arity});
+
+    // The name of a function is stored as its first operand, see appendFunctionPrefix:
+    if (isFunctionHeader(blobs[header]))
+        operandPositions.push_back(2);
+}
+
+void sym2::ExprBuilder::validateOperands(
+  const Frame& frame, std::span<const std::uint32_t> operands) const
+{
+    const Blob* const header = blobs.data() + frame.header;
+    const std::size_t nLogical = isFunctionHeader(*header) ? operands.size() - 1 : operands.size();
+
+    if (frame.arity == 0 || nLogical == frame.arity) {
+        if (!isComplexNumberHeader(*header))
+            return;
+        else if (std::all_of(operands.begin(), operands.end(), [header](std::uint32_t position) {
+                     const ExprView<> part{header + position};
+
+                     return is < number && !modularInt && realDomain > (part);
+                 }))
+            return;
+    }
+
+    if (isPowerHeader(*header))
+        throw std::invalid_argument("Powers must be created with exactly two operands");
+    else if (isComplexNumberHeader(*header))
+        throw std::invalid_argument("Complex numbers must be created with two numeric "
+                                    "real-valued, non-modular arguments");
+    else
+        throw std::invalid_argument("Number of function arguments doesn't match its evaluation");
+}
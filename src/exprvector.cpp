@@ -0,0 +1,183 @@
+
+#include "sym2/exprvector.h"
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include "sym2/blob.h"
+#include "sym2/expr.h"
+#include "sym2/parallel.h"
+
+sym2::ExprVector::ExprVector(allocator_type allocator)
+    : blobs{allocator}
+    , offsets{allocator}
+{}
+
+std::size_t sym2::ExprVector::size() const noexcept
+{
+    return offsets.size();
+}
+
+std::size_t sym2::ExprVector::nBlobs() const noexcept
+{
+    return blobs.size();
+}
+
+bool sym2::ExprVector::empty() const noexcept
+{
+    return offsets.empty();
+}
+
+sym2::ExprView<> sym2::ExprVector::operator[](std::size_t index) const noexcept
+{
+    assert(index < offsets.size());
+
+    return ExprView<>{blobs.data() + offsets[index]};
+}
+
+sym2::ExprVector::Iterator sym2::ExprVector::begin() const noexcept
+{
+    return Iterator{this, 0};
+}
+
+sym2::ExprVector::Iterator sym2::ExprVector::end() const noexcept
+{
+    return Iterator{this, size()};
+}
+
+void sym2::ExprVector::reserve(std::size_t nExprs, std::size_t nBlobs)
+{
+    offsets.reserve(nExprs);
+    blobs.reserve(nBlobs);
+}
+
+void sym2::ExprVector::push_back(ExprView<> e)
+{
+    const std::less<const Blob*> less{};
+
+    if (!less(e.get(), blobs.begin()) && less(e.get(), blobs.end())) {
+        // Growing the buffer would invalidate the argument, so duplicate it first:
+        const Expr copy{e, blobs.get_allocator()};
+
+        push_back(copy);
+        return;
+    }
+
+    const std::size_t offset = blobs.size();
+
+    offsets.push_back(static_cast<std::uint32_t>(offset));
+
+    try {
+        // The duplicate can be larger than the expression when it shares subtrees with others:
+        appendDuplicateSequence(e.get(), offset, blobs);
+
+        if (blobs.size() > std::numeric_limits<std::uint32_t>::max())
+            throw std::length_error{"ExprVector can't hold more than 2^32 - 1 Blobs"};
+    } catch (...) {
+        blobs.resize(offset);
+        offsets.pop_back();
+        throw;
+    }
+}
+
+void sym2::ExprVector::append(std::span<const ExprVector> parts)
+{
+    // Index of the first expression and the first Blob of each part in this container:
+    LocalVec<std::pair<std::size_t, std::size_t>> starts{LocalAlloc<>{}};
+    std::size_t nExprs = size();
+    std::size_t nTotalBlobs = blobs.size();
+
+    starts.reserve(parts.size());
+
+    for (const ExprVector& part : parts) {
+        starts.emplace_back(nExprs, nTotalBlobs);
+        nExprs += part.size();
+        nTotalBlobs += part.nBlobs();
+    }
+
+    if (nTotalBlobs > std::numeric_limits<std::uint32_t>::max())
+        throw std::length_error{"ExprVector can't hold more than 2^32 - 1 Blobs"};
+
+    blobs.resize(nTotalBlobs);
+    offsets.resize(nExprs);
+
+    // Blobs of an appended expression are relative to its root, so only the offsets are shifted:
+    parallelFor(parts.size(), [&](std::size_t i) {
+        const ExprVector& part = parts[i];
+        const auto [firstExpr, firstBlob] = starts[i];
+        const auto shift = static_cast<std::uint32_t>(firstBlob);
+
+        std::copy(part.blobs.begin(), part.blobs.end(), blobs.begin() + firstBlob);
+        std::transform(part.offsets.begin(), part.offsets.end(), offsets.begin() + firstExpr,
+          [shift](std::uint32_t offset) { return offset + shift; });
+    });
+}
+
+void sym2::ExprVector::pop_back() noexcept
+{
+    assert(!empty());
+
+    blobs.resize(offsets.back());
+    offsets.pop_back();
+}
+
+void sym2::ExprVector::clear() noexcept
+{
+    truncate(0, 0);
+}
+
+sym2::ExprVector::allocator_type sym2::ExprVector::get_allocator() const noexcept
+{
+    return blobs.get_allocator();
+}
+
+std::uint32_t sym2::ExprVector::moveTowardsFront(
+  std::size_t from, std::size_t to, std::uint32_t offset)
+{
+    assert(to <= from && offset <= offsets[from]);
+
+    const std::uint32_t first = offsets[from];
+    const std::uint32_t last = endOf(from);
+
+    // Blobs of an appended expression are relative to its root, so they can be moved as a whole:
+    std::copy(blobs.begin() + first, blobs.begin() + last, blobs.begin() + offset);
+    offsets[to] = offset;
+
+    return offset + (last - first);
+}
+
+void sym2::ExprVector::truncate(std::size_t nExprs, std::uint32_t nBlobs) noexcept
+{
+    blobs.resize(nBlobs);
+    offsets.resize(nExprs);
+}
+
+std::uint32_t sym2::ExprVector::endOf(std::size_t index) const noexcept
+{
+    return index + 1 < offsets.size() ? offsets[index + 1]
+                                      : static_cast<std::uint32_t>(blobs.size());
+}
+
+sym2::ExprVector::Iterator::Iterator(const ExprVector* exprs, std::size_t index) noexcept
+    : exprs{exprs}
+    , index{index}
+{}
+
+sym2::ExprView<> sym2::ExprVector::Iterator::operator*() const noexcept
+{
+    return (*exprs)[index];
+}
+
+sym2::ExprVector::Iterator::difference_type sym2::ExprVector::Iterator::operator-(
+  Iterator rhs) const noexcept
+{
+    return static_cast<difference_type>(index) - static_cast<difference_type>(rhs.index);
+}
+
+sym2::ExprVector::Iterator& sym2::ExprVector::Iterator::operator+=(difference_type n) noexcept
+{
+    index = static_cast<std::size_t>(static_cast<difference_type>(index) + n);
+
+    return *this;
+}
@@ -0,0 +1,186 @@
+
+#include "sym2/foldnumeric.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <complex>
+#include <functional>
+#include <optional>
+#include "sym2/autosimpl.h"
+#include "sym2/eval.h"
+#include "sym2/get.h"
+#include "sym2/operandsview.h"
+#include "sym2/predicates.h"
+#include "sym2/query.h"
+
+namespace sym2 {
+    namespace {
+        struct Folded {
+            ExprView<> original;
+            bool evaluable;
+            bool inexact;
+            // Index into the replacements of the parent, empty when the subtree is unchanged. Also
+            // empty for evaluable, inexact subtrees, as only the parent can decide whether they
+            // are maximal and hence to be folded.
+            std::optional<std::size_t> replacement;
+
+            bool foldable() const
+            {
+                return evaluable && inexact;
+            }
+        };
+
+        std::complex<double> evalNumerically(ExprView<> e)
+        {
+            return evalComplex(e, [](auto&&...) {
+                assert(false);
+                return 0.0;
+            });
+        }
+
+        // Returns the index of the appended number, or nothing if the value isn't finite.
+        std::optional<std::size_t> appendNumber(
+          std::complex<double> value, ScopedLocalVec<Expr>& replacements)
+        {
+            if (!std::isfinite(value.real()) || !std::isfinite(value.imag()))
+                return std::nullopt;
+            else if (value.imag() == 0.0)
+                replacements.emplace_back(value.real());
+            else {
+                const FixedExpr<2> re{value.real()};
+                const FixedExpr<2> im{value.imag()};
+
+                replacements.emplace_back(CompositeType::complexNumber, re, im);
+            }
+
+            return replacements.size() - 1;
+        }
+
+        bool isInexactNumber(ExprView<number> n)
+        {
+            return is<floatingPoint>(real(n)) || is<floatingPoint>(imag(n));
+        }
+
+        // Folds all numerically evaluable operands of a sum or product into one number, when at
+        // least one of them is inexact. Returns false if nothing needs to be done.
+        template <class BinaryOp>
+        bool foldNaryOperands(LocalVec<Folded>& ops, std::complex<double> init, BinaryOp op,
+          ScopedLocalVec<Expr>& replacements)
+        {
+            const auto inexactEnd =
+              std::partition(ops.begin(), ops.end(), std::mem_fn(&Folded::foldable));
+            const auto evaluableEnd =
+              std::partition(inexactEnd, ops.end(), std::mem_fn(&Folded::evaluable));
+
+            if (inexactEnd == ops.begin())
+                return false;
+            else if (std::next(ops.begin()) == evaluableEnd && is<number>(ops.front().original))
+                return false;
+
+            const std::complex<double> value = std::transform_reduce(ops.begin(), evaluableEnd,
+              init, op, [](const Folded& f) { return evalNumerically(f.original); });
+            const std::optional<std::size_t> folded = appendNumber(value, replacements);
+
+            if (!folded)
+                return false;
+
+            ops.erase(std::next(ops.begin()), evaluableEnd);
+            ops.front().replacement = folded;
+
+            return true;
+        }
+
+        Expr rebuild(ExprView<composite> e, std::span<const ExprView<>> ops,
+          Expr::allocator_type allocator)
+        {
+            if (is<sum>(e))
+                return autoSum(ops, allocator);
+            else if (is<product>(e))
+                return autoProduct(ops, allocator);
+            else if (is<power>(e))
+                return autoPower(ops[0], ops[1], allocator);
+
+            assert(is<function>(e));
+
+            const auto name = get<std::string_view>(e);
+
+            if (ops.size() == 1)
+                return Expr{name, ops[0], get<UnaryDoubleFctPtr>(e), allocator};
+
+            assert(ops.size() == 2);
+
+            return Expr{name, ops[0], ops[1], get<BinaryDoubleFctPtr>(e), allocator};
+        }
+
+        Folded fold(ExprView<> e, ScopedLocalVec<Expr>& parentReplacements)
+        {
+            if (is<symbol>(e))
+                return {e, false, false, std::nullopt};
+            else if (is<number>(e))
+                return {e, true, isInexactNumber(e), std::nullopt};
+            else if (is<constant>(e))
+                return {e, true, false, std::nullopt};
+
+            assert(is<composite>(e));
+
+            // Replacements of the operands are only needed until this node is rebuilt, so they
+            // are backed by this arena:
+            StackBuffer<1024> arena;
+            ScopedLocalVec<Expr> replacements{&arena};
+            LocalVec<Folded> ops{&arena};
+
+            ops.reserve(nOperands(e));
+
+            for (const ExprView<> op : OperandsView::operandsOf(e))
+                ops.push_back(fold(op, replacements));
+
+            const bool evaluable =
+              std::all_of(ops.cbegin(), ops.cend(), std::mem_fn(&Folded::evaluable));
+            const bool inexact =
+              std::any_of(ops.cbegin(), ops.cend(), std::mem_fn(&Folded::inexact));
+            bool changed = false;
+
+            if (evaluable && inexact)
+                return {e, true, true, std::nullopt};
+            else if (is<sum>(e))
+                changed = foldNaryOperands(ops, {0.0, 0.0}, std::plus<>{}, replacements);
+            else if (is<product>(e))
+                changed = foldNaryOperands(ops, {1.0, 0.0}, std::multiplies<>{}, replacements);
+
+            for (Folded& op : ops)
+                if (!op.replacement && op.foldable() && !is<number>(op.original))
+                    op.replacement = appendNumber(evalNumerically(op.original), replacements);
+
+            changed = changed || !replacements.empty();
+
+            if (!changed)
+                return {e, evaluable, inexact, std::nullopt};
+
+            LocalVec<ExprView<>> views{&arena};
+
+            views.reserve(ops.size());
+
+            for (const Folded& op : ops)
+                views.push_back(op.replacement ? replacements[*op.replacement] : op.original);
+
+            parentReplacements.emplace_back(
+              rebuild(e, views, parentReplacements.get_allocator().outer_allocator()));
+
+            return {e, evaluable, inexact, parentReplacements.size() - 1};
+        }
+    }
+}
+
+sym2::Expr sym2::foldNumeric(ExprView<> e, Expr::allocator_type allocator)
+{
+    ScopedLocalVec<Expr> result{allocator};
+    Folded root = fold(e, result);
+
+    if (root.foldable() && !is<number>(e))
+        root.replacement = appendNumber(evalNumerically(e), result);
+
+    if (root.replacement)
+        return Expr{result[*root.replacement], allocator};
+
+    return Expr{e, allocator};
+}
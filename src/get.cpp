@@ -72,6 +72,14 @@ sym2::LargeRational sym2::get<sym2::LargeRational>(ExprView<> e)
     }
 }
 
+template <>
+sym2::ModularInt sym2::get<sym2::ModularInt>(ExprView<> e)
+{
+    assert((is<modularInt>(e)));
+
+    return getModularInt(e.get());
+}
+
 template <>
 std::string_view sym2::get<std::string_view>(ExprView<> e)
 {
@@ -85,6 +93,14 @@ std::string_view sym2::get<std::string_view>(ExprView<> e)
         return getFunctionName(e.get());
 }
 
+template <>
+sym2::SymbolId sym2::get<sym2::SymbolId>(ExprView<> e)
+{
+    assert((is<internedSymbol>(e)));
+
+    return getSymbolId(*e.get());
+}
+
 template <>
 sym2::UnaryDoubleFctPtr sym2::get<sym2::UnaryDoubleFctPtr>(ExprView<> e)
 {
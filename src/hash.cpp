@@ -0,0 +1,19 @@
+
+#include "sym2/hash.h"
+#include <boost/container_hash/hash.hpp>
+#include "sym2/blob.h"
+
+std::size_t sym2::hash(ExprView<> e) noexcept
+{
+    return hash(e.get());
+}
+
+std::size_t sym2::hash(OperandsView ops) noexcept
+{
+    std::size_t seed = ops.size();
+
+    for (const ExprView<> op : ops)
+        boost::hash_combine(seed, hash(op));
+
+    return seed;
+}
@@ -0,0 +1,165 @@
+#include "modulararithmetic.h"
+#include <array>
+#include <cassert>
+
+namespace sym2 {
+    namespace {
+        // Sufficient for a deterministic Miller-Rabin test of all 64 bit integers:
+        constexpr std::array<std::uint64_t, 12> witnesses{
+          2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+
+        bool isStrongProbablePrime(
+          const ModularArithmetic& arithmetic, std::uint64_t witness) noexcept
+        {
+            const std::uint64_t n = arithmetic.modulus();
+            std::uint64_t d = n - 1;
+            int s = 0;
+
+            for (; d % 2 == 0; ++s)
+                d /= 2;
+
+            std::uint64_t x = arithmetic.power(witness, d);
+
+            if (x == 1 || x == n - 1)
+                return true;
+
+            for (int i = 1; i < s; ++i) {
+                x = arithmetic.multiply(x, x);
+
+                if (x == n - 1)
+                    return true;
+            }
+
+            return false;
+        }
+    }
+}
+
+bool sym2::isSupportedModulus(const std::uint64_t n) noexcept
+{
+    if (n < 3 || n % 2 == 0 || n >= std::uint64_t{1} << 63)
+        return false;
+
+    for (const std::uint64_t witness : witnesses)
+        if (n == witness)
+            return true;
+        else if (n % witness == 0)
+            return false;
+
+    const ModularArithmetic arithmetic{n};
+
+    for (const std::uint64_t witness : witnesses)
+        if (!isStrongProbablePrime(arithmetic, witness))
+            return false;
+
+    return true;
+}
+
+sym2::ModularArithmetic::ModularArithmetic(const std::uint64_t modulus) noexcept
+    : p{modulus}
+{
+    assert(p % 2 == 1 && p < std::uint64_t{1} << 63);
+
+    // Newton iteration for p^-1 mod 2^64, every step doubles the number of correct low bits. The
+    // initial guess p is correct for three bits, as p*p = 1 mod 8 for odd p:
+    std::uint64_t inverse = p;
+
+    for (int i = 0; i < 5; ++i)
+        inverse *= 2 - p * inverse;
+
+    negInverse = -inverse;
+    one = -p % p;
+    rSquared = static_cast<std::uint64_t>(Wide{one} * one % p);
+}
+
+std::uint64_t sym2::ModularArithmetic::modulus() const noexcept
+{
+    return p;
+}
+
+std::uint64_t sym2::ModularArithmetic::add(
+  const std::uint64_t lhs, const std::uint64_t rhs) const noexcept
+{
+    // No overflow, as p < 2^63:
+    const std::uint64_t result = lhs + rhs;
+
+    return result >= p ? result - p : result;
+}
+
+std::uint64_t sym2::ModularArithmetic::subtract(
+  const std::uint64_t lhs, const std::uint64_t rhs) const noexcept
+{
+    return lhs >= rhs ? lhs - rhs : lhs + (p - rhs);
+}
+
+std::uint64_t sym2::ModularArithmetic::multiply(
+  const std::uint64_t lhs, const std::uint64_t rhs) const noexcept
+{
+    // The first reduction yields lhs*rhs*R^-1, the second one cancels the R^-1:
+    return reduce(Wide{reduce(Wide{lhs} * rhs)} * rSquared);
+}
+
+std::uint64_t sym2::ModularArithmetic::power(
+  const std::uint64_t base, std::uint64_t exp) const noexcept
+{
+    std::uint64_t square = toMontgomery(base);
+    std::uint64_t result = one;
+
+    for (; exp != 0; exp /= 2) {
+        if (exp % 2 == 1)
+            result = reduce(Wide{result} * square);
+
+        square = reduce(Wide{square} * square);
+    }
+
+    return reduce(result);
+}
+
+std::uint64_t sym2::ModularArithmetic::inverse(const std::uint64_t n) const noexcept
+{
+    assert(n != 0);
+
+    return power(n, p - 2);
+}
+
+std::uint64_t sym2::ModularArithmetic::residue(const std::int64_t n) const noexcept
+{
+    const std::int64_t remainder = n % static_cast<std::int64_t>(p);
+
+    return static_cast<std::uint64_t>(remainder < 0 ? remainder + static_cast<std::int64_t>(p)
+                                                    : remainder);
+}
+
+std::uint64_t sym2::ModularArithmetic::residue(const LargeInt& n) const
+{
+    LargeInt remainder = n % p;
+
+    if (remainder < 0)
+        remainder += p;
+
+    return static_cast<std::uint64_t>(remainder);
+}
+
+std::optional<std::uint64_t> sym2::ModularArithmetic::residue(const LargeRational& n) const
+{
+    const std::uint64_t denom = residue(denominator(n));
+
+    if (denom == 0)
+        return std::nullopt;
+
+    return multiply(residue(numerator(n)), inverse(denom));
+}
+
+std::uint64_t sym2::ModularArithmetic::reduce(const Wide t) const noexcept
+{
+    const std::uint64_t m = static_cast<std::uint64_t>(t) * negInverse;
+    // t + m*p is divisible by R and smaller than 2*p*R < 2^128, the quotient is below 2*p:
+    const std::uint64_t result = static_cast<std::uint64_t>((t + Wide{m} * p) >> 64);
+
+    return result >= p ? result - p : result;
+}
+
+std::uint64_t sym2::ModularArithmetic::toMontgomery(const std::uint64_t n) const noexcept
+{
+    return reduce(Wide{n} * rSquared);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include "sym2/largerational.h"
+
+namespace sym2 {
+    // True for odd primes below 2^63, the moduli that ModularArithmetic supports. Deterministic
+    // Miller-Rabin test, with a set of bases that is known to be sufficient for 64 bit integers.
+    bool isSupportedModulus(std::uint64_t n) noexcept;
+
+    // Arithmetic in the integers modulo a prime p as accepted by isSupportedModulus. Products are
+    // computed with Montgomery reduction (R = 2^64), which replaces the 128 bit division by two
+    // multiplications. The constants only depend on the modulus and are computed once upon
+    // construction. All operands and results are canonical residues in [0, p), UB otherwise.
+    class ModularArithmetic {
+      public:
+        explicit ModularArithmetic(std::uint64_t modulus) noexcept;
+
+        std::uint64_t modulus() const noexcept;
+
+        std::uint64_t add(std::uint64_t lhs, std::uint64_t rhs) const noexcept;
+        std::uint64_t subtract(std::uint64_t lhs, std::uint64_t rhs) const noexcept;
+        std::uint64_t multiply(std::uint64_t lhs, std::uint64_t rhs) const noexcept;
+        std::uint64_t power(std::uint64_t base, std::uint64_t exp) const noexcept;
+        // Via Fermat's little theorem, UB for zero:
+        std::uint64_t inverse(std::uint64_t n) const noexcept;
+
+        std::uint64_t residue(std::int64_t n) const noexcept;
+        std::uint64_t residue(const LargeInt& n) const;
+        // Returns std::nullopt if the denominator is a multiple of the modulus:
+        std::optional<std::uint64_t> residue(const LargeRational& n) const;
+
+      private:
+        __extension__ typedef unsigned __int128 Wide;
+
+        // Montgomery reduction, t * R^-1 mod p for t < p*R:
+        std::uint64_t reduce(Wide t) const noexcept;
+        std::uint64_t toMontgomery(std::uint64_t n) const noexcept;
+
+        std::uint64_t p;
+        std::uint64_t negInverse; // -p^-1 mod R
+        std::uint64_t rSquared; // R^2 mod p
+        std::uint64_t one; // R mod p, i.e., 1 in Montgomery form
+    };
+}
@@ -1,18 +1,91 @@
 
 #include "numberarithmetic.h"
-#include <array>
+#include <cstdint>
 #include <functional>
+#include <stdexcept>
+#include <tuple>
 #include "sym2/get.h"
 #include "sym2/query.h"
 #include "sym2/smallrational.h"
 
+namespace sym2 {
+    namespace {
+        // Parts of the complex operands a + b*i and c + d*i, where one of them might be real:
+        struct ComplexOperands {
+            ComplexOperands(ExprView<number> lhs, ExprView<number> rhs)
+                : a{real(lhs)}
+                , b{imag(lhs)}
+                , c{real(rhs)}
+                , d{imag(rhs)}
+            {}
+
+            template <class T>
+            std::tuple<T, T, T, T> get() const
+            {
+                return {sym2::get<T>(a), sym2::get<T>(b), sym2::get<T>(c), sym2::get<T>(d)};
+            }
+
+            ExprView<number> a;
+            ExprView<number> b;
+            ExprView<number> c;
+            ExprView<number> d;
+        };
+
+        // Exact w*x + sign*y*z, products of four 16 bit values and their sum fit into 64 bit:
+        LargeRational sumOfProducts(
+          SmallRational w, SmallRational x, int sign, SmallRational y, SmallRational z)
+        {
+            const std::int64_t wx = std::int64_t{w.num} * x.num * y.denom * z.denom;
+            const std::int64_t yz = std::int64_t{y.num} * z.num * w.denom * x.denom;
+            const std::int64_t denom = std::int64_t{w.denom} * x.denom * y.denom * z.denom;
+
+            return LargeRational{wx + sign * yz, denom};
+        }
+
+        std::uint64_t residue(const ModularArithmetic& arithmetic, ExprView<number> n)
+        {
+            std::optional<std::uint64_t> result;
+
+            if (is<modularInt>(n)) {
+                const auto [value, modulus] = get<ModularInt>(n);
+
+                if (modulus != arithmetic.modulus())
+                    throw std::domain_error{"Modular integers with different moduli"};
+
+                return value;
+            } else if (is < small && integer > (n))
+                return arithmetic.residue(std::int64_t{get<std::int16_t>(n)});
+            else if (is < small && rational > (n)) {
+                const auto [num, denom] = get<SmallRational>(n);
+                const std::uint64_t denomResidue = arithmetic.residue(std::int64_t{denom});
+
+                if (denomResidue != 0)
+                    result = arithmetic.multiply(
+                      arithmetic.residue(std::int64_t{num}), arithmetic.inverse(denomResidue));
+            } else if (is<integer>(n))
+                return arithmetic.residue(get<LargeInt>(n));
+            else if (is<rational>(n))
+                result = arithmetic.residue(get<LargeRational>(n));
+            else
+                throw std::domain_error{"Modular integers only combine with rational numbers"};
+
+            if (!result)
+                throw std::domain_error{"Denominator isn't invertible modulo the given prime"};
+
+            return *result;
+        }
+    }
+}
+
 sym2::NumberArithmetic::NumberArithmetic(const Expr::allocator_type allocator)
     : allocator{allocator}
 {}
 
 sym2::Expr sym2::NumberArithmetic::multiply(ExprView<number> lhs, ExprView<number> rhs)
 {
-    if (isOneOf<complexDomain>(lhs, rhs))
+    if (isOneOf<modularInt>(lhs, rhs))
+        return reduceViaModularArithmetic(&ModularArithmetic::multiply, lhs, rhs);
+    else if (isOneOf<complexDomain>(lhs, rhs))
         return multiplyComplex(lhs, rhs);
     else if (areAll<rational>(lhs, rhs))
         return reduceViaLargeRational(std::multiplies<>{}, lhs, rhs);
@@ -22,14 +95,26 @@ sym2::Expr sym2::NumberArithmetic::multiply(ExprView<number> lhs, ExprView<numbe
 
 sym2::Expr sym2::NumberArithmetic::multiplyComplex(ExprView<number> lhs, ExprView<number> rhs)
 {
-    // The operands might not be both complex numbers, >= one should be at this point.
-    const Expr real1 = multiply(real(lhs), real(rhs));
-    const Expr imag1 = multiply(real(lhs), imag(rhs));
-    const Expr imag2 = multiply(imag(lhs), real(rhs));
-    const Expr real2 = multiply(imag(lhs), imag(rhs));
-    const std::array<Expr, 2> operands{{subtract(real1, real2), add(imag1, imag2)}};
-
-    return Expr{CompositeType::complexNumber, operands, allocator};
+    // (a + b*i)*(c + d*i) = (a*c - b*d) + (a*d + b*c)*i. The operands might not be both complex
+    // numbers, >= one should be at this point. Both parts depend on all of a, b, c and d, so both
+    // are floating point numbers as soon as one of them is.
+    const ComplexOperands ops{lhs, rhs};
+    StackBuffer<512> arena;
+
+    if (isOneOf<floatingPoint>(ops.a, ops.b, ops.c, ops.d)) {
+        const auto [a, b, c, d] = ops.get<double>();
+
+        return complexNumber(Expr{a * c - b * d, &arena}, Expr{a * d + b * c, &arena});
+    } else if (areAll < small && rational > (ops.a, ops.b, ops.c, ops.d)) {
+        const auto [a, b, c, d] = ops.get<SmallRational>();
+
+        return complexNumber(Expr{sumOfProducts(a, c, -1, b, d), &arena},
+          Expr{sumOfProducts(a, d, 1, b, c), &arena});
+    }
+
+    const auto [a, b, c, d] = ops.get<LargeRational>();
+
+    return complexNumber(Expr{a * c - b * d, &arena}, Expr{a * d + b * c, &arena});
 }
 
 template <class Operation>
@@ -50,9 +135,26 @@ sym2::Expr sym2::NumberArithmetic::reduceViaFloatingPoint(
     return Expr{result, allocator};
 }
 
+template <class Operation>
+sym2::Expr sym2::NumberArithmetic::reduceViaModularArithmetic(
+  Operation op, ExprView<number> lhs, ExprView<number> rhs)
+{
+    const std::uint64_t modulus = get<ModularInt>(is<modularInt>(lhs) ? lhs : rhs).modulus;
+
+    if (!modular || modular->modulus() != modulus)
+        modular.emplace(modulus);
+
+    const std::uint64_t result =
+      std::invoke(op, *modular, residue(*modular, lhs), residue(*modular, rhs));
+
+    return Expr{ModularInt{result, modulus}, allocator};
+}
+
 sym2::Expr sym2::NumberArithmetic::add(ExprView<number> lhs, ExprView<number> rhs)
 {
-    if (isOneOf<complexDomain>(lhs, rhs))
+    if (isOneOf<modularInt>(lhs, rhs))
+        return reduceViaModularArithmetic(&ModularArithmetic::add, lhs, rhs);
+    else if (isOneOf<complexDomain>(lhs, rhs))
         return addComplex(lhs, rhs);
     else if (areAll<rational>(lhs, rhs))
         return reduceViaLargeRational(std::plus<>{}, lhs, rhs);
@@ -62,14 +164,18 @@ sym2::Expr sym2::NumberArithmetic::add(ExprView<number> lhs, ExprView<number> rh
 
 sym2::Expr sym2::NumberArithmetic::addComplex(ExprView<number> lhs, ExprView<number> rhs)
 {
-    const std::array<Expr, 2> operands{{add(real(lhs), real(rhs)), add(imag(lhs), imag(rhs))}};
+    const ComplexOperands ops{lhs, rhs};
+    StackBuffer<512> arena;
 
-    return Expr{CompositeType::complexNumber, operands, allocator};
+    return complexNumber(reducePart(std::plus<>{}, ops.a, ops.c, &arena),
+      reducePart(std::plus<>{}, ops.b, ops.d, &arena));
 }
 
 sym2::Expr sym2::NumberArithmetic::subtract(ExprView<number> lhs, ExprView<number> rhs)
 {
-    if (isOneOf<complexDomain>(lhs, rhs))
+    if (isOneOf<modularInt>(lhs, rhs))
+        return reduceViaModularArithmetic(&ModularArithmetic::subtract, lhs, rhs);
+    else if (isOneOf<complexDomain>(lhs, rhs))
         return subtractComplex(lhs, rhs);
     else if (areAll<rational>(lhs, rhs))
         return reduceViaLargeRational(std::minus<>{}, lhs, rhs);
@@ -79,8 +185,33 @@ sym2::Expr sym2::NumberArithmetic::subtract(ExprView<number> lhs, ExprView<numbe
 
 sym2::Expr sym2::NumberArithmetic::subtractComplex(ExprView<number> lhs, ExprView<number> rhs)
 {
-    const std::array<Expr, 2> operands{
-      {subtract(real(lhs), real(rhs)), subtract(imag(lhs), imag(rhs))}};
+    const ComplexOperands ops{lhs, rhs};
+    StackBuffer<512> arena;
 
-    return Expr{CompositeType::complexNumber, operands, allocator};
+    return complexNumber(reducePart(std::minus<>{}, ops.a, ops.c, &arena),
+      reducePart(std::minus<>{}, ops.b, ops.d, &arena));
+}
+
+template <class Operation>
+sym2::Expr sym2::NumberArithmetic::reducePart(
+  Operation op, ExprView<number> lhs, ExprView<number> rhs, Expr::allocator_type partAllocator)
+{
+    if (isOneOf<floatingPoint>(lhs, rhs))
+        return Expr{op(get<double>(lhs), get<double>(rhs)), partAllocator};
+    else if (areAll < small && rational > (lhs, rhs)) {
+        const auto [lhsNum, lhsDenom] = get<SmallRational>(lhs);
+        const auto [rhsNum, rhsDenom] = get<SmallRational>(rhs);
+        const std::int64_t num =
+          op(std::int64_t{lhsNum} * rhsDenom, std::int64_t{rhsNum} * lhsDenom);
+        const std::int64_t denom = std::int64_t{lhsDenom} * rhsDenom;
+
+        return Expr{LargeRational{num, denom}, partAllocator};
+    }
+
+    return Expr{op(get<LargeRational>(lhs), get<LargeRational>(rhs)), partAllocator};
+}
+
+sym2::Expr sym2::NumberArithmetic::complexNumber(ExprView<number> real, ExprView<number> imag)
+{
+    return Expr{CompositeType::complexNumber, real, imag, allocator};
 }
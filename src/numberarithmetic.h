@@ -1,16 +1,21 @@
 #pragma once
 
+#include <optional>
 #include "sym2/largerational.h"
 #include "sym2/expr.h"
 #include "sym2/exprview.h"
 #include "sym2/predicates.h"
+#include "modulararithmetic.h"
 
 namespace sym2 {
     struct SmallRational;
 
     class NumberArithmetic {
       public:
-        // The memory resource is used to construct return objects from member functions.
+        // The memory resource is used to construct return objects from member functions. As soon as
+        // one operand is a modular integer, the other one must be a modular integer of the same
+        // modulus or a rational number whose denominator is invertible modulo that prime. The
+        // result is a modular integer then, other operands throw std::domain_error.
         explicit NumberArithmetic(Expr::allocator_type allocator);
 
         Expr multiply(ExprView<number> lhs, ExprView<number> rhs);
@@ -23,9 +28,19 @@ namespace sym2 {
         Expr reduceViaLargeRational(Operation op, ExprView<number> lhs, ExprView<number> rhs);
         template <class Operation>
         Expr reduceViaFloatingPoint(Operation op, ExprView<number> lhs, ExprView<number> rhs);
+        template <class Operation>
+        Expr reduceViaModularArithmetic(Operation op, ExprView<number> lhs, ExprView<number> rhs);
         Expr addComplex(ExprView<number> lhs, ExprView<number> rhs);
         Expr subtractComplex(ExprView<number> lhs, ExprView<number> rhs);
+        // Real-valued part of a complex result, to be stored in a local buffer:
+        template <class Operation>
+        Expr reducePart(Operation op, ExprView<number> lhs, ExprView<number> rhs,
+          Expr::allocator_type partAllocator);
+        // The only allocation with the allocator of this instance for complex results:
+        Expr complexNumber(ExprView<number> real, ExprView<number> imag);
 
         Expr::allocator_type allocator;
+        // Constants of the most recently used modulus, which is usually shared by all operands:
+        std::optional<ModularArithmetic> modular;
     };
 }
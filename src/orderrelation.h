@@ -1,7 +1,24 @@
 #pragma once
 
+#include <cstdint>
+#include <span>
+#include "sym2/allocator.h"
 #include "sym2/exprview.h"
 
 namespace sym2 {
     bool orderLessThan(ExprView<> lhs, ExprView<> rhs);
+
+    // Compact key of the leaf that Cohen's order relation compares first, i.e., the one reached by
+    // following the last operand of sums and products and the base of powers. When the keys of
+    // two expressions differ, orderLessThan agrees with comparing the keys, so only equal keys
+    // require the recursive comparison. orderLessThan takes this shortcut for its two arguments
+    // (but not for their operands), sortByOrder computes the keys only once per element.
+    std::uint64_t orderingKey(ExprView<> e);
+    // Strict weak ordering for intermediate results, see SimplificationMode::fastIntermediate.
+    // Numbers come first, and other expressions are ordered by the hash values of the base and of
+    // the non-numeric term, such that operands that can be combined (e.g. 2*a*b and 3*a*b in a
+    // sum, a^2 and a^b in a product) are adjacent. Equal hash values are resolved by orderLessThan.
+    bool fastOrderLessThan(ExprView<> lhs, ExprView<> rhs);
+    // Same as std::sort with orderLessThan, but ordering keys are computed only once per element:
+    void sortByOrder(std::span<ExprView<>> ops, LocalAlloc<> allocator);
 }
@@ -4,56 +4,198 @@
 #include <boost/container/static_vector.hpp>
 #include <boost/logic/tribool.hpp>
 #include <limits>
+#include <optional>
+#include <string_view>
 #include <tuple>
+#include <utility>
 #include "sym2/eval.h"
 #include "sym2/expr.h"
 #include "sym2/get.h"
+#include "sym2/hash.h"
 #include "sym2/operandsview.h"
 #include "orderrelation.h"
 #include "sym2/query.h"
+#include "sym2/symboltable.h"
+#include "sym2/visit.h"
+
+namespace sym2 {
+    namespace {
+        constinit const FixedExpr<1> one{1};
+
+        // Ranks of the leading leaf, stored in the most significant byte of the key. Constants
+        // precede all non-numeric expressions, including those that lead to a number or constant,
+        // e.g. pi < 2^(1/2). The latter hence get a rank on their own, and their order among each
+        // other isn't determined by the leading leaf alone, e.g. 2*pi < 2^(1/2).
+        enum class LeadRank : std::uint8_t {
+            number,
+            constant,
+            numberOrConstantLead,
+            symbolOrFunction
+        };
+
+        // The remaining bytes hold the first characters of the name as unsigned bytes, such that
+        // different prefixes compare like the names themselves:
+        std::uint64_t keyWithName(LeadRank rank, std::string_view name) noexcept
+        {
+            constexpr std::size_t nameBytes = sizeof(std::uint64_t) - 1;
+            std::uint64_t key = std::uint64_t{static_cast<std::uint8_t>(rank)} << 8 * nameBytes;
+
+            for (std::size_t i = 0; i < std::min(name.size(), nameBytes); ++i)
+                key |= std::uint64_t{static_cast<unsigned char>(name[i])}
+                  << 8 * (nameBytes - 1 - i);
+
+            return key;
+        }
+    }
+}
+
+std::uint64_t sym2::orderingKey(ExprView<> e)
+{
+    ExprView<> lead = e;
+
+    while (is < sum || product || power > (lead))
+        lead = is<power>(lead) ? firstOperand(lead)
+                               : nthOperand(lead, static_cast<std::uint16_t>(nOperands(lead) - 1));
+
+    if (is<number>(e))
+        return keyWithName(LeadRank::number, {});
+    else if (is<constant>(e))
+        return keyWithName(LeadRank::constant, get<std::string_view>(e));
+    else if (is < number || constant > (lead))
+        return keyWithName(LeadRank::numberOrConstantLead, {});
+    else
+        return keyWithName(LeadRank::symbolOrFunction, get<std::string_view>(lead));
+}
+
+void sym2::sortByOrder(std::span<ExprView<>> ops, LocalAlloc<> allocator)
+{
+    LocalVec<std::pair<std::uint64_t, ExprView<>>> keyed{allocator};
+
+    keyed.reserve(ops.size());
+
+    for (const ExprView<> op : ops)
+        keyed.emplace_back(orderingKey(op), op);
+
+    std::sort(keyed.begin(), keyed.end(), [](const auto& lhs, const auto& rhs) {
+        if (lhs.first != rhs.first)
+            return lhs.first < rhs.first;
+        else
+            return structuralLessThan(lhs.second, rhs.second);
+    });
+
+    std::transform(
+      keyed.cbegin(), keyed.cend(), ops.begin(), [](const auto& op) { return op.second; });
+}
+
+bool sym2::fastOrderLessThan(ExprView<> lhs, ExprView<> rhs)
+{
+    const auto asTuple = [](ExprView<> e) -> std::tuple<bool, std::size_t, std::size_t> {
+        if (is<number>(e))
+            return {false, 0, 0};
+
+        const OperandsView term =
+          is<product>(e) ? splitConstTerm(e).term : OperandsView::singleOperand(e);
+        const std::size_t termHash = hash(term);
+
+        if (term.size() == 1)
+            return {true, hash(splitAsPower(term.front()).base), termHash};
+        else
+            return {true, termHash, termHash};
+    };
+    const auto lhsTuple = asTuple(lhs);
+    const auto rhsTuple = asTuple(rhs);
+
+    if (lhsTuple != rhsTuple)
+        return lhsTuple < rhsTuple;
+
+    return orderLessThan(lhs, rhs);
+}
 
 bool sym2::orderLessThan(ExprView<> lhs, ExprView<> rhs)
 {
-    if (areAll<number>(lhs, rhs))
-        return numbers(lhs, rhs);
-    else if (areAll<symbol>(lhs, rhs))
-        return symbols(lhs, rhs);
-    else if (areAll<power>(lhs, rhs))
-        return powers(lhs, rhs);
-    else if (areAll<product>(lhs, rhs) || areAll<sum>(lhs, rhs))
-        return productsOrSums(lhs, rhs);
-    else if (areAll<constant>(lhs, rhs))
-        // This diverges from Cohen's algorithm, where constants are treated the same way as
-        // numbers:
-        return constants(lhs, rhs);
-    else if (areAll<function>(lhs, rhs))
-        return functions(lhs, rhs);
-
-    if (is<number>(lhs))
-        return true;
-    else if (is<number>(rhs))
-        // This branch could be omitted since it's handled by the final recursive swap, but it
-        // simplifies the following condition for catching a constant.
-        return false;
-    else if (is<constant>(lhs))
-        // Cohen's algorithm treats constants as numbers, hence this branch doesn't exist in his
-        // outline. We need it here since we don't treat constants as numbers.
-        return true;
-    else if (is<product>(lhs) && is < power || sum || symbol || function > (rhs))
-        return orderLessThan(OperandsView::operandsOf(lhs), OperandsView::singleOperand(rhs));
-    else if (is<power>(lhs) && is < sum || symbol || function > (rhs)) {
-        static const auto one = 1_ex;
-        return powers(splitAsPower(lhs), {rhs, one});
-    } else if (is<sum>(lhs) && is < symbol || function > (rhs))
-        return orderLessThan(OperandsView::operandsOf(lhs), OperandsView::singleOperand(rhs));
-    else if (is<function>(lhs) && is<symbol>(rhs))
-        return leftFunctionRightSymbol(lhs, rhs);
-
-    return !orderLessThan(rhs, lhs);
+    const std::uint64_t lhsKey = orderingKey(lhs);
+    const std::uint64_t rhsKey = orderingKey(rhs);
+
+    if (lhsKey != rhsKey)
+        return lhsKey < rhsKey;
+
+    return structuralLessThan(lhs, rhs);
+}
+
+bool sym2::structuralLessThan(ExprView<> lhs, ExprView<> rhs)
+{
+    // Handlers return nothing for combinations that are resolved by swapping the arguments.
+    const std::optional<bool> lessThan = visit(lhs,
+      overloaded{[rhs](ExprView<number> lhs) -> std::optional<bool> {
+                     return is<number>(rhs) ? numbers(lhs, rhs) : true;
+                 },
+        [rhs](ExprView<constant> lhs) -> std::optional<bool> {
+            if (is<constant>(rhs))
+                // This diverges from Cohen's algorithm, where constants are treated the same way
+                // as numbers:
+                return constants(lhs, rhs);
+            else
+                // Cohen's algorithm treats constants as numbers, hence this branch doesn't exist in
+                // his outline. We need it here since we don't treat constants as numbers.
+                return !is<number>(rhs);
+        },
+        [rhs](ExprView<symbol> lhs) -> std::optional<bool> {
+            if (is<symbol>(rhs))
+                return symbols(lhs, rhs);
+            return std::nullopt;
+        },
+        [rhs](ExprView<power> lhs) -> std::optional<bool> {
+            if (is<power>(rhs))
+                return powers(lhs, rhs);
+            else if (is < sum || symbol || function > (rhs))
+                return powers(splitAsPower(lhs), {rhs, one});
+            return std::nullopt;
+        },
+        [rhs](ExprView<product> lhs) -> std::optional<bool> {
+            if (is<product>(rhs))
+                return productsOrSums(lhs, rhs);
+            else if (is < power || sum || symbol || function > (rhs))
+                return orderLessThan(
+                  OperandsView::operandsOf(lhs), OperandsView::singleOperand(rhs));
+            return std::nullopt;
+        },
+        [rhs](ExprView<sum> lhs) -> std::optional<bool> {
+            if (is<sum>(rhs))
+                return productsOrSums(lhs, rhs);
+            else if (is < symbol || function > (rhs))
+                return orderLessThan(
+                  OperandsView::operandsOf(lhs), OperandsView::singleOperand(rhs));
+            return std::nullopt;
+        },
+        [rhs](ExprView<function> lhs) -> std::optional<bool> {
+            if (is<function>(rhs))
+                return functions(lhs, rhs);
+            else if (is<symbol>(rhs))
+                return leftFunctionRightSymbol(lhs, rhs);
+            return std::nullopt;
+        }});
+
+    if (lessThan)
+        return *lessThan;
+
+    return !structuralLessThan(rhs, lhs);
 }
 
 bool sym2::numbers(ExprView<number> lhs, ExprView<number> rhs)
 {
+    // Modular integers succeed all other numbers. The order of different moduli is arbitrary, but
+    // must be strict, so they are compared as (modulus, value) pairs:
+    if (isOneOf<modularInt>(lhs, rhs)) {
+        if (!areAll<modularInt>(lhs, rhs))
+            return is<modularInt>(rhs);
+
+        const ModularInt modularLhs = get<ModularInt>(lhs);
+        const ModularInt modularRhs = get<ModularInt>(rhs);
+
+        return std::tie(modularLhs.modulus, modularLhs.value)
+          < std::tie(modularRhs.modulus, modularRhs.value);
+    }
+
     const auto zeroLookup = [](auto&&...) {
         assert(false);
         return 0.0;
@@ -70,12 +212,31 @@ bool sym2::numbers(ExprView<number> lhs, ExprView<number> rhs)
 
 bool sym2::symbols(ExprView<symbol> lhs, ExprView<symbol> rhs)
 {
-    const auto asTuple = [](ExprView<symbol> e) {
+    const auto domainAsTuple = [](ExprView<symbol> e) {
+        /* We invert the booleans here to achieve R+ < + < R. The actual ordering this enforces is
+         * arbitrary, but it's important to implement a strict weak ordering. */
         return std::make_tuple(
-          /* We invert the booleans here to achieve R+ < + < R. The actual ordering this enforces is
-           * arbitrary, but it's important to implement a strict weak ordering. */
-          get<std::string_view>(e), !is < positive && realDomain > (e), !is<positive>(e),
-          !is<realDomain>(e));
+          !is < positive && realDomain > (e), !is<positive>(e), !is<realDomain>(e));
+    };
+
+    // Identical ids imply identical names, so the name comparison can be skipped. Different ids
+    // are still ordered by name, which keeps the order independent of the sequence in which names
+    // were interned, and they can't have the same name:
+    if (areAll<internedSymbol>(lhs, rhs)) {
+        const SymbolId lhsId = get<SymbolId>(lhs);
+        const SymbolId rhsId = get<SymbolId>(rhs);
+
+        if (lhsId == rhsId)
+            return domainAsTuple(lhs) < domainAsTuple(rhs);
+
+        return internedNameLess(lhsId, rhsId);
+    }
+
+    const auto asTuple = [&domainAsTuple](ExprView<symbol> e) {
+        // Interned and non-interned symbols with the same name are not equal, they must hence
+        // not be equivalent, either:
+        return std::tuple_cat(std::make_tuple(get<std::string_view>(e)), domainAsTuple(e),
+          std::make_tuple(is<internedSymbol>(e)));
     };
 
     return asTuple(lhs) < asTuple(rhs);
@@ -92,9 +253,9 @@ bool sym2::powers(BaseExp lhs, BaseExp rhs)
     const auto [rhsBase, rhsExp] = rhs;
 
     if (lhsBase == rhsBase)
-        return orderLessThan(lhsExp, rhsExp);
+        return structuralLessThan(lhsExp, rhsExp);
     else
-        return orderLessThan(lhsBase, rhsBase);
+        return structuralLessThan(lhsBase, rhsBase);
 }
 
 bool sym2::productsOrSums(ExprView<product || sum> lhs, ExprView<product || sum> rhs)
@@ -172,7 +333,7 @@ boost::logic::tribool sym2::orderLessThanOperandsReverse(OperandsView lhs, Opera
             const ExprView<> lhsOp = lastOpsLhs[i - 1];
             const ExprView<> rhsOp = lastOpsRhs[i - 1];
             if (lhsOp != rhsOp)
-                return orderLessThan(lhsOp, rhsOp);
+                return structuralLessThan(lhsOp, rhsOp);
         }
     }
 
@@ -221,7 +382,7 @@ boost::logic::tribool sym2::orderLessThanOperands(OperandsView lhs, OperandsView
     for (auto lhsOp = lhsRelevantOps.begin(), rhsOp = rhsRelevantOps.begin();
          lhsOp != lhsRelevantOps.end(); ++lhsOp, ++rhsOp)
         if (*lhsOp != *rhsOp)
-            return orderLessThan(*lhsOp, *rhsOp);
+            return structuralLessThan(*lhsOp, *rhsOp);
 
     return boost::logic::indeterminate;
 }
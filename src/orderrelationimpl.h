@@ -8,6 +8,9 @@
 namespace sym2 {
     struct BaseExp;
 
+    // Same as orderLessThan, but without the shortcut via ordering keys. All recursive comparisons
+    // use this one, such that keys are only computed for the outermost arguments:
+    bool structuralLessThan(ExprView<> lhs, ExprView<> rhs);
     bool numbers(ExprView<number> lhs, ExprView<number> rhs);
     bool symbols(ExprView<symbol> lhs, ExprView<symbol> rhs);
     bool powers(ExprView<power> lhs, ExprView<power> rhs);
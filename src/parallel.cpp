@@ -0,0 +1,164 @@
+
+#include "sym2/parallel.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sym2 {
+    namespace {
+        struct Job {
+            FunctionView<void(std::size_t)> fct;
+            const std::size_t n;
+            std::atomic<std::size_t> next{0};
+            // Both guarded by the pool mutex. The job must outlive all threads working on it,
+            // which is why they are counted as participants.
+            std::size_t participants = 0;
+            std::exception_ptr error = nullptr;
+        };
+
+        class ThreadPool {
+          public:
+            ThreadPool()
+            {
+                const unsigned hardware = std::thread::hardware_concurrency();
+                const unsigned nWorkers = hardware > 1 ? hardware - 1 : 0;
+
+                workers.reserve(nWorkers);
+
+                for (unsigned i = 0; i < nWorkers; ++i)
+                    workers.emplace_back([this]() { workerLoop(); });
+            }
+
+            ThreadPool(const ThreadPool&) = delete;
+            ThreadPool& operator=(const ThreadPool&) = delete;
+
+            ~ThreadPool()
+            {
+                {
+                    const std::lock_guard lock{mutex};
+                    stop = true;
+                }
+
+                workAvailable.notify_all();
+
+                for (std::thread& worker : workers)
+                    worker.join();
+            }
+
+            std::size_t size() const noexcept
+            {
+                return workers.size();
+            }
+
+            void run(Job& job)
+            {
+                {
+                    const std::lock_guard lock{mutex};
+                    pending.push_back(&job);
+                    ++job.participants;
+                }
+
+                workAvailable.notify_all();
+
+                process(job);
+
+                std::unique_lock lock{mutex};
+
+                std::erase(pending, &job);
+                --job.participants;
+                jobDone.wait(lock, [&job]() { return job.participants == 0; });
+
+                if (job.error)
+                    std::rethrow_exception(job.error);
+            }
+
+          private:
+            void workerLoop()
+            {
+                std::unique_lock lock{mutex};
+
+                while (true) {
+                    workAvailable.wait(lock, [this]() { return stop || !pending.empty(); });
+
+                    if (stop)
+                        return;
+
+                    Job* const job = pending.front();
+
+                    if (job->next.load() >= job->n) {
+                        // All indices are handed out, only the participants are left to finish.
+                        pending.pop_front();
+                        continue;
+                    }
+
+                    ++job->participants;
+                    lock.unlock();
+
+                    process(*job);
+
+                    lock.lock();
+
+                    if (--job->participants == 0)
+                        jobDone.notify_all();
+                }
+            }
+
+            void process(Job& job)
+            {
+                for (std::size_t i = job.next++; i < job.n; i = job.next++) {
+                    try {
+                        job.fct(i);
+                    } catch (...) {
+                        const std::lock_guard lock{mutex};
+
+                        if (!job.error)
+                            job.error = std::current_exception();
+
+                        job.next = job.n;
+                    }
+                }
+            }
+
+            std::mutex mutex;
+            std::condition_variable workAvailable;
+            std::condition_variable jobDone;
+            std::deque<Job*> pending;
+            bool stop = false;
+            // Must be the last member, so that the workers are started after everything else is
+            // initialised:
+            std::vector<std::thread> workers;
+        };
+
+        ThreadPool& pool()
+        {
+            static ThreadPool instance;
+
+            return instance;
+        }
+    }
+}
+
+void sym2::parallelFor(std::size_t n, FunctionView<void(std::size_t)> fct)
+{
+    if (n == 0)
+        return;
+    else if (n == 1 || pool().size() == 0) {
+        for (std::size_t i = 0; i < n; ++i)
+            fct(i);
+
+        return;
+    }
+
+    Job job{fct, n};
+
+    pool().run(job);
+}
+
+std::size_t sym2::concurrency()
+{
+    return pool().size() + 1;
+}
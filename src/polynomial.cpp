@@ -8,6 +8,13 @@
 #include "sym2/get.h"
 #include "sym2/query.h"
 
+namespace sym2 {
+    namespace {
+        constinit const FixedExpr<1> zero{0};
+        constinit const FixedExpr<1> one{1};
+    }
+}
+
 std::int32_t sym2::degree(ExprView<> of, ExprView<> wrt)
 {
     if (of == wrt)
@@ -121,9 +128,6 @@ bool sym2::isValidPolynomial(const ExprView<> p)
 
 sym2::ExprView<> sym2::coefficient(ExprView<> of, ExprView<> wrt, std::int32_t exponent)
 {
-    static const auto zero = 0_ex;
-    static const auto one = 1_ex;
-
     if (of == wrt)
         return exponent == 1 ? one : zero;
     else if (!contains(of, wrt) && exponent == 0)
@@ -1,7 +1,6 @@
 
 #include "sym2/predicates.h"
 #include <cassert>
-#include <queue>
 #include "sym2/blob.h"
 #include "sym2/operandsview.h"
 #include "sym2/eval.h"
@@ -70,60 +69,23 @@ namespace sym2 {
 
             return result;
         }
-
-        template <std::size_t staticQueueSize, class Fct>
-        bool bfs(ExprView<> root, Fct callback, const bool expected, const bool earlyReturn)
-        {
-            StackBuffer<staticQueueSize * sizeof(ExprView<>)> arena;
-            std::queue<ExprView<>, std::deque<ExprView<>, LocalAlloc<ExprView<>>>> lookAt{&arena};
-
-            if (callback(root) != expected)
-                return earlyReturn;
-
-            lookAt.push(root);
-
-            while (!lookAt.empty()) {
-                for (const ExprView<> op : OperandsView::operandsOf(lookAt.front()))
-                    if (callback(op) != expected)
-                        return earlyReturn;
-                    else
-                        lookAt.push(op);
-
-                lookAt.pop();
-            }
-
-            return !earlyReturn;
-        }
-
-        template <std::size_t staticQueueSize, class Fct>
-        bool bfsAllOf(ExprView<> root, Fct callback)
-        {
-            return bfs<staticQueueSize>(root, callback, true, false);
-        }
-
-        template <std::size_t staticQueueSize, class Fct>
-        bool bfsAnyOf(ExprView<> root, Fct callback)
-        {
-            return bfs<staticQueueSize>(root, callback, false, true);
-        }
-
-        template <std::size_t staticQueueSize, class Fct>
-        bool bfsNoneOf(ExprView<> root, Fct callback)
-        {
-            return bfs<staticQueueSize>(root, callback, false, false);
-        }
     }
 }
 
 bool sym2::isNumericallyEvaluable(ExprView<> e) noexcept
 {
-    return bfsNoneOf<64>(e, isSymbol);
+    return !hasSummaryFlag(e.get(), SummaryFlag::containsSymbol);
 }
 
 bool sym2::isPositive(ExprView<> e) noexcept
 {
-    if (isSymbol(e))
+    // Residue classes have no sign, and the numeric evaluation below would see the residue:
+    if (isModularInt(e))
+        return false;
+    else if (isSymbol(e))
         return getDomainFlag(e.get()) == DomainFlag::positive;
+    else if (hasSummaryFlag(e.get(), SummaryFlag::positive))
+        return true;
     else if (isNumericallyEvaluable(e)) {
         const std::complex<double> cx = evalComplex(e, [](auto&&...) {
             assert(false);
@@ -155,7 +117,7 @@ bool sym2::isPositive(ExprView<> e) noexcept
 
 bool sym2::isNegative(ExprView<> e) noexcept
 {
-    if (isSymbol(e))
+    if (isSymbol(e) || isModularInt(e))
         return false;
     else if (isNumericallyEvaluable(e)) {
         const std::complex<double> cx = evalComplex(e, [](auto&&...) {
@@ -177,43 +139,16 @@ bool sym2::isNegative(ExprView<> e) noexcept
 
 bool sym2::isRealDomain(ExprView<> e) noexcept
 {
-    return bfsAllOf<64>(e, [](ExprView<> op) {
-        // TODO handle function domains
-        if (isSymbolHeader(*op.get())) {
-            const DomainFlag domain = getDomainFlag(op.get());
-            return domain == DomainFlag::real || domain == DomainFlag::positive;
-        } else if (isComplexNumberHeader(*op.get()))
-            return false;
-        else if (isNumberHeader(*op.get()))
-            return true;
-        else
-            // We treat everything else, in particular composites, as real since the all-of
-            // semantics will keep invoking this predicate for all leaves. Note that this also
-            // treats constants as real, which might change in the future.
-            return true;
-    });
+    // TODO handle function domains. Note that constants are treated as real, which might change in
+    // the future.
+    return !hasSummaryFlag(e.get(), SummaryFlag::containsNonReal);
 }
 
 bool sym2::isComplexDomain(ExprView<> e) noexcept
 {
-    return bfsAllOf<64>(e, [](ExprView<> op) {
-        // TODO handle function domains
-        if (isSymbolHeader(*op.get())) {
-            const DomainFlag domain = getDomainFlag(op.get());
-            return domain == DomainFlag::none;
-        } else if (isComplexNumberHeader(*op.get()))
-            return true;
-        else if (isNumberHeader(*op.get()))
-            return false;
-        else if (isConstantHeader(*op.get()))
-            // This might change in the future when we want generalised constants with any number
-            // type.
-            return false;
-        else
-            // We treat everything else, in particular composites, as complex since the all-of
-            // semantics will keep invoking this predicate for all leaves.
-            return true;
-    });
+    // TODO handle function domains. Constants are not in the complex domain, this might change in
+    // the future when we want generalised constants with any number type.
+    return !hasSummaryFlag(e.get(), SummaryFlag::containsNonComplex);
 }
 
 bool sym2::isNumber(ExprView<> e) noexcept
@@ -236,6 +171,11 @@ bool sym2::isFloatingPoint(ExprView<> e) noexcept
     return isFloatingPointHeader(*e.get());
 }
 
+bool sym2::isModularInt(ExprView<> e) noexcept
+{
+    return isModularIntHeader(*e.get());
+}
+
 bool sym2::isSmall(ExprView<> e) noexcept
 {
     return isSmallHeader(*e.get());
@@ -261,6 +201,11 @@ bool sym2::isSymbol(ExprView<> e) noexcept
     return isSymbolHeader(*e.get());
 }
 
+bool sym2::isInternedSymbol(ExprView<> e) noexcept
+{
+    return isInternedSymbolHeader(*e.get());
+}
+
 bool sym2::isConstant(ExprView<> e) noexcept
 {
     return isConstantHeader(*e.get());
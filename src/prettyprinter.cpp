@@ -1,12 +1,12 @@
 
 #include "prettyprinter.h"
 #include <sstream>
-#include <stdexcept>
 #include <vector>
 #include "sym2/autosimpl.h"
 #include "sym2/expr.h"
 #include "sym2/get.h"
 #include "sym2/query.h"
+#include "sym2/visit.h"
 
 #include <iostream>
 
@@ -41,23 +41,17 @@ sym2::PrettyPrinter::PrettyPrinter(
 
 void sym2::PrettyPrinter::print(ExprView<> e)
 {
-    if (is<symbol>(e))
-        printSymbolOrConstant(e);
-    else if (is<number>(e))
-        printNumber(e);
-    else if (is<power>(e)) {
-        const auto [base, exp] = splitAsPower(e);
-        printPower(base, exp);
-    } else if (is<sum>(e))
-        printSum(e);
-    else if (is<product>(e))
-        printProduct(e);
-    else if (is<function>(e))
-        printFunction(e);
-    else if (is<constant>(e)) {
-        printSymbolOrConstant(e);
-    } else
-        throw std::invalid_argument{"Can't print unknown expression type"};
+    visit(e,
+      overloaded{[this](ExprView<symbol> e) { printSymbolOrConstant(e); },
+        [this](ExprView<constant> e) { printSymbolOrConstant(e); },
+        [this](ExprView<number> e) { printNumber(e); },
+        [this](ExprView<power> e) {
+            const auto [base, exp] = splitAsPower(e);
+            printPower(base, exp);
+        },
+        [this](ExprView<sum> e) { printSum(e); },
+        [this](ExprView<product> e) { printProduct(e); },
+        [this](ExprView<function> e) { printFunction(e); }});
 }
 
 void sym2::PrettyPrinter::printSymbolOrConstant(ExprView<symbol || constant> e)
@@ -105,6 +99,14 @@ void sym2::PrettyPrinter::printNumber(ExprView<number> e)
         engine.openDenominator(denominatorIsScalar);
         engine.largeInteger(toString(denominator(lr)));
         engine.closeDenominator(denominatorIsScalar);
+    } else if (is<modularInt>(e)) {
+        // Printed like a function call, e.g. mod(3, 7):
+        const auto [value, modulus] = get<ModularInt>(e);
+        engine.functionName("mod").openParentheses();
+        engine.largeInteger(toString(LargeInt{value}));
+        engine.comma();
+        engine.largeInteger(toString(LargeInt{modulus}));
+        engine.closeParentheses();
     } else if (is<complexDomain>(e)) {
         printNumber(real(e));
 
@@ -1,8 +1,10 @@
 
 #include "sym2/query.h"
+#include <algorithm>
 #include <cassert>
 #include <functional>
 #include <ranges>
+#include "orderrelation.h"
 #include "sym2/blob.h"
 #include "sym2/childiterator.h"
 #include "sym2/operandsview.h"
@@ -10,11 +12,18 @@
 #include "sym2/exprview.h"
 #include "sym2/get.h"
 #include "sym2/predicates.h"
+#include "sym2/traversal.h"
+
+namespace sym2 {
+    namespace {
+        // Constant-initialised, so that returning views of them requires no guard:
+        constinit const FixedExpr<1> zero{0};
+        constinit const FixedExpr<1> one{1};
+    }
+}
 
 sym2::BaseExp sym2::splitAsPower(ExprView<> e)
 {
-    static const auto one = 1_ex;
-
     if (is<power>(e))
         return {firstOperand(e), secondOperand(e)};
 
@@ -23,8 +32,6 @@ sym2::BaseExp sym2::splitAsPower(ExprView<> e)
 
 sym2::ConstAndTerm sym2::splitConstTerm(ExprView<!number> e)
 {
-    static const auto one = 1_ex;
-
     if (is<product>(e)) {
         const OperandsView ops = OperandsView::operandsOf(e);
         const auto [first, rest] = frontAndRest(ops);
@@ -55,6 +62,17 @@ std::size_t sym2::nOperands(ExprView<> e)
     return nOperands(e.get());
 }
 
+std::optional<std::uint16_t> sym2::findTerm(ExprView<sum || product> composite, ExprView<> term)
+{
+    const OperandsView ops = OperandsView::operandsOf(composite);
+    const auto candidate = std::lower_bound(ops.begin(), ops.end(), term, orderLessThan);
+
+    if (candidate == ops.end() || *candidate != term)
+        return std::nullopt;
+
+    return static_cast<std::uint16_t>(candidate - ops.begin());
+}
+
 sym2::ExprView<> sym2::nthOperand(ExprView<!small> e, std::uint16_t n)
 {
     assert(static_cast<std::size_t>(n + 1) <= nOperands(e));
@@ -72,8 +90,6 @@ sym2::ExprView<sym2::number> sym2::real(ExprView<number> n)
 
 sym2::ExprView<sym2::number> sym2::imag(ExprView<number> n)
 {
-    static auto zero = 0_ex;
-
     if (is<complexDomain>(n))
         return ExprView<>{getImagFromCommplexNumber(n.get())};
     else
@@ -102,11 +118,5 @@ std::pair<sym2::ExprView<>, std::span<const sym2::ExprView<>>> sym2::frontAndRes
 
 bool sym2::contains(ExprView<> needle, ExprView<> haystack)
 {
-    if (haystack == needle)
-        return true;
-    else if (is<composite>(haystack)) {
-        const OperandsView ops = OperandsView::operandsOf(haystack);
-        return std::any_of(ops.begin(), ops.end(), std::bind_front(&contains, needle));
-    } else
-        return false;
+    return std::ranges::any_of(preorder(haystack), [needle](ExprView<> e) { return e == needle; });
 }
@@ -0,0 +1,182 @@
+#include "sym2/simplificationcache.h"
+#include <algorithm>
+#include <boost/container_hash/hash.hpp>
+#include "sym2/hash.h"
+
+namespace sym2 {
+    namespace {
+        std::size_t keyOf(SimplificationCache::Operation op, std::span<const ExprView<>> ops)
+        {
+            std::size_t seed = static_cast<std::size_t>(op);
+
+            for (const ExprView<> operand : ops)
+                boost::hash_combine(seed, hash(operand));
+
+            return seed;
+        }
+    }
+}
+
+sym2::SimplificationCache::SimplificationCache(std::size_t capacity, Sharing sharing)
+    : maxSize{capacity}
+    , sharing{sharing}
+    , storage{Expr::allocator_type{}}
+{}
+
+std::optional<sym2::Expr> sym2::SimplificationCache::lookup(
+  Operation op, std::span<const ExprView<>> ops, Expr::allocator_type allocator)
+{
+    const std::size_t key = keyOf(op, ops);
+    const auto lock = lockIfShared();
+    const EntryList::iterator entry = find(key, op, ops);
+
+    if (entry == entries.end()) {
+        ++stats.misses;
+        return std::nullopt;
+    }
+
+    ++stats.hits;
+    entries.splice(entries.begin(), entries, entry);
+
+    const ExprView<> result = storage[entry->first + entry->nOperands];
+
+    return std::optional<Expr>{std::in_place, result, allocator};
+}
+
+void sym2::SimplificationCache::insert(
+  Operation op, std::span<const ExprView<>> ops, ExprView<> result)
+{
+    if (maxSize == 0)
+        return;
+
+    const std::size_t key = keyOf(op, ops);
+    const auto lock = lockIfShared();
+
+    if (const EntryList::iterator entry = find(key, op, ops); entry != entries.end()) {
+        entries.splice(entries.begin(), entries, entry);
+        return;
+    }
+
+    while (entries.size() >= maxSize)
+        evictLeastRecentlyUsed();
+
+    if (nDead > storage.size() / 2)
+        compact();
+
+    const std::size_t first = storage.size();
+
+    try {
+        for (const ExprView<> operand : ops)
+            storage.push_back(operand);
+
+        storage.push_back(result);
+    } catch (...) {
+        while (storage.size() > first)
+            storage.pop_back();
+        throw;
+    }
+
+    alive.resize(storage.size(), true);
+    entries.push_front({key, op, ops.size(), first});
+    index.emplace(key, entries.begin());
+}
+
+std::size_t sym2::SimplificationCache::size() const
+{
+    const auto lock = lockIfShared();
+
+    return entries.size();
+}
+
+std::size_t sym2::SimplificationCache::capacity() const noexcept
+{
+    return maxSize;
+}
+
+sym2::SimplificationCache::Statistics sym2::SimplificationCache::statistics() const
+{
+    const auto lock = lockIfShared();
+
+    return stats;
+}
+
+void sym2::SimplificationCache::clear()
+{
+    const auto lock = lockIfShared();
+
+    entries.clear();
+    index.clear();
+    storage.clear();
+    alive.clear();
+    nDead = 0;
+}
+
+void sym2::SimplificationCache::resetStatistics()
+{
+    const auto lock = lockIfShared();
+
+    stats = Statistics{};
+}
+
+std::unique_lock<std::mutex> sym2::SimplificationCache::lockIfShared() const
+{
+    if (sharing == Sharing::shared)
+        return std::unique_lock{mutex};
+    else
+        return std::unique_lock{mutex, std::defer_lock};
+}
+
+sym2::SimplificationCache::EntryList::iterator sym2::SimplificationCache::find(
+  std::size_t key, Operation op, std::span<const ExprView<>> ops)
+{
+    const auto [begin, end] = index.equal_range(key);
+
+    for (auto candidate = begin; candidate != end; ++candidate) {
+        const Entry& entry = *candidate->second;
+
+        if (entry.op != op || entry.nOperands != ops.size())
+            continue;
+
+        const auto cached = storage.begin() + static_cast<std::ptrdiff_t>(entry.first);
+
+        if (std::equal(ops.begin(), ops.end(), cached))
+            return candidate->second;
+    }
+
+    return entries.end();
+}
+
+void sym2::SimplificationCache::evictLeastRecentlyUsed()
+{
+    const EntryList::iterator last = std::prev(entries.end());
+    const auto [begin, end] = index.equal_range(last->key);
+    const auto position = std::find_if(
+      begin, end, [&last](const auto& candidate) { return candidate.second == last; });
+
+    index.erase(position);
+    std::fill_n(alive.begin() + static_cast<std::ptrdiff_t>(last->first), last->nOperands + 1,
+      false);
+    nDead += last->nOperands + 1;
+    entries.pop_back();
+    ++stats.evictions;
+}
+
+void sym2::SimplificationCache::compact()
+{
+    std::vector<std::size_t> newIndices(alive.size());
+    std::size_t nAlive = 0;
+
+    for (std::size_t i = 0; i < alive.size(); ++i) {
+        newIndices[i] = nAlive;
+        nAlive += alive[i];
+    }
+
+    std::size_t i = 0;
+    storage.eraseIf([this, &i](ExprView<>) { return !alive[i++]; });
+
+    for (Entry& entry : entries)
+        entry.first = newIndices[entry.first];
+
+    alive.assign(storage.size(), true);
+    nDead = 0;
+}
@@ -0,0 +1,69 @@
+#include "sym2/simplificationcontext.h"
+#include <algorithm>
+
+namespace sym2 {
+    namespace {
+        const char* messageFor(SimplificationAborted::Reason reason)
+        {
+            switch (reason) {
+                case SimplificationAborted::Reason::deadline:
+                    return "Simplification exceeded its deadline";
+                case SimplificationAborted::Reason::memoryBudget:
+                    return "Simplification exceeded its memory budget";
+                case SimplificationAborted::Reason::recursionDepth:
+                    return "Simplification exceeded its recursion depth";
+                case SimplificationAborted::Reason::cancelled:
+                    return "Simplification was cancelled";
+            }
+
+            return "Simplification was aborted";
+        }
+    }
+}
+
+void sym2::CancellationToken::cancel() noexcept
+{
+    cancelled.store(true, std::memory_order_relaxed);
+}
+
+bool sym2::CancellationToken::isCancelled() const noexcept
+{
+    return cancelled.load(std::memory_order_relaxed);
+}
+
+sym2::SimplificationAborted::SimplificationAborted(Reason reason)
+    : std::runtime_error{messageFor(reason)}
+    , why{reason}
+{}
+
+sym2::SimplificationAborted::Reason sym2::SimplificationAborted::reason() const noexcept
+{
+    return why;
+}
+
+sym2::SimplificationContext::SimplificationContext(SimplificationLimits limits)
+    : limits{limits}
+    , checkInterval{std::max<std::uint32_t>(limits.checkInterval, 1)}
+{}
+
+sym2::SimplificationContext::SimplificationContext(const CancellationToken& cancellation)
+    : SimplificationContext{SimplificationLimits{.cancellation = &cancellation}}
+{}
+
+std::size_t sym2::SimplificationContext::steps() const noexcept
+{
+    return nSteps;
+}
+
+std::size_t sym2::SimplificationContext::chargedBlobs() const noexcept
+{
+    return nChargedBlobs;
+}
+
+void sym2::SimplificationContext::checkDeadlineAndCancellation() const
+{
+    if (limits.cancellation != nullptr && limits.cancellation->isCancelled())
+        throw SimplificationAborted{SimplificationAborted::Reason::cancelled};
+    else if (limits.deadline && std::chrono::steady_clock::now() >= *limits.deadline)
+        throw SimplificationAborted{SimplificationAborted::Reason::deadline};
+}
@@ -0,0 +1,147 @@
+
+#include "sym2/symboltable.h"
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace sym2 {
+    namespace {
+        // The first eight characters as a big-endian number, padded with zeros. Comparing two
+        // prefixes agrees with the lexicographical comparison of the names unless they are equal:
+        std::uint64_t prefixOf(std::string_view name) noexcept
+        {
+            std::uint64_t result = 0;
+
+            for (std::size_t i = 0; i < sizeof(result); ++i) {
+                result <<= 8;
+
+                if (i < name.size())
+                    result |= static_cast<unsigned char>(name[i]);
+            }
+
+            return result;
+        }
+
+        struct Entry {
+            std::string name;
+            std::uint64_t prefix = 0;
+        };
+
+        class SymbolTable {
+          public:
+            SymbolId intern(std::string_view name)
+            {
+                {
+                    const std::shared_lock lock{mutex};
+
+                    if (const auto existing = ids.find(name); existing != ids.end())
+                        return existing->second;
+                }
+
+                const std::lock_guard lock{mutex};
+
+                // Another thread could have interned the same name in the meantime:
+                if (const auto existing = ids.find(name); existing != ids.end())
+                    return existing->second;
+
+                const std::size_t index = count.load(std::memory_order_relaxed);
+
+                if (index > std::numeric_limits<std::uint32_t>::max())
+                    throw std::length_error{"No symbol ids left to intern another name"};
+
+                const auto [segment, offset] = locate(index);
+
+                if (segments[segment] == nullptr)
+                    segments[segment] = std::make_unique<Entry[]>(std::size_t{1} << segment);
+
+                Entry& entry = segments[segment][offset];
+                const auto id = static_cast<SymbolId>(index);
+
+                entry.name = name;
+                entry.prefix = prefixOf(name);
+                ids.emplace(entry.name, id);
+                count.store(index + 1, std::memory_order_release);
+
+                return id;
+            }
+
+            // Entries are neither relocated nor modified after they have been published. A thread
+            // that obtained an id from intern, or from an expression that was handed over with
+            // proper synchronization, hence sees the complete entry without any lock:
+            const Entry& entry(SymbolId id) const noexcept
+            {
+                const auto index = static_cast<std::size_t>(id);
+                const auto [segment, offset] = locate(index);
+
+                assert(index < count.load(std::memory_order_relaxed));
+
+                return segments[segment][offset];
+            }
+
+            std::size_t size() const noexcept
+            {
+                return count.load(std::memory_order_acquire);
+            }
+
+          private:
+            // Segment k holds 2^k entries, the first of which has the index 2^k - 1. Segments are
+            // never reallocated, so 33 of them cover all 2^32 ids:
+            static std::pair<std::size_t, std::size_t> locate(std::size_t index) noexcept
+            {
+                const auto segment = static_cast<std::size_t>(std::bit_width(index + 1) - 1);
+
+                return {segment, index + 1 - (std::size_t{1} << segment)};
+            }
+
+            std::shared_mutex mutex;
+            std::array<std::unique_ptr<Entry[]>, 33> segments;
+            std::atomic<std::size_t> count{0};
+            std::unordered_map<std::string_view, SymbolId> ids;
+        };
+
+        SymbolTable& table()
+        {
+            static SymbolTable instance;
+
+            return instance;
+        }
+    }
+}
+
+sym2::SymbolId sym2::internSymbol(std::string_view name)
+{
+    if (name.empty())
+        throw std::invalid_argument{"Empty symbol names are invalid"};
+
+    return table().intern(name);
+}
+
+std::string_view sym2::internedName(SymbolId id) noexcept
+{
+    return table().entry(id).name;
+}
+
+bool sym2::internedNameLess(SymbolId lhs, SymbolId rhs) noexcept
+{
+    const Entry& lhsEntry = table().entry(lhs);
+    const Entry& rhsEntry = table().entry(rhs);
+
+    if (lhsEntry.prefix != rhsEntry.prefix)
+        return lhsEntry.prefix < rhsEntry.prefix;
+
+    return lhsEntry.name < rhsEntry.name;
+}
+
+std::size_t sym2::nInternedSymbols() noexcept
+{
+    return table().size();
+}
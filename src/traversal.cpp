@@ -0,0 +1,248 @@
+
+#include "sym2/traversal.h"
+#include <algorithm>
+#include <cassert>
+#include "sym2/blob.h"
+
+sym2::Traversal::Traversal(ExprView<> root, TraversalOrder order) noexcept
+    : root{resolveReference(root.get())}
+    , current{this->root}
+    , order{order}
+    , shared{hasSummaryFlag(this->root, SummaryFlag::containsReference)}
+{}
+
+sym2::Traversal::Iterator sym2::Traversal::begin() noexcept
+{
+    if (order == TraversalOrder::postorder && depth == 0 && current == root)
+        current = leftmostLeaf(root);
+
+    return Iterator{this};
+}
+
+std::default_sentinel_t sym2::Traversal::end() const noexcept
+{
+    return std::default_sentinel;
+}
+
+void sym2::Traversal::advance() noexcept
+{
+    if (order == TraversalOrder::preorder)
+        advancePreorder();
+    else
+        advancePostorder();
+
+    ++position;
+}
+
+void sym2::Traversal::advancePreorder() noexcept
+{
+    if (nOperands(current) > 0) {
+        const Blob* const first = getFirstOperand(current);
+
+        push(current, first + 1);
+        current = first;
+
+        return;
+    }
+
+    while (depth > 0) {
+        Frame& frame = top();
+
+        if (frame.next != frame.last) {
+            current = frame.next++;
+            return;
+        }
+
+        pop();
+    }
+
+    current = nullptr;
+}
+
+void sym2::Traversal::advancePostorder() noexcept
+{
+    if (depth == 0) {
+        assert(current == root);
+        current = nullptr;
+        return;
+    }
+
+    Frame& frame = top();
+
+    if (frame.next != frame.last)
+        current = leftmostLeaf(frame.next++);
+    else
+        pop();
+}
+
+void sym2::Traversal::push(const Blob* parent, const Blob* next) noexcept
+{
+    if (shared && resolveReference(parent) != parent) {
+        crossings[nCrossings % ringSize] = parent;
+
+        ++nCrossings;
+        cachedCrossings = std::min(cachedCrossings + 1, ringSize);
+    }
+
+    storeFrame(parent, next);
+}
+
+void sym2::Traversal::storeFrame(const Blob* parent, const Blob* next) noexcept
+{
+    frames[depth % ringSize] = Frame{parent, next, getPastTheEndOperand(parent)};
+
+    ++depth;
+    cached = std::min(cached + 1, ringSize);
+}
+
+sym2::Traversal::Frame& sym2::Traversal::top() noexcept
+{
+    assert(depth > 0);
+
+    if (cached == 0)
+        restoreFrames();
+
+    return frames[(depth - 1) % ringSize];
+}
+
+void sym2::Traversal::pop() noexcept
+{
+    // The parent is current again, which is its own successor in postorder, and where frames are
+    // restored from in either order:
+    current = top().parent;
+
+    --depth;
+    --cached;
+
+    if (shared && resolveReference(current) != current) {
+        --nCrossings;
+
+        if (cachedCrossings > 0)
+            --cachedCrossings;
+    }
+}
+
+const sym2::Blob* sym2::Traversal::leftmostLeaf(const Blob* from) noexcept
+{
+    while (nOperands(from) > 0) {
+        const Blob* const first = getFirstOperand(from);
+
+        push(from, first + 1);
+        from = first;
+    }
+
+    return from;
+}
+
+void sym2::Traversal::restoreFrames() noexcept
+{
+    if (nCrossings > cachedCrossings) {
+        restoreFramesByPosition();
+        return;
+    }
+
+    // All operands before the one on the path from the root to the current node have been
+    // visited, so the restored frames continue right after it. The path leaves the storage of a
+    // node only through one of the recorded references, which are the targets of the descent:
+    const std::size_t targetDepth = depth;
+    const Blob* node = root;
+    std::size_t crossing = 0;
+
+    depth = 0;
+    cached = 0;
+
+    while (depth < targetDepth) {
+        const Blob* const target = crossing < nCrossings ? crossings[crossing] : current;
+        const Blob* op = getFirstOperand(node);
+
+        while (op != target && (resolveReference(op) != op || !belongsTo(target, op)))
+            ++op;
+
+        if (op == target && crossing < nCrossings)
+            ++crossing;
+
+        storeFrame(node, op + 1);
+        node = op;
+    }
+
+    assert(node == current);
+}
+
+void sym2::Traversal::restoreFramesByPosition() noexcept
+{
+    // A shared subtree is reachable on more than one path, so the physical location of the current
+    // node doesn't determine its ancestors. Instead, the path to the most recently visited node is
+    // found by counting the nodes in the subtrees of preceding operands. The current node is on
+    // that path, its depth is still known.
+    const std::size_t targetDepth = depth;
+    const Blob* node = root;
+    // Position of the first node in the subtree of node, in the order of traversal:
+    std::size_t first = 0;
+
+    depth = 0;
+    cached = 0;
+    nCrossings = 0;
+    cachedCrossings = 0;
+
+    while (depth < targetDepth) {
+        const Blob* op = getFirstOperand(node);
+        // Preorder positions start with the node itself, postorder positions end with it:
+        std::size_t opFirst = order == TraversalOrder::preorder ? first + 1 : first;
+
+        for (std::size_t n = countNodes(op); position >= opFirst + n; n = countNodes(++op))
+            opFirst += n;
+
+        push(node, op + 1);
+        node = op;
+        first = opFirst;
+    }
+
+    assert(node == current);
+}
+
+std::size_t sym2::Traversal::countNodes(const Blob* root) noexcept
+{
+    Traversal nodes{ExprView<>{resolveReference(root)}, TraversalOrder::preorder};
+    std::size_t n = 0;
+
+    for (auto node = nodes.begin(); node != nodes.end(); ++node)
+        ++n;
+
+    return n;
+}
+
+sym2::Traversal::Iterator::Iterator(Traversal* traversal) noexcept
+    : traversal{traversal}
+{}
+
+sym2::ExprView<> sym2::Traversal::Iterator::operator*() const noexcept
+{
+    return ExprView<>{resolveReference(traversal->current)};
+}
+
+sym2::Traversal::Iterator& sym2::Traversal::Iterator::operator++() noexcept
+{
+    traversal->advance();
+
+    return *this;
+}
+
+void sym2::Traversal::Iterator::operator++(int) noexcept
+{
+    traversal->advance();
+}
+
+bool sym2::Traversal::Iterator::operator==(std::default_sentinel_t) const noexcept
+{
+    return traversal->current == nullptr;
+}
+
+sym2::Traversal sym2::preorder(ExprView<> root) noexcept
+{
+    return Traversal{root, TraversalOrder::preorder};
+}
+
+sym2::Traversal sym2::postorder(ExprView<> root) noexcept
+{
+    return Traversal{root, TraversalOrder::postorder};
+}
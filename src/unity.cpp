@@ -1,19 +1,31 @@
 
+#include "accumulator.cpp"
 #include "autosimpl.cpp"
 #include "blob.cpp"
+#include "blobvec.cpp"
 #include "childiterator.cpp"
 #include "cohenautosimpl.cpp"
 #include "expr.cpp"
+#include "exprbuilder.cpp"
 #include "exprview.cpp"
+#include "exprvector.cpp"
+#include "foldnumeric.cpp"
 #include "get.cpp"
+#include "hash.cpp"
 #include "logarithm.cpp"
+#include "modulararithmetic.cpp"
 #include "numberarithmetic.cpp"
 #include "operandsview.cpp"
 #include "orderrelationimpl.cpp"
+#include "parallel.cpp"
 #include "plaintextprintengine.cpp"
 #include "polynomial.cpp"
 #include "predicates.cpp"
 #include "prettyprinter.cpp"
 #include "query.cpp"
+#include "simplificationcache.cpp"
+#include "simplificationcontext.cpp"
+#include "symboltable.cpp"
+#include "traversal.cpp"
 #include "trigonometric.cpp"
 #include "violationhandler.cpp"
@@ -0,0 +1,95 @@
+#include <initializer_list>
+#include "doctest/doctest.h"
+#include "sym2/accumulator.h"
+#include "sym2/autosimpl.h"
+#include "sym2/expr.h"
+
+using namespace sym2;
+
+TEST_CASE("Accumulators")
+{
+    const Expr::allocator_type alloc{};
+    const Expr a{"a", alloc};
+    const Expr b{"b", alloc};
+    const Expr c{"c", alloc};
+    const Expr three{3, alloc};
+    const Expr half{1, 2, alloc};
+    const Expr twoAB = autoProduct({2_ex, a, b}, alloc);
+    const Expr minusAB = autoProduct({Expr{-1, alloc}, a, b}, alloc);
+    const Expr aSquare = autoPower(a, 2_ex, alloc);
+    const Expr sqrtTwo = autoPower(2_ex, half, alloc);
+
+    SUBCASE("Sum equals autoSum")
+    {
+        const Expr bPlusC = autoSum(b, c, alloc);
+        const Expr threeA = autoProduct(3_ex, a, alloc);
+        const Expr fp{1.5, alloc};
+        const std::initializer_list<ExprView<>> summands{
+          a, twoAB, three, bPlusC, aSquare, threeA, minusAB, fp, c};
+        SumAccumulator acc{alloc};
+
+        for (const ExprView<> summand : summands)
+            acc.add(summand);
+
+        CHECK(acc.finalize(alloc) == autoSum(summands, alloc));
+    }
+
+    SUBCASE("Cancelling sum")
+    {
+        SumAccumulator acc{alloc};
+
+        acc.add(twoAB);
+        acc.add(minusAB);
+        acc.add(minusAB);
+
+        CHECK(acc.finalize(alloc) == 0_ex);
+
+        acc.add(a);
+
+        CHECK(acc.finalize(alloc) == a);
+    }
+
+    SUBCASE("Many summands")
+    {
+        SumAccumulator acc{alloc};
+        Expr expected{0, alloc};
+
+        for (std::int16_t i = 1; i < 100; ++i) {
+            const Expr summand = autoPower(a, FixedExpr<1>{i % 10 + 1}, alloc);
+
+            acc.add(summand);
+            expected = autoSum(expected, summand, alloc);
+        }
+
+        CHECK(acc.finalize(alloc) == expected);
+    }
+
+    SUBCASE("Product equals autoProduct")
+    {
+        const Expr aToB = autoPower(a, b, alloc);
+        const Expr bc = autoProduct(b, c, alloc);
+        const std::initializer_list<ExprView<>> factors{
+          a, three, aSquare, bc, aToB, half, b, sqrtTwo, c};
+        ProductAccumulator acc{alloc};
+
+        for (const ExprView<> factor : factors)
+            acc.multiply(factor);
+
+        CHECK(acc.finalize(alloc) == autoProduct(factors, alloc));
+    }
+
+    SUBCASE("Product with numeric powers")
+    {
+        ProductAccumulator acc{alloc};
+
+        acc.multiply(sqrtTwo);
+        acc.multiply(a);
+        acc.multiply(sqrtTwo);
+
+        CHECK(acc.finalize(alloc) == autoProduct(2_ex, a, alloc));
+
+        acc.multiply(0_ex);
+
+        CHECK(acc.finalize(alloc) == 0_ex);
+    }
+}
@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include "doctest/doctest.h"
+#include "sym2/autosimpl.h"
+#include "sym2/expr.h"
+#include "sym2/exprvector.h"
+#include "sym2/operandsview.h"
+#include "sym2/symboltable.h"
+#include "testutils.h"
+
+using namespace sym2;
+
+TEST_CASE("Batch simplification")
+{
+    const Expr::allocator_type alloc{};
+    const Expr a{"a", alloc};
+    const Expr b{"b", alloc};
+    const Expr half{1, 2, alloc};
+    const Expr sinA{"sin", a, std::sin, alloc};
+    const Expr interned{internSymbol("batchSymbol"), alloc};
+    ScopedLocalVec<Expr> inputs{alloc};
+    ExprVector out{alloc};
+
+    const auto views = [&inputs]() { return LocalVec<ExprView<>>{inputs.begin(), inputs.end()}; };
+
+    SUBCASE("Sums")
+    {
+        for (std::int32_t i = 0; i < 300; ++i) {
+            const Expr n{i % 11 - 5, alloc};
+            const Expr twoA = directProduct({2_ex, a}, alloc);
+            inputs.push_back(directSum({n, a, sinA, twoA, interned, n}, alloc));
+        }
+
+        inputs.push_back(b);
+
+        const LocalVec<ExprView<>> in = views();
+        simplifyBatch(in, BatchOperation::sum, out);
+
+        REQUIRE(out.size() == in.size());
+        CHECK(out[in.size() - 1] == b);
+
+        for (std::size_t i = 0; i + 1 < in.size(); ++i) {
+            const OperandsView ops = OperandsView::operandsOf(in[i]);
+            const LocalVec<ExprView<>> operands{ops.begin(), ops.end(), alloc};
+
+            CHECK(out[i] == autoSum(operands, alloc));
+        }
+    }
+
+    SUBCASE("Products and powers")
+    {
+        for (std::int32_t i = 1; i <= 200; ++i) {
+            const Expr n{i, alloc};
+            inputs.push_back(directProduct({a, n, directPower(a, half, alloc), b, a}, alloc));
+            inputs.push_back(directPower(n, half, alloc));
+        }
+
+        const LocalVec<ExprView<>> in = views();
+        ExprVector powers{alloc};
+
+        simplifyBatch(in, BatchOperation::product, out);
+        simplifyBatch(in, BatchOperation::power, powers);
+
+        REQUIRE(out.size() == in.size());
+        REQUIRE(powers.size() == in.size());
+
+        for (std::size_t i = 0; i < in.size(); i += 2) {
+            const Expr n{static_cast<std::int32_t>(i / 2 + 1), alloc};
+            const Expr expected = autoProduct({a, n, autoPower(a, half, alloc), b, a}, alloc);
+
+            CHECK(out[i] == expected);
+            CHECK(out[i + 1] == in[i + 1]);
+            CHECK(powers[i] == in[i]);
+            CHECK(powers[i + 1] == autoPower(n, half, alloc));
+        }
+    }
+
+    SUBCASE("Results are appended")
+    {
+        out.push_back(a);
+        inputs.push_back(directSum({a, a}, alloc));
+
+        simplifyBatch(views(), BatchOperation::sum, out);
+        simplifyBatch({}, BatchOperation::sum, out);
+
+        REQUIRE(out.size() == 2);
+        CHECK(out[0] == a);
+        CHECK(out[1] == autoProduct(2_ex, a, alloc));
+    }
+
+    SUBCASE("Nothing is appended on failure")
+    {
+        const Expr zero{0, alloc};
+
+        for (int i = 0; i < 100; ++i)
+            inputs.push_back(i == 70 ? directPower(zero, zero, alloc) : directPower(a, b, alloc));
+
+        CHECK_THROWS_AS(simplifyBatch(views(), BatchOperation::power, out), std::invalid_argument);
+        CHECK(out.empty());
+    }
+
+    SUBCASE("Concurrent batches share no mutable state")
+    {
+        for (std::int32_t i = 0; i < 500; ++i) {
+            const Expr n{i % 13, 7, alloc};
+            const Expr symbol{internSymbol("s" + std::to_string(i % 17)), alloc};
+            inputs.push_back(directSum(
+              {directProduct({n, symbol}, alloc), directPower(symbol, 2_ex, alloc), n, a}, alloc));
+        }
+
+        const LocalVec<ExprView<>> in = views();
+        simplifyBatch(in, BatchOperation::sum, out);
+
+        std::array<ExprVector, 4> results{
+          ExprVector{alloc}, ExprVector{alloc}, ExprVector{alloc}, ExprVector{alloc}};
+        std::array<std::thread, results.size()> threads;
+
+        for (std::size_t i = 0; i < threads.size(); ++i)
+            threads[i] = std::thread{[&in, &results, i]() {
+                for (int round = 0; round < 3; ++round) {
+                    results[i].clear();
+                    simplifyBatch(in, BatchOperation::sum, results[i]);
+                }
+            }};
+
+        for (std::thread& thread : threads)
+            thread.join();
+
+        for (const ExprVector& result : results) {
+            REQUIRE(result.size() == out.size());
+            CHECK(std::equal(result.begin(), result.end(), out.begin(), out.end()));
+        }
+    }
+}
@@ -0,0 +1,101 @@
+
+#include <new>
+#include <utility>
+#include "doctest/doctest.h"
+#include "sym2/blobvec.h"
+#include "sym2/expr.h"
+#include "sym2/get.h"
+#include "testutils.h"
+
+using namespace sym2;
+
+TEST_CASE("BlobVec")
+{
+    // Neither upstream nor operator new as a fallback, so any allocation beyond one Blob throws:
+    StackBuffer<sizeof(Blob), alignof(Blob)> noAlloc{nullptr, false};
+    const BlobVec::allocator_type alloc{&noAlloc};
+    const Blob blob{};
+
+    SUBCASE("Inline storage")
+    {
+        BlobVec v{alloc};
+
+        CHECK(v.empty());
+        CHECK(v.isInline());
+
+        for (std::size_t i = 0; i < BlobVec::inlineCapacity; ++i)
+            v.push_back(blob);
+
+        CHECK(v.size() == BlobVec::inlineCapacity);
+        CHECK(v.isInline());
+        CHECK_THROWS_AS(v.push_back(blob), std::bad_alloc);
+    }
+
+    SUBCASE("Growth beyond inline capacity")
+    {
+        BlobVec v{BlobVec::allocator_type{}};
+
+        v.resize(BlobVec::inlineCapacity + 1);
+
+        CHECK(v.size() == BlobVec::inlineCapacity + 1);
+        CHECK(!v.isInline());
+
+        const Blob* const storage = v.data();
+        BlobVec moved{std::move(v)};
+
+        CHECK(moved.data() == storage);
+        CHECK(v.empty());
+        CHECK(v.isInline());
+    }
+
+    SUBCASE("Growing by resize is amortised")
+    {
+        BlobVec v{BlobVec::allocator_type{}};
+
+        v.resize(BlobVec::inlineCapacity + 1);
+
+        const std::size_t capacity = v.capacity();
+
+        v.resize(capacity + 1);
+
+        CHECK(v.capacity() >= 2 * capacity);
+        CHECK(BlobVec(100, BlobVec::allocator_type{}).capacity() == 100);
+    }
+
+    SUBCASE("Copy and move inline storage")
+    {
+        BlobVec v{2, alloc};
+        BlobVec copy{v};
+        BlobVec moved{std::move(v)};
+
+        CHECK(copy.size() == 2);
+        CHECK(moved.size() == 2);
+        CHECK(copy.data() != moved.data());
+        CHECK(moved.isInline());
+    }
+
+    SUBCASE("Small expressions don't allocate")
+    {
+        const Expr n{42, alloc};
+        const Expr d{1.5, alloc};
+        const Expr a{"a", alloc};
+        const Expr b{"b", alloc};
+        const Expr c{"c", alloc};
+        const Expr aSquare = directPower(a, n, alloc);
+        const Expr abc = directSum({a, b, c}, alloc);
+
+        CHECK(get<std::int16_t>(n) == 42);
+        CHECK(get<double>(d) == doctest::Approx(1.5));
+        CHECK(get<std::string_view>(a) == "a");
+        CHECK(abc == directSum({a, b, c}, {}));
+        CHECK(aSquare == directPower(a, n, {}));
+    }
+
+    SUBCASE("Moving an Expr copies inline Blobs")
+    {
+        Expr a{"a", alloc};
+        Expr moved{std::move(a), alloc};
+
+        CHECK(get<std::string_view>(moved) == "a");
+    }
+}
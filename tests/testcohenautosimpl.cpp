@@ -0,0 +1,57 @@
+#include <cmath>
+#include "cohenautosimpl.h"
+#include "doctest/doctest.h"
+#include "numberarithmetic.h"
+#include "orderrelation.h"
+#include "sym2/autosimpl.h"
+#include "sym2/expr.h"
+
+using namespace sym2;
+
+TEST_CASE("Simplifier dependencies")
+{
+    const Expr::allocator_type alloc{};
+    const Expr a{"a", alloc};
+    const Expr b{"b", alloc};
+    const Expr sinA{"sin", a, std::sin, alloc};
+    NumberArithmetic numerics{alloc};
+    int nComparisons = 0;
+    int nAdditions = 0;
+
+    auto lessThan = [&nComparisons](ExprView<> lhs, ExprView<> rhs) {
+        ++nComparisons;
+        return orderLessThan(lhs, rhs);
+    };
+    auto add = [&](ExprView<number> lhs, ExprView<number> rhs) {
+        ++nAdditions;
+        return numerics.add(lhs, rhs);
+    };
+    auto multiply = [&numerics](ExprView<number> lhs, ExprView<number> rhs) {
+        return numerics.multiply(lhs, rhs);
+    };
+
+    SUBCASE("Runtime callbacks are invoked")
+    {
+        CohenAutoSimpl simplifier{{lessThan, add, multiply}, alloc};
+        const Expr sum = simplifier.simplifySum({{sinA, 2_ex, b, 3_ex, a}});
+
+        CHECK(sum == autoSum({sinA, 2_ex, b, 3_ex, a}, alloc));
+        CHECK(nComparisons > 0);
+        CHECK(nAdditions == 1);
+    }
+
+    SUBCASE("Static and runtime dependencies agree")
+    {
+        CohenAutoSimpl dynamic{{lessThan, add, multiply}, alloc};
+        BasicCohenAutoSimpl<StaticDependencies<orderLessThan>> fixed{
+          StaticDependencies<orderLessThan>{alloc}, alloc};
+        const Expr half{1, 2, alloc};
+        const Expr product = autoProduct(2_ex, autoPower(a, half, alloc), alloc);
+
+        CHECK(dynamic.simplifyProduct({{product, sinA, a, b}})
+          == fixed.simplifyProduct({{product, sinA, a, b}}));
+        CHECK(dynamic.simplifySum({{product, sinA, product, 1_ex}})
+          == fixed.simplifySum({{product, sinA, product, 1_ex}}));
+        CHECK(dynamic.simplifyPower(product, 2_ex) == fixed.simplifyPower(product, 2_ex));
+    }
+}
@@ -197,3 +197,54 @@ TEST_CASE("Numeric power evaluation with complex/real distinction")
         CHECK(evalComplex(what, lookupThrow).imag() == doctest::Approx(expected.imag()));
     }
 }
+
+TEST_CASE("Parallel numeric evaluation")
+{
+    const Expr::allocator_type alloc{};
+    const ParallelEvaluation policy{.minOperands = 100, .chunkSize = 64};
+    const auto lookup = [](std::string_view symbol) { return symbol == "a" ? 0.5 : 2.0; };
+    ScopedLocalVec<Expr> summands{alloc};
+    ScopedLocalVec<Expr> factors{alloc};
+
+    for (std::int32_t i = 1; i <= 1000; ++i) {
+        summands.push_back(directProduct({Expr{1, i, alloc}, "a"_ex}, alloc));
+        factors.push_back(i % 2 == 0 ? Expr{"a", alloc} : Expr{"b", alloc});
+    }
+
+    const Expr largeSum{CompositeType::sum, summands, alloc};
+    const Expr largeProduct{CompositeType::product, factors, alloc};
+
+    SUBCASE("Large sum")
+    {
+        const double sequential = evalReal(largeSum, lookup);
+        const double parallel = evalReal(largeSum, lookup, policy);
+
+        CHECK(parallel == doctest::Approx(sequential));
+        CHECK(parallel == evalReal(largeSum, lookup, policy));
+    }
+
+    SUBCASE("Large product")
+    {
+        CHECK(evalReal(largeProduct, lookup, policy) == doctest::Approx(1.0));
+    }
+
+    SUBCASE("Nested large sum")
+    {
+        const Expr what = directPower(largeSum, 2_ex, alloc);
+        const double expected = std::pow(evalReal(largeSum, lookup), 2.0);
+
+        CHECK(evalReal(what, lookup, policy) == doctest::Approx(expected));
+    }
+
+    SUBCASE("Small composites are evaluated sequentially")
+    {
+        const Expr what = directSum({"a"_ex, "b"_ex}, alloc);
+
+        CHECK(evalReal(what, lookup, policy) == evalReal(what, lookup));
+    }
+
+    SUBCASE("Exception in lookup is propagated")
+    {
+        CHECK_THROWS_AS(evalReal(largeSum, lookupThrow, policy), std::domain_error);
+    }
+}
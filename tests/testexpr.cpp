@@ -2,7 +2,9 @@
 #include <algorithm>
 #include <cmath>
 #include <limits>
+#include <stdexcept>
 #include <string_view>
+#include <vector>
 #include "doctest/doctest.h"
 #include "sym2/expr.h"
 #include "sym2/get.h"
@@ -148,6 +150,21 @@ TEST_CASE("Construction and retrieval")
                 CHECK(get<LargeRational>(n) == -lr);
             }
         }
+
+        SUBCASE("Operand of a composite")
+        {
+            const LargeRational smallParts{16, 91125};
+            const LargeRational largeParts{LargeInt{"1000000000000000000000"}, LargeInt{7}};
+            const Expr first{smallParts, alloc};
+            const Expr second{largeParts, alloc};
+            const Expr a{"a", alloc};
+            const Expr sum{CompositeType::sum, first, second, alloc};
+            const Expr product{CompositeType::product, sum, a, alloc};
+
+            CHECK(get<LargeRational>(firstOperand(firstOperand(product))) == smallParts);
+            CHECK(get<LargeRational>(secondOperand(firstOperand(product))) == largeParts);
+            CHECK(secondOperand(product) == a);
+        }
     }
 
     SUBCASE("Symbols")
@@ -264,6 +281,15 @@ TEST_CASE("Construction and retrieval")
         CHECK(secondOperand(atan2ab) == "b"_ex);
     }
 
+    SUBCASE("Functions beyond 16 bit extent throw")
+    {
+        const Expr a{"a", alloc};
+        const std::vector<ExprView<>> summands(40000, a);
+        const Expr largeSum{CompositeType::sum, summands, alloc};
+
+        CHECK_THROWS_AS(Expr("atan2", largeSum, largeSum, std::atan2, alloc), std::range_error);
+    }
+
     SUBCASE("Complex number roundtrip")
     {
         const ScopedLocalVec<Expr> args{{Expr{2, alloc}, Expr{3, 7, alloc}}, alloc};
@@ -284,7 +310,9 @@ TEST_CASE("Construction and retrieval")
         {
             alloc.allocate(1); // No buffer space left from now on
 
-            CHECK_THROWS_AS((Expr{123, alloc}), std::bad_alloc);
+            // Scalars are stored inline, only larger expressions need the buffer:
+            CHECK_NOTHROW((Expr{123, alloc}));
+            CHECK_THROWS_AS((Expr{"abcdefghijklmnopqrstuvwxyz", alloc}), std::bad_alloc);
         }
 
         SUBCASE("Small rational numbers")
@@ -307,7 +335,7 @@ TEST_CASE("Construction and retrieval")
             CHECK(get<std::string_view>(symbol) == "abc");
             CHECK(get<std::string_view>(longer) == "0123456789abcde");
 
-            CHECK_THROWS_AS(SmallExpr<1>("0123456789abcde", alloc), std::bad_alloc);
+            CHECK_THROWS_AS(SmallExpr<1>("abcdefghijklmnopqrstuvwxyz", alloc), std::bad_alloc);
         }
     }
 
@@ -340,6 +368,27 @@ TEST_CASE("Construction and retrieval")
             CHECK(get<std::string_view>(threeBytes) == "0123456789abcde");
             CHECK(get<std::string_view>(fourBytes) == "0123456789abcdef");
         }
+
+        SUBCASE("Compile time construction")
+        {
+            static constinit const FixedExpr<1> n{-42};
+            static constinit const FixedExpr<1> q{6, -4};
+            static constinit const FixedExpr<1> a{"abcdef"};
+            constexpr FixedExpr<1> literal = 7_ex;
+
+            CHECK(n == Expr{-42, alloc});
+            CHECK(q == Expr{-3, 2, alloc});
+            CHECK(a == Expr{"abcdef", alloc});
+            CHECK(literal == Expr{7, alloc});
+        }
+
+        SUBCASE("Invalid arguments")
+        {
+            CHECK_THROWS_AS((FixedExpr<1>{1, 0}), std::invalid_argument);
+            CHECK_THROWS_AS(FixedExpr<1>{100'000}, std::domain_error);
+            CHECK_THROWS_AS(FixedExpr<1>{""}, std::invalid_argument);
+            CHECK_THROWS_AS(FixedExpr<2>{"0123456789abcde"}, std::bad_alloc);
+        }
     }
 
     SUBCASE("User defined literal _ex")
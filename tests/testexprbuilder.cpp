@@ -0,0 +1,151 @@
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include "doctest/doctest.h"
+#include "sym2/expr.h"
+#include "sym2/exprbuilder.h"
+#include "sym2/modularint.h"
+#include "testutils.h"
+
+using namespace sym2;
+
+TEST_CASE("ExprBuilder")
+{
+    const Expr::allocator_type alloc{};
+    const Expr a{"a", alloc};
+    const Expr b{"b", alloc};
+    const Expr longName{"aSymbolWithAVeryLongName", alloc};
+    const Expr n{42, alloc};
+    const Expr fp{1.5, alloc};
+    const Expr large{LargeInt{"123456789012345678901234567890"}, alloc};
+    ExprBuilder builder{alloc};
+
+    SUBCASE("Single leaf")
+    {
+        builder.push(longName);
+
+        CHECK(builder.finish() == longName);
+    }
+
+    SUBCASE("Nested composites")
+    {
+        const Expr product = directProduct({n, longName, large}, alloc);
+        const Expr power = directPower(directSum({a, fp}, alloc), b, alloc);
+        const Expr expected = directSum({product, a, power, large}, alloc);
+
+        builder.open(CompositeType::sum);
+        builder.open(CompositeType::product);
+        builder.push(n);
+        builder.push(longName);
+        builder.push(large);
+        builder.close();
+        builder.push(a);
+        builder.open(CompositeType::power);
+        builder.open(CompositeType::sum);
+        builder.push(a);
+        builder.push(fp);
+        builder.close();
+        builder.push(b);
+
+        CHECK(builder.depth() == 2);
+
+        builder.close();
+        builder.push(large);
+        builder.close();
+
+        CHECK(builder.finish() == expected);
+    }
+
+    SUBCASE("Functions")
+    {
+        const Expr sinSum{"sin", directSum({a, longName}, alloc), std::sin, alloc};
+        const Expr expected{"aLongFunctionName", sinSum, large, std::atan2, alloc};
+
+        builder.openFunction("aLongFunctionName", std::atan2);
+        builder.openFunction("sin", std::sin);
+        builder.open(CompositeType::sum);
+        builder.push(a);
+        builder.push(longName);
+        builder.close();
+        builder.close();
+        builder.push(large);
+        builder.close();
+
+        CHECK(builder.finish() == expected);
+    }
+
+    SUBCASE("Complex number")
+    {
+        builder.open(CompositeType::complexNumber);
+        builder.push(fp);
+        builder.push(large);
+        builder.close();
+
+        CHECK(builder.finish() == directComplex(fp, large, alloc));
+    }
+
+    SUBCASE("Many operands")
+    {
+        ScopedLocalVec<Expr> symbols{alloc};
+        LocalVec<ExprView<>> ops{alloc};
+
+        // Views must stay valid, and Exprs store short sequences inline:
+        symbols.reserve(1000);
+        builder.open(CompositeType::product);
+
+        for (int i = 0; i < 1000; ++i) {
+            symbols.emplace_back("s" + std::to_string(i) + "withLongName");
+            ops.push_back(symbols.back());
+            builder.push(symbols.back());
+        }
+
+        builder.close();
+
+        CHECK(builder.finish() == Expr{CompositeType::product, ops, alloc});
+    }
+
+    SUBCASE("Builder can be reused after finishing")
+    {
+        builder.push(a);
+        CHECK(builder.finish() == a);
+
+        builder.push(b);
+        CHECK(builder.finish() == b);
+    }
+
+    SUBCASE("Invalid usage")
+    {
+        CHECK_THROWS_AS(builder.close(), std::logic_error);
+        CHECK_THROWS_AS(builder.finish(), std::logic_error);
+
+        builder.open(CompositeType::power);
+        builder.push(a);
+        CHECK_THROWS_AS(builder.close(), std::invalid_argument);
+        CHECK_THROWS_AS(builder.finish(), std::logic_error);
+
+        builder.push(b);
+        CHECK_NOTHROW(builder.close());
+        CHECK_THROWS_AS(builder.push(a), std::logic_error);
+        CHECK(builder.finish() == directPower(a, b, alloc));
+
+        builder.open(CompositeType::complexNumber);
+        builder.push(a);
+        builder.push(n);
+        CHECK_THROWS_AS(builder.close(), std::invalid_argument);
+
+        builder.openFunction("sin", std::sin);
+        builder.push(a);
+        builder.push(b);
+        CHECK_THROWS_AS(builder.close(), std::invalid_argument);
+    }
+
+    SUBCASE("Complex numbers with modular parts are rejected")
+    {
+        builder.open(CompositeType::complexNumber);
+        builder.push(Expr{ModularInt{3, 7}, alloc});
+        builder.push(n);
+
+        CHECK_THROWS_AS(builder.close(), std::invalid_argument);
+    }
+}
@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <array>
+#include <ranges>
+#include <utility>
+#include "doctest/doctest.h"
+#include "sym2/blob.h"
+#include "sym2/expr.h"
+#include "sym2/exprvector.h"
+#include "sym2/operandsview.h"
+#include "sym2/predicates.h"
+#include "testutils.h"
+
+using namespace sym2;
+
+TEST_CASE("ExprVector")
+{
+    const Expr::allocator_type alloc{};
+    const Expr a{"a", alloc};
+    const Expr b{"b", alloc};
+    const Expr longName{"aSymbolWithAVeryLongName", alloc};
+    const Expr n{42, alloc};
+    const Expr fp{1.5, alloc};
+    const Expr s = directSum({a, directProduct({n, b}, alloc), longName}, alloc);
+    const Expr pw = directPower(s, fp, alloc);
+    const auto nBlobsOf = [](ExprView<> e) -> std::size_t { return remoteExtent(e.get()) + 1; };
+    const auto distance = [](ExprView<> first, ExprView<> last) {
+        return static_cast<std::size_t>(last.get() - first.get());
+    };
+    ExprVector exprs{alloc};
+
+    CHECK(exprs.empty());
+
+    for (ExprView<> e : {ExprView<>{a}, ExprView<>{pw}, ExprView<>{n}, ExprView<>{s},
+           ExprView<>{longName}})
+        exprs.push_back(e);
+
+    REQUIRE(exprs.size() == 5);
+
+    SUBCASE("Element access")
+    {
+        CHECK(exprs[0] == a);
+        CHECK(exprs[1] == pw);
+        CHECK(exprs[2] == n);
+        CHECK(exprs[3] == s);
+        CHECK(exprs[4] == longName);
+    }
+
+    SUBCASE("Blobs are stored back to back")
+    {
+        CHECK(distance(exprs[0], exprs[1]) == 1);
+        CHECK(distance(exprs[1], exprs[2]) == nBlobsOf(pw));
+        CHECK(exprs.nBlobs() == distance(exprs[0], exprs[4]) + nBlobsOf(longName));
+    }
+
+    SUBCASE("Iteration")
+    {
+        CHECK(std::ranges::distance(exprs) == 5);
+        CHECK(std::ranges::count_if(exprs, isSymbol) == 2);
+        CHECK(*std::ranges::next(exprs.begin(), 3) == s);
+    }
+
+    SUBCASE("Append operand of other expression")
+    {
+        const ExprView<> base = *OperandsView::operandsOf(pw).begin();
+
+        exprs.push_back(base);
+
+        CHECK(exprs.size() == 6);
+        CHECK(exprs[5] == s);
+    }
+
+    SUBCASE("Append element of the same container")
+    {
+        for (std::size_t i = 0; i < 100; ++i)
+            exprs.push_back(exprs[1]);
+
+        CHECK(exprs.size() == 105);
+        CHECK(std::ranges::all_of(exprs | std::views::drop(5), [&](ExprView<> e) {
+            return e == pw;
+        }));
+    }
+
+    SUBCASE("Append other containers")
+    {
+        StackBuffer<256> arena;
+        ExprVector first{&arena};
+        ExprVector second{alloc};
+        ExprVector empty{alloc};
+
+        first.push_back(s);
+        first.push_back(b);
+        second.push_back(pw);
+
+        const std::array<ExprVector, 3> parts{
+          std::move(first), std::move(empty), std::move(second)};
+
+        exprs.append(parts);
+
+        CHECK(exprs.size() == 8);
+        CHECK(exprs[4] == longName);
+        CHECK(exprs[5] == s);
+        CHECK(exprs[6] == b);
+        CHECK(exprs[7] == pw);
+        CHECK(distance(exprs[5], exprs[7]) == nBlobsOf(s) + 1);
+        CHECK(exprs.nBlobs() == distance(exprs[0], exprs[7]) + nBlobsOf(pw));
+    }
+
+    SUBCASE("Erase and compact")
+    {
+        const std::size_t nBlobs = exprs.nBlobs();
+        const std::size_t nErased = exprs.eraseIf([](ExprView<> e) { return !isSymbol(e); });
+
+        CHECK(nErased == 3);
+        REQUIRE(exprs.size() == 2);
+        CHECK(exprs[0] == a);
+        CHECK(exprs[1] == longName);
+        CHECK(exprs.nBlobs() == 1 + nBlobsOf(longName));
+        CHECK(exprs.nBlobs() < nBlobs);
+
+        exprs.push_back(pw);
+
+        CHECK(exprs[2] == pw);
+    }
+
+    SUBCASE("Erase nothing")
+    {
+        CHECK(exprs.eraseIf([](ExprView<>) { return false; }) == 0);
+        CHECK(exprs.size() == 5);
+        CHECK(exprs[3] == s);
+    }
+
+    SUBCASE("Pop and clear")
+    {
+        exprs.pop_back();
+
+        CHECK(exprs.size() == 4);
+        CHECK(exprs.nBlobs() == distance(exprs[0], exprs[3]) + nBlobsOf(s));
+
+        exprs.clear();
+
+        CHECK(exprs.empty());
+        CHECK(exprs.nBlobs() == 0);
+    }
+}
@@ -0,0 +1,102 @@
+
+#include <cmath>
+#include "doctest/doctest.h"
+#include "sym2/autosimpl.h"
+#include "sym2/constants.h"
+#include "sym2/expr.h"
+#include "sym2/foldnumeric.h"
+#include "sym2/get.h"
+#include "sym2/predicates.h"
+#include "sym2/query.h"
+#include "testutils.h"
+
+using namespace sym2;
+
+TEST_CASE("Numeric folding")
+{
+    const Expr::allocator_type alloc{};
+    const Expr sqrtTwo = directPower(2_ex, Expr{1, 2, alloc}, alloc);
+    const Expr sinThree{"sin", 3_ex, std::sin, alloc};
+
+    SUBCASE("Scalars are unchanged")
+    {
+        const Expr n{42, alloc};
+        const Expr a{"a", alloc};
+
+        for (const ExprView<> e : {ExprView<>{n}, ExprView<>{a}, ExprView<>{pi}})
+            CHECK(foldNumeric(e, alloc) == e);
+
+        const Expr fp{1.5, alloc};
+
+        CHECK(foldNumeric(fp, alloc) == fp);
+    }
+
+    SUBCASE("Exact subtrees are unchanged")
+    {
+        const Expr s = directSum({sqrtTwo, sinThree, "a"_ex}, alloc);
+
+        CHECK(foldNumeric(sqrtTwo, alloc) == sqrtTwo);
+        CHECK(foldNumeric(s, alloc) == s);
+    }
+
+    SUBCASE("Evaluable subtree with inexact operand")
+    {
+        const Expr pr = directProduct({1.5_ex, sqrtTwo}, alloc);
+        const Expr s = directSum({pr, sinThree}, alloc);
+        const Expr result = foldNumeric(s, alloc);
+
+        REQUIRE(is<floatingPoint>(result));
+        CHECK(get<double>(result) == doctest::Approx(1.5 * std::sqrt(2.0) + std::sin(3.0)));
+    }
+
+    SUBCASE("Only maximal subtrees are folded")
+    {
+        const Expr pr = directProduct({1.5_ex, sqrtTwo}, alloc);
+        const Expr s = directSum({"a"_ex, pr}, alloc);
+        const Expr result = foldNumeric(s, alloc);
+
+        REQUIRE(is<sum>(result));
+        CHECK(nOperands(result) == 2);
+        CHECK(get<double>(firstOperand(result)) == doctest::Approx(1.5 * std::sqrt(2.0)));
+        CHECK(secondOperand(result) == "a"_ex);
+    }
+
+    SUBCASE("Evaluable operands of non-evaluable product")
+    {
+        const Expr pr = directProduct({1.5_ex, "a"_ex, sqrtTwo}, alloc);
+        const Expr result = foldNumeric(pr, alloc);
+
+        REQUIRE(is<product>(result));
+        CHECK(nOperands(result) == 2);
+        CHECK(get<double>(firstOperand(result)) == doctest::Approx(1.5 * std::sqrt(2.0)));
+        CHECK(secondOperand(result) == "a"_ex);
+    }
+
+    SUBCASE("Function arguments")
+    {
+        const Expr arg = directSum({0.5_ex, sqrtTwo}, alloc);
+        const Expr sinB{"sin", directProduct({"b"_ex, arg}, alloc), std::sin, alloc};
+        const Expr result = foldNumeric(sinB, alloc);
+
+        REQUIRE(is<function>(result));
+        CHECK(get<std::string_view>(result) == "sin");
+        CHECK(get<UnaryDoubleFctPtr>(result) == static_cast<UnaryDoubleFctPtr>(std::sin));
+
+        const ExprView<> foldedArg = firstOperand(result);
+
+        REQUIRE(is<product>(foldedArg));
+        CHECK(get<double>(firstOperand(foldedArg)) == doctest::Approx(0.5 + std::sqrt(2.0)));
+        CHECK(secondOperand(foldedArg) == "b"_ex);
+    }
+
+    SUBCASE("Complex result")
+    {
+        const Expr sqrtMinusTwo = directPower(Expr{-2, alloc}, Expr{1, 2, alloc}, alloc);
+        const Expr pr = directProduct({1.5_ex, sqrtMinusTwo}, alloc);
+        const Expr result = foldNumeric(pr, alloc);
+
+        REQUIRE(is < number && complexDomain > (result));
+        CHECK(get<double>(real(result)) == doctest::Approx(0.0));
+        CHECK(get<double>(imag(result)) == doctest::Approx(1.5 * std::sqrt(2.0)));
+    }
+}
@@ -0,0 +1,50 @@
+#include <cmath>
+#include "doctest/doctest.h"
+#include "sym2/expr.h"
+#include "sym2/hash.h"
+#include "sym2/operandsview.h"
+#include "sym2/symboltable.h"
+#include "testutils.h"
+
+using namespace sym2;
+
+TEST_CASE("Hash")
+{
+    const Expr::allocator_type alloc{};
+    const Expr a{"a", alloc};
+    const Expr b{"b", alloc};
+    const Expr longName{"aSymbolWithAVeryLongName", alloc};
+    const Expr aPlusB = directSum({a, b}, alloc);
+    const Expr original = directProduct(
+      {directPower(aPlusB, 2_ex, alloc), Expr{"sin", aPlusB, std::sin, alloc}, longName}, alloc);
+
+    SUBCASE("Equal expressions")
+    {
+        CHECK(hash(original) == hash(Expr{original, alloc}));
+        CHECK(hash(longName) == hash(Expr{"aSymbolWithAVeryLongName", alloc}));
+        CHECK(hash(Expr{1.5, alloc}) == hash(Expr{1.5, alloc}));
+    }
+
+    SUBCASE("Shared subtrees are transparent")
+    {
+        const Expr shared = shareSubtrees(original, alloc);
+
+        CHECK(hash(shared) == hash(original));
+    }
+
+    SUBCASE("Different expressions")
+    {
+        // Not guaranteed in general, but expected for these simple cases:
+        CHECK(hash(a) != hash(b));
+        CHECK(hash(aPlusB) != hash(directProduct({a, b}, alloc)));
+        CHECK(hash(a) != hash(Expr{internSymbol("a"), alloc}));
+    }
+
+    SUBCASE("Operands")
+    {
+        const Expr product = directProduct({a, b}, alloc);
+
+        CHECK(hash(OperandsView::operandsOf(product)) == hash(OperandsView::operandsOf(aPlusB)));
+        CHECK(hash(OperandsView::singleOperand(a)) != hash(OperandsView::operandsOf(aPlusB)));
+    }
+}
@@ -0,0 +1,103 @@
+#include <cmath>
+#include <type_traits>
+#include "doctest/doctest.h"
+#include "sym2/autosimpl.h"
+#include "sym2/expr.h"
+#include "sym2/lazyexpr.h"
+#include "sym2/query.h"
+
+using namespace sym2;
+
+namespace {
+    template <class Node>
+    concept AddableAsLvalue = requires(Node& node, const Expr& e) { node + e; };
+
+    template <class Node>
+    concept SimplifiableAsLvalue = requires(Node& node, Expr::allocator_type allocator) {
+        autoSimplify(node, allocator);
+    };
+}
+
+TEST_CASE("Lazy expressions")
+{
+    const Expr::allocator_type alloc{};
+    const Expr a{"a", alloc};
+    const Expr b{"b", alloc};
+    const Expr half{1, 2, alloc};
+    const Expr sinA{"sin", a, std::sin, alloc};
+
+    SUBCASE("Chains of the same operator are flattened")
+    {
+        const Expr sum = a + sinA + b + 2_ex + a;
+        const Expr product = a * b * sinA * a;
+
+        CHECK(sum == autoSum({a, sinA, b, 2_ex, a}, alloc));
+        CHECK(product == autoProduct({a, b, sinA, a}, alloc));
+    }
+
+    SUBCASE("Subtraction and division")
+    {
+        const Expr difference = a - b - a;
+        const Expr quotient = a / b * b;
+        const Expr negation = -(a * b) * 2_ex;
+
+        CHECK(difference == autoProduct(Expr{-1, alloc}, b, alloc));
+        CHECK(quotient == a);
+        CHECK(negation == autoProduct({Expr{-1, alloc}, a, b, 2_ex}, alloc));
+        CHECK(Expr{a / a} == 1_ex);
+        CHECK(Expr{a - a} == 0_ex);
+    }
+
+    SUBCASE("Powers")
+    {
+        const Expr power = pow(a + b, 2_ex);
+        const Expr sqrt = pow(a, half) * pow(a, half);
+
+        CHECK(power == autoPower(autoSum(a, b, alloc), 2_ex, alloc));
+        CHECK(sqrt == a);
+    }
+
+    SUBCASE("Mixed arithmetic")
+    {
+        const Expr c = a + a + 2_ex*b + 2_ex*a/3_ex;
+        const Expr d = 3_ex*b*b*c + 2_ex*a - 4_ex*b;
+        const Expr e = 2_ex*a/7_ex*b*c*c - 2_ex*b;
+
+        const Expr expectedC = autoSum(
+          {a, a, autoProduct(2_ex, b, alloc), autoProduct({2_ex, a, Expr{1, 3, alloc}}, alloc)},
+          alloc);
+        const Expr expectedD =
+          autoSum({autoProduct({3_ex, b, b, expectedC}, alloc), autoProduct(2_ex, a, alloc),
+                    autoProduct(Expr{-4, alloc}, b, alloc)},
+            alloc);
+        const Expr expectedE = autoSum(
+          {autoProduct({2_ex, a, Expr{1, 7, alloc}, b, expectedC, expectedC}, alloc),
+            autoProduct(Expr{-2, alloc}, b, alloc)},
+          alloc);
+
+        CHECK(c == expectedC);
+        CHECK(d == expectedD);
+        CHECK(e == expectedE);
+        CHECK(is<sum>(e));
+    }
+
+    SUBCASE("Custom allocator")
+    {
+        StackBuffer<512> arena;
+        const Expr sum = autoSimplify(a + b * 3_ex, &arena);
+
+        CHECK(sum == autoSum(a, autoProduct(b, 3_ex, alloc), alloc));
+    }
+
+    SUBCASE("Stored nodes can't be used")
+    {
+        using Sum = decltype(a + b);
+
+        static_assert(!std::is_copy_constructible_v<Sum>);
+        static_assert(!std::is_convertible_v<Sum&, Expr>);
+        static_assert(!std::is_convertible_v<const Sum&, Expr>);
+        static_assert(!AddableAsLvalue<Sum>);
+        static_assert(!SimplifiableAsLvalue<Sum>);
+        static_assert(std::is_convertible_v<Sum, Expr>);
+    }
+}
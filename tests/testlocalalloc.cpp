@@ -130,20 +130,22 @@ TEST_CASE("LocalAlloc")
 
     SUBCASE("Scoped allocator for nested container")
     {
-        StackBuffer<128> arena{nullptr, false};
+        // Room for the Exprs themselves and one symbol name that doesn't fit into their inline
+        // storage, which then has to be allocated from the same arena:
+        StackBuffer<3 * sizeof(Expr) + 8 * sizeof(Blob)> arena{nullptr, false};
         ScopedLocalVec<Expr> v{&arena};
 
         v.reserve(3);
 
         v.emplace_back("a");
-        v.emplace_back("b");
+        v.emplace_back("abcdefghijklmnopqrstuvwxyz");
 
-        CHECK_THROWS_AS(v.emplace_back("c"), std::bad_alloc);
+        CHECK_THROWS_AS(v.emplace_back("abcdefghijklmnopqrstuvwxyz"), std::bad_alloc);
     }
 
     SUBCASE("Scoped allocator for nested Expr move- and copy-construct")
     {
-        StackBuffer<128> arena{nullptr, false};
+        StackBuffer<3 * sizeof(Expr)> arena{nullptr, false};
         ScopedLocalVec<Expr> v{&arena};
 
         v.reserve(3);
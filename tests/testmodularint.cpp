@@ -0,0 +1,161 @@
+#include <cstdint>
+#include <stdexcept>
+#include "doctest/doctest.h"
+#include "modulararithmetic.h"
+#include "numberarithmetic.h"
+#include "sym2/autosimpl.h"
+#include "sym2/blob.h"
+#include "sym2/expr.h"
+#include "sym2/get.h"
+#include "sym2/hash.h"
+#include "sym2/predicates.h"
+#include "sym2/query.h"
+#include "testutils.h"
+
+using namespace sym2;
+
+TEST_CASE("Modular arithmetic")
+{
+    SUBCASE("Supported moduli")
+    {
+        CHECK(isSupportedModulus(3));
+        CHECK(isSupportedModulus(37));
+        CHECK(isSupportedModulus(1000000007));
+        CHECK(isSupportedModulus(9223372036854775783u)); // Largest prime below 2^63
+
+        CHECK_FALSE(isSupportedModulus(0));
+        CHECK_FALSE(isSupportedModulus(1));
+        CHECK_FALSE(isSupportedModulus(2));
+        CHECK_FALSE(isSupportedModulus(1000000005));
+        CHECK_FALSE(isSupportedModulus(3215031751)); // Strong pseudoprime to the bases 2, 3, 5, 7
+        CHECK_FALSE(isSupportedModulus(18446744073709551557u)); // Prime, but too large
+    }
+
+    SUBCASE("Montgomery products match the wide division")
+    {
+        const std::uint64_t p = 9223372036854775783u;
+        const ModularArithmetic arithmetic{p};
+        std::uint64_t lhs = 123456789;
+
+        for (std::uint64_t rhs = 1; rhs < p / 2; rhs = rhs * 3 + 7) {
+            __extension__ typedef unsigned __int128 Wide;
+            const auto expected = static_cast<std::uint64_t>(Wide{lhs} * rhs % p);
+
+            CHECK(arithmetic.multiply(lhs, rhs) == expected);
+
+            lhs = expected;
+        }
+    }
+
+    SUBCASE("Sums, differences and inverses")
+    {
+        const ModularArithmetic arithmetic{7};
+
+        CHECK(arithmetic.add(5, 4) == 2);
+        CHECK(arithmetic.subtract(2, 4) == 5);
+        CHECK(arithmetic.power(3, 6) == 1);
+        CHECK(arithmetic.inverse(3) == 5);
+        CHECK(arithmetic.residue(std::int64_t{-9}) == 5);
+        CHECK(arithmetic.residue(LargeRational{1, 3}) == 5);
+        CHECK_FALSE(arithmetic.residue(LargeRational{1, 14}).has_value());
+    }
+}
+
+TEST_CASE("Modular integers")
+{
+    const Expr::allocator_type alloc{};
+    const std::uint64_t p = 1000000007;
+    const auto mod = [&alloc, p](std::uint64_t n) { return Expr{ModularInt{n, p}, alloc}; };
+    const Expr a{"a", alloc};
+    const Expr b{"b", alloc};
+
+    SUBCASE("Construction")
+    {
+        const Expr n = mod(p + 5);
+
+        CHECK(is < number && modularInt && realDomain > (n));
+        CHECK((get<ModularInt>(n) == ModularInt{5, p}));
+        CHECK(get<double>(n) == 5.0);
+        CHECK(n == mod(5));
+        CHECK(n != mod(6));
+        CHECK((n != Expr{ModularInt{5, 13}, alloc}));
+        CHECK(n != 5_ex);
+        CHECK(hash(n) == hash(mod(5)));
+
+        CHECK_THROWS_AS(Expr(ModularInt{1, 15}, alloc), std::domain_error);
+        CHECK_THROWS_AS(Expr(ModularInt{1, 2}, alloc), std::domain_error);
+    }
+
+    SUBCASE("Complex numbers with modular parts are rejected")
+    {
+        CHECK_THROWS_AS(directComplex(mod(3), 1_ex, alloc), std::invalid_argument);
+        CHECK_THROWS_AS(directComplex(1_ex, mod(3), alloc), std::invalid_argument);
+    }
+
+    SUBCASE("Residue classes have no sign")
+    {
+        const Expr c{"c", DomainFlag::positive, alloc};
+        const Expr product = directProduct({mod(3), c}, alloc);
+
+        CHECK_FALSE(is<positive>(mod(3)));
+        CHECK_FALSE(is<negative>(mod(3)));
+        CHECK_FALSE(is<positive>(mod(0)));
+        CHECK_FALSE(hasSummaryFlag(ExprView<>{product}.get(), SummaryFlag::positive));
+        CHECK_FALSE(is<positive>(product));
+        CHECK_FALSE(is<negative>(product));
+    }
+
+    SUBCASE("Number arithmetic")
+    {
+        NumberArithmetic numerics{alloc};
+
+        CHECK(numerics.add(mod(p - 1), mod(3)) == mod(2));
+        CHECK(numerics.subtract(mod(1), mod(3)) == mod(p - 2));
+        CHECK(numerics.multiply(mod(p - 1), mod(p - 1)) == mod(1));
+        CHECK(numerics.add(mod(1), Expr{-3, alloc}) == mod(p - 2));
+        CHECK(numerics.multiply(Expr{1, 2, alloc}, mod(2)) == mod(1));
+        CHECK(numerics.multiply(mod(1), Expr{LargeInt{LargeInt{p} * p + 4}, alloc}) == mod(4));
+
+        CHECK_THROWS_AS(numerics.add(mod(1), Expr{1.5, alloc}), std::domain_error);
+        CHECK_THROWS_AS(
+          numerics.add(mod(1), Expr{ModularInt{1, 13}, alloc}), std::domain_error);
+        CHECK_THROWS_AS(
+          numerics.multiply(mod(1), Expr{LargeRational{1, p}, alloc}), std::domain_error);
+    }
+
+    SUBCASE("Coefficients are collected in their residue class")
+    {
+        const Expr sum = autoSum(
+          {autoProduct(mod(3), a, alloc), a, autoProduct(mod(p - 3), a, alloc)}, alloc);
+
+        CHECK(sum == autoProduct(mod(1), a, alloc));
+        CHECK(autoProduct({mod(3), a, 2_ex}, alloc) == autoProduct(mod(6), a, alloc));
+    }
+
+    SUBCASE("Zero of a residue class")
+    {
+        const Expr minusA = autoProduct(mod(p - 1), a, alloc);
+
+        CHECK(autoSum(mod(p - 1), mod(1), alloc) == 0_ex);
+        CHECK(autoSum(autoProduct(mod(1), a, alloc), minusA, alloc) == 0_ex);
+        CHECK(autoSum(a, minusA, alloc) == 0_ex);
+        CHECK(autoSum({a, minusA, b}, alloc) == b);
+        CHECK(autoSum(mod(0), a, alloc) == a);
+        CHECK(autoProduct(mod(0), a, alloc) == mod(0));
+        CHECK(autoProduct({a, b, mod(0)}, alloc) == mod(0));
+    }
+
+    SUBCASE("Powers")
+    {
+        const Expr largeExp{LargeInt{LargeInt{p - 1} * 1000 + 10}, alloc};
+
+        CHECK(autoPower(mod(3), Expr{-1, alloc}, alloc) == mod(333333336));
+        CHECK(autoPower(mod(2), largeExp, alloc) == mod(1024));
+        CHECK(autoPower(mod(5), 0_ex, alloc) == mod(1));
+        CHECK(autoPower(mod(0), 2_ex, alloc) == mod(0));
+        CHECK(is<power>(autoPower(mod(3), Expr{1, 2, alloc}, alloc)));
+        CHECK(is<power>(autoPower(a, mod(3), alloc)));
+
+        CHECK_THROWS_AS(autoPower(mod(0), Expr{-1, alloc}, alloc), std::invalid_argument);
+    }
+}
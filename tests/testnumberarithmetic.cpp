@@ -0,0 +1,60 @@
+#include "doctest/doctest.h"
+#include "numberarithmetic.h"
+#include "sym2/expr.h"
+#include "sym2/query.h"
+#include "testutils.h"
+
+using namespace sym2;
+
+TEST_CASE("Complex number arithmetic")
+{
+    const Expr::allocator_type alloc{};
+    NumberArithmetic numerics{alloc};
+    const Expr half{1, 2, alloc};
+    const Expr third{1, 3, alloc};
+    const auto complex = [&alloc](ExprView<> real, ExprView<> imag) {
+        return directComplex(real, imag, alloc);
+    };
+
+    SUBCASE("Exact products")
+    {
+        const Expr lhs = complex(half, 3_ex);
+        const Expr rhs = complex(2_ex, Expr{-1, 3, alloc});
+
+        CHECK(numerics.multiply(lhs, rhs) == complex(2_ex, Expr{35, 6, alloc}));
+        CHECK(numerics.multiply(2_ex, lhs) == complex(1_ex, 6_ex));
+        CHECK(numerics.multiply(lhs, third) == complex(Expr{1, 6, alloc}, 1_ex));
+    }
+
+    SUBCASE("Products that exceed small rationals")
+    {
+        const Expr n{30000, alloc};
+        const Expr large{LargeInt{1} << 40, alloc};
+        const Expr product = numerics.multiply(complex(n, n), complex(n, n));
+
+        CHECK(product == complex(0_ex, Expr{LargeInt{1800000000}, alloc}));
+        CHECK(numerics.multiply(complex(large, 1_ex), complex(large, Expr{-1, alloc}))
+          == complex(Expr{(LargeInt{1} << 80) + 1, alloc}, 0_ex));
+    }
+
+    SUBCASE("Floating point products")
+    {
+        const Expr product =
+          numerics.multiply(complex(Expr{1.5, alloc}, 2_ex), complex(3_ex, 4_ex));
+
+        CHECK(product == complex(Expr{-3.5, alloc}, Expr{12.0, alloc}));
+        CHECK(is<floatingPoint>(imag(product)));
+    }
+
+    SUBCASE("Sums and differences")
+    {
+        const Expr lhs = complex(half, 3_ex);
+        const Expr rhs = complex(third, Expr{0.5, alloc});
+
+        CHECK(numerics.add(lhs, rhs) == complex(Expr{5, 6, alloc}, Expr{3.5, alloc}));
+        CHECK(numerics.subtract(lhs, rhs) == complex(Expr{1, 6, alloc}, Expr{2.5, alloc}));
+        CHECK(numerics.subtract(complex(1_ex, 2_ex), 3_ex) == complex(Expr{-2, alloc}, 2_ex));
+        CHECK(numerics.add(Expr{32767, alloc}, complex(Expr{32767, alloc}, 1_ex))
+          == complex(Expr{LargeInt{65534}, alloc}, 1_ex));
+    }
+}
@@ -0,0 +1,90 @@
+#include <cmath>
+#include "doctest/doctest.h"
+#include "sym2/autosimpl.h"
+#include "sym2/blob.h"
+#include "sym2/expr.h"
+#include "sym2/query.h"
+#include "testutils.h"
+
+using namespace sym2;
+
+TEST_CASE("Ordered terms")
+{
+    const Expr::allocator_type alloc{};
+    const Expr a{"a", alloc};
+    const Expr b{"b", alloc};
+    const Expr c{"c", alloc};
+    const Expr d{"d", alloc};
+    const Expr longName{"aSymbolWithAVeryLongName", alloc};
+    const Expr fp{1.5, alloc};
+    const Expr twoC = autoProduct(2_ex, c, alloc);
+    const Expr sinA{"sin", a, std::sin, alloc};
+    // 1.5 + a + 2*c + aSymbolWithAVeryLongName + sin(a):
+    const Expr sum = autoSum({fp, a, twoC, longName, sinA}, alloc);
+
+    SUBCASE("Find term")
+    {
+        REQUIRE(nOperands(sum) == 5);
+
+        for (std::uint16_t i = 0; i < 5; ++i)
+            CHECK(findTerm(sum, nthOperand(sum, i)) == i);
+
+        CHECK(findTerm(sum, b) == std::nullopt);
+        CHECK(findTerm(sum, c) == std::nullopt);
+        CHECK(findTerm(sum, 2_ex) == std::nullopt);
+    }
+
+    SUBCASE("Insert term")
+    {
+        const Expr cSquare = autoPower(c, 2_ex, alloc);
+
+        for (const ExprView<> term : {ExprView<>{b}, ExprView<>{d}, ExprView<>{cSquare}}) {
+            const Expr result = insertTerm(sum, term, alloc);
+
+            CHECK(result == autoSum(sum, term, alloc));
+            CHECK(findTerm(result, term).has_value());
+        }
+
+        const Expr power = autoPower(autoSum(b, fp, alloc), longName, alloc);
+
+        CHECK(insertTerm(sum, power, alloc) == autoSum(sum, power, alloc));
+    }
+
+    SUBCASE("Remove term")
+    {
+        CHECK(removeTerm(sum, twoC, alloc) == autoSum({fp, a, longName, sinA}, alloc));
+        CHECK(removeTerm(sum, fp, alloc) == autoSum({a, twoC, longName, sinA}, alloc));
+        CHECK(removeTerm(sum, sinA, alloc) == autoSum({fp, a, twoC, longName}, alloc));
+        CHECK(removeTerm(sum, b, alloc) == sum);
+    }
+
+    SUBCASE("Remove second to last term")
+    {
+        const Expr product = autoProduct(a, sinA, alloc);
+
+        CHECK(removeTerm(product, a, alloc) == sinA);
+        CHECK(removeTerm(product, sinA, alloc) == a);
+    }
+
+    SUBCASE("Round trip in product")
+    {
+        const Expr product = autoProduct({a, longName, sinA}, alloc);
+        const Expr inserted = insertTerm(product, c, alloc);
+
+        CHECK(inserted == autoProduct(product, c, alloc));
+        CHECK(removeTerm(inserted, c, alloc) == product);
+        CHECK(remoteExtent(ExprView<>{removeTerm(inserted, c, alloc)}.get())
+          == remoteExtent(ExprView<>{product}.get()));
+    }
+
+    SUBCASE("Shared subtrees")
+    {
+        const Expr aPlusB = autoSum(a, b, alloc);
+        const Expr product = autoProduct(
+          {autoPower(aPlusB, 2_ex, alloc), Expr{"sin", aPlusB, std::sin, alloc}, c}, alloc);
+        const Expr shared = shareSubtrees(product, alloc);
+
+        CHECK(insertTerm(shared, d, alloc) == autoProduct(product, d, alloc));
+        CHECK(removeTerm(shared, c, alloc) == removeTerm(product, c, alloc));
+    }
+}
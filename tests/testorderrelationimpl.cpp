@@ -1,10 +1,14 @@
 
 #include <algorithm>
 #include <array>
+#include <cmath>
 #include <vector>
 #include "doctest/doctest.h"
+#include "orderrelation.h"
 #include "orderrelationimpl.h"
 #include "sym2/autosimpl.h"
+#include "sym2/constants.h"
+#include "sym2/symboltable.h"
 
 using namespace sym2;
 
@@ -28,4 +32,38 @@ TEST_CASE("Order relation")
         CHECK_FALSE(productsOrSums(lhs, rhs));
         CHECK_FALSE(productsOrSums(rhs, lhs));
     }
+
+    SUBCASE("Ordering keys agree with the structural order")
+    {
+        const Expr::allocator_type alloc{};
+        const Expr a{"a", alloc};
+        const Expr b{"b", alloc};
+        const Expr longName{"aSymbolWithAVeryLongName", alloc};
+        const Expr sqrtTwo = autoPower(2_ex, Expr{1, 2, alloc}, alloc);
+        const Expr sinA{"sin", a, std::sin, alloc};
+        const std::array<Expr, 22> exprs{Expr{1, 3, alloc}, Expr{1.5, alloc}, Expr{pi, alloc},
+          Expr{euler, alloc}, Expr{a, alloc}, Expr{b, alloc},
+          Expr{"a", DomainFlag::positive, alloc}, Expr{internSymbol("b"), alloc},
+          Expr{longName, alloc}, Expr{"aSymbolWithAVeryLongNamf", alloc}, Expr{sinA, alloc},
+          Expr{"a", b, std::sin, alloc}, Expr{sqrtTwo, alloc}, autoProduct(2_ex, pi, alloc),
+          autoProduct(sqrtTwo, a, alloc), autoProduct(a, b, alloc), autoSum(a, b, alloc),
+          autoSum(pi, sqrtTwo, alloc), autoPower(a, 2_ex, alloc), autoPower(sinA, b, alloc),
+          autoPower(autoSum(a, b, alloc), longName, alloc), autoProduct(b, sinA, alloc)};
+        std::vector<ExprView<>> views{exprs.begin(), exprs.end()};
+
+        for (const ExprView<> lhs : views)
+            for (const ExprView<> rhs : views) {
+                const std::uint64_t lhsKey = orderingKey(lhs);
+                const std::uint64_t rhsKey = orderingKey(rhs);
+
+                if (lhsKey != rhsKey)
+                    CHECK(structuralLessThan(lhs, rhs) == (lhsKey < rhsKey));
+
+                CHECK(orderLessThan(lhs, rhs) == structuralLessThan(lhs, rhs));
+            }
+
+        sortByOrder(views, alloc);
+
+        CHECK(std::is_sorted(views.begin(), views.end(), structuralLessThan));
+    }
 }
@@ -0,0 +1,123 @@
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include "doctest/doctest.h"
+#include "sym2/autosimpl.h"
+#include "sym2/expr.h"
+#include "sym2/query.h"
+
+using namespace sym2;
+
+TEST_CASE("Parallel simplification")
+{
+    const Expr::allocator_type alloc{};
+    const ParallelSimplification policy{.minOperands = 64, .chunkSize = 16};
+    std::uint32_t state = 42;
+    const auto next = [&state](std::uint32_t n) {
+        state = state * 1664525u + 1013904223u;
+        return static_cast<std::int32_t>((state >> 8) % n);
+    };
+    const auto symbol = [&](std::uint32_t n) {
+        return Expr{std::string(1, static_cast<char>('a' + next(n))), alloc};
+    };
+
+    ScopedLocalVec<Expr> operands{alloc};
+    LocalVec<ExprView<>> ops{alloc};
+
+    const auto collect = [&]() {
+        ops.assign(operands.begin(), operands.end());
+        return std::span<const ExprView<>>{ops};
+    };
+
+    SUBCASE("Sums with like terms")
+    {
+        for (int i = 0; i < 500; ++i)
+            switch (next(5)) {
+                case 0:
+                    operands.emplace_back(next(9) - 4, next(7) + 1);
+                    break;
+                case 1:
+                    operands.push_back(symbol(6));
+                    break;
+                case 2:
+                    operands.push_back(
+                      autoProduct({Expr{next(9) - 4, alloc}, symbol(4), symbol(4)}, alloc));
+                    break;
+                case 3:
+                    operands.push_back(autoPower(symbol(3), Expr{next(4) + 2, alloc}, alloc));
+                    break;
+                default:
+                    operands.push_back(
+                      autoSum(symbol(8), Expr{"sin", symbol(3), std::sin, alloc}, alloc));
+            }
+
+        const Expr sequential = autoSum(collect(), alloc);
+
+        CHECK(is<sum>(sequential));
+        CHECK(autoSum(collect(), policy, alloc) == sequential);
+    }
+
+    SUBCASE("Sums that cancel")
+    {
+        for (int i = 0; i < 300; ++i) {
+            const Expr term = autoProduct(symbol(10), symbol(10), alloc);
+
+            operands.push_back(autoProduct(Expr{i % 3 + 1, alloc}, term, alloc));
+            operands.push_back(autoProduct(Expr{-(i % 3) - 1, alloc}, term, alloc));
+        }
+
+        CHECK(autoSum(collect(), policy, alloc) == 0_ex);
+    }
+
+    SUBCASE("Products with equal bases")
+    {
+        for (int i = 0; i < 400; ++i)
+            switch (next(4)) {
+                case 0:
+                    operands.emplace_back(next(5) + 1, next(5) + 1);
+                    break;
+                case 1:
+                    operands.push_back(symbol(8));
+                    break;
+                case 2:
+                    operands.push_back(autoPower(symbol(5), Expr{next(7) - 3, alloc}, alloc));
+                    break;
+                default:
+                    operands.push_back(autoPower(symbol(3), symbol(3), alloc));
+            }
+
+        const Expr sequential = autoProduct(collect(), alloc);
+
+        CHECK(is<product>(sequential));
+        CHECK(autoProduct(collect(), policy, alloc) == sequential);
+    }
+
+    SUBCASE("Sequential fallback")
+    {
+        const Expr sqrtTwo = autoPower(2_ex, Expr{1, 2, alloc}, alloc);
+
+        for (int i = 0; i < 200; ++i) {
+            operands.push_back(i % 50 == 0 ? Expr{0.1 * i, alloc} : symbol(20));
+            operands.push_back(i % 60 == 0 ? Expr{sqrtTwo, alloc} : Expr{i % 7 + 1, alloc});
+        }
+
+        CHECK(autoSum(collect(), policy, alloc) == autoSum(collect(), alloc));
+        CHECK(autoProduct(collect(), policy, alloc) == autoProduct(collect(), alloc));
+    }
+
+    SUBCASE("Merged powers of products fall back to sequential")
+    {
+        const Expr a{"a", alloc};
+        const Expr b{"b", alloc};
+        const Expr c{"c", alloc};
+        const Expr inverseA = autoPower(a, Expr{-1, alloc}, alloc);
+        const Expr sqrtAB = autoPower(autoProduct(a, b, alloc), Expr{1, 2, alloc}, alloc);
+        const std::array<ExprView<>, 4> factors{inverseA, sqrtAB, c, sqrtAB};
+        const ParallelSimplification eager{.minOperands = 0, .chunkSize = 1};
+        const Expr sequential = autoProduct(factors, alloc);
+
+        CHECK(autoProduct(factors, eager, alloc) == sequential);
+        CHECK(nOperands(sequential) == 2);
+    }
+}
@@ -186,6 +186,59 @@ TEST_CASE("Type queries for simple types")
     }
 }
 
+TEST_CASE("Domain, evaluability and sign of composites")
+{
+    const Expr::allocator_type alloc{};
+    const Expr a{"a", alloc};
+    const Expr b{"b", DomainFlag::real, alloc};
+    const Expr c{"c", DomainFlag::positive, alloc};
+    const Expr fp{3.14, alloc};
+    const Expr cx = directComplex(2_ex, 3_ex, alloc);
+    const Expr sqrtTwo = directPower(2_ex, Expr{1, 2, alloc}, alloc);
+
+    SUBCASE("Numerically evaluable")
+    {
+        const Expr s = directSum({fp, pi, directProduct({cx, sqrtTwo}, alloc)}, alloc);
+        const Expr sinOfSum{"sin", directSum({s, c}, alloc), std::sin, alloc};
+
+        CHECK(is<numericallyEvaluable>(s));
+        CHECK_FALSE(is<numericallyEvaluable>(directSum({s, directPower(2_ex, a, alloc)}, alloc)));
+        CHECK_FALSE(is<numericallyEvaluable>(sinOfSum));
+    }
+
+    SUBCASE("Real domain")
+    {
+        CHECK(is<realDomain>(directSum({b, c, directPower(b, sqrtTwo, alloc)}, alloc)));
+        CHECK(is<realDomain>(Expr{"atan2", b, fp, std::atan2, alloc}));
+        CHECK_FALSE(is<realDomain>(directSum({b, directProduct({c, a}, alloc)}, alloc)));
+        CHECK_FALSE(is<realDomain>(directProduct({b, cx}, alloc)));
+    }
+
+    SUBCASE("Complex domain")
+    {
+        CHECK(is<complexDomain>(directProduct({a, cx}, alloc)));
+        CHECK(is<complexDomain>(directPower(a, Expr{"sin", cx, std::sin, alloc}, alloc)));
+        CHECK_FALSE(is<complexDomain>(directSum({a, cx, b}, alloc)));
+        CHECK_FALSE(is<complexDomain>(directSum({a, 2_ex}, alloc)));
+    }
+
+    SUBCASE("Positive")
+    {
+        CHECK(is<positive>(directSum({c, pi, directProduct({fp, c}, alloc)}, alloc)));
+        CHECK(is<positive>(directPower(c, b, alloc)));
+        CHECK_FALSE(is<positive>(directPower(c, a, alloc)));
+        CHECK_FALSE(is<positive>(directSum({c, b}, alloc)));
+    }
+
+    SUBCASE("Positive base with a non-real exponent without non-real leaves")
+    {
+        const Expr imaginaryUnit = directPower(Expr{-1, alloc}, Expr{1, 2, alloc}, alloc);
+
+        CHECK_FALSE(is<positive>(directPower(2_ex, imaginaryUnit, alloc)));
+        CHECK(is<positive>(directPower(2_ex, directSum({c, b}, alloc), alloc)));
+    }
+}
+
 TEST_CASE("Type queries for tagged types")
 {
     const auto n = 42_ex;
@@ -197,3 +250,37 @@ TEST_CASE("Type queries for tagged types")
     CHECK(is<number>(
       ExprView < !symbol && !function && !(sum || power || complexDomain || !small) > {n}));
 }
+
+TEST_CASE("Folding of header type predicates")
+{
+    const Expr::allocator_type alloc{};
+    const Expr a{"a", alloc};
+    const Expr two{2, alloc};
+    const Expr minusTwo{-2, alloc};
+    const Expr s = directSum({two, a}, alloc);
+
+    SUBCASE("Header-only predicate expressions are folded")
+    {
+        using detail::Classification;
+
+        static_assert(Classification<decltype(number && !sum)>::foldable);
+        static_assert(Classification<decltype(!(symbol || constant) && scalar)>::foldable);
+        static_assert(Classification<decltype(number || !composite)>::mask == scalarTypes);
+        static_assert(!Classification<decltype(number && negative)>::foldable);
+        static_assert(!Classification<decltype(positive)>::foldable);
+    }
+
+    SUBCASE("Mixed predicate expressions")
+    {
+        for (ExprView<> e : std::initializer_list<ExprView<>>{minusTwo, s})
+            CHECK(is < (number && negative) || !scalar > (e));
+
+        for (ExprView<> e : std::initializer_list<ExprView<>>{a, two, pi})
+            CHECK_FALSE(is < (number && negative) || !scalar > (e));
+
+        CHECK(is < !(sum || product) && !positive > (minusTwo));
+        CHECK_FALSE(is < !(sum || product) && !positive > (s));
+        CHECK(is < (symbol || sum) && !negative > (a));
+        CHECK(is < !(number && !negative) > (minusTwo));
+    }
+}
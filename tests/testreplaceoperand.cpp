@@ -0,0 +1,98 @@
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include "doctest/doctest.h"
+#include "sym2/autosimpl.h"
+#include "sym2/blob.h"
+#include "sym2/expr.h"
+#include "sym2/query.h"
+#include "testutils.h"
+
+using namespace sym2;
+
+TEST_CASE("Replace operand")
+{
+    const Expr::allocator_type alloc{};
+    const Expr a{"a", alloc};
+    const Expr b{"b", alloc};
+    const Expr c{"c", alloc};
+    const Expr longName{"aSymbolWithAVeryLongName", alloc};
+    const Expr large{LargeInt{"123456789012345678901234567890"}, alloc};
+    const Expr fp{1.5, alloc};
+    // a + b*c*1.5 + aSymbolWithAVeryLongName + 123456789012345678901234567890:
+    const Expr original =
+      directSum({a, directProduct({b, c, fp}, alloc), longName, large}, alloc);
+
+    SUBCASE("Larger replacement")
+    {
+        const Expr expected =
+          directSum({a, directProduct({large, c, fp}, alloc), longName, large}, alloc);
+        const std::array<std::uint16_t, 2> path{1, 0};
+
+        CHECK(replaceOperand(original, path, large, alloc) == expected);
+    }
+
+    SUBCASE("Smaller replacement")
+    {
+        const Expr expected = directSum({a, b, longName, large}, alloc);
+        const Expr result = replaceOperand(original, std::array<std::uint16_t, 1>{1}, b, alloc);
+
+        CHECK(result == expected);
+        CHECK(remoteExtent(ExprView<>{result}.get()) == remoteExtent(ExprView<>{expected}.get()));
+    }
+
+    SUBCASE("Replace last operand with nested composite")
+    {
+        const Expr power = directPower(directSum({b, fp}, alloc), longName, alloc);
+        const Expr product = directProduct({b, c}, alloc);
+        const Expr root = directSum({directProduct({a, b}, alloc), product}, alloc);
+        const Expr expected = directSum({directProduct({a, power}, alloc), product}, alloc);
+
+        CHECK(replaceOperand(root, std::array<std::uint16_t, 2>{0, 1}, power, alloc) == expected);
+    }
+
+    SUBCASE("Function argument")
+    {
+        const Expr fct{"atan2", directSum({a, large}, alloc), longName, std::atan2, alloc};
+        const Expr expected{"atan2", directSum({fp, large}, alloc), longName, std::atan2, alloc};
+
+        CHECK(replaceOperand(fct, std::array<std::uint16_t, 2>{0, 0}, fp, alloc) == expected);
+    }
+
+    SUBCASE("Empty path")
+    {
+        CHECK(replaceOperand(original, {}, longName, alloc) == longName);
+    }
+
+    SUBCASE("Shared subtrees")
+    {
+        const Expr aPlusB = directSum({a, b}, alloc);
+        const Expr root = directProduct({aPlusB, directPower(aPlusB, 2_ex, alloc)}, alloc);
+        const Expr expected =
+          directProduct({directSum({a, c}, alloc), directPower(aPlusB, 2_ex, alloc)}, alloc);
+        const Expr shared = shareSubtrees(root, alloc);
+
+        CHECK(replaceOperand(shared, std::array<std::uint16_t, 2>{0, 1}, c, alloc) == expected);
+    }
+
+    SUBCASE("Invalid path")
+    {
+        CHECK_THROWS_AS(replaceOperand(original, std::array<std::uint16_t, 1>{4}, a, alloc),
+          std::out_of_range);
+        CHECK_THROWS_AS(replaceOperand(original, std::array<std::uint16_t, 2>{0, 0}, a, alloc),
+          std::out_of_range);
+    }
+
+    SUBCASE("Simplify ancestors")
+    {
+        // a + 2*b, where b is replaced by a:
+        const Expr root = autoSum(a, autoProduct(2_ex, b, alloc), alloc);
+        const std::array<std::uint16_t, 2> path{1, 1};
+
+        REQUIRE(nthOperand(nthOperand(root, 1), 1) == b);
+
+        CHECK(autoReplaceOperand(root, path, a, alloc) == autoProduct(3_ex, a, alloc));
+        CHECK_THROWS_AS(autoReplaceOperand(root, std::array<std::uint16_t, 1>{2}, a, alloc),
+          std::out_of_range);
+    }
+}
@@ -0,0 +1,126 @@
+#include <cmath>
+#include "doctest/doctest.h"
+#include "sym2/autosimpl.h"
+#include "sym2/blob.h"
+#include "sym2/expr.h"
+#include "sym2/exprvector.h"
+#include "sym2/get.h"
+#include "sym2/operandsview.h"
+#include "sym2/query.h"
+#include "testutils.h"
+
+using namespace sym2;
+
+namespace {
+    bool hasReferences(ExprView<> e)
+    {
+        return hasSummaryFlag(e.get(), SummaryFlag::containsReference);
+    }
+
+    std::uint32_t nBlobs(ExprView<> e)
+    {
+        return remoteExtent(e.get()) + 1;
+    }
+}
+
+TEST_CASE("Shared subtrees")
+{
+    const Expr::allocator_type alloc{};
+    const Expr a{"a", alloc};
+    const Expr b{"b", alloc};
+    const Expr aPlusB = directSum({a, b}, alloc);
+    const Expr sinAPlusB{"sin", aPlusB, std::sin, alloc};
+    const Expr square = directPower(aPlusB, 2_ex, alloc);
+    const Expr inverse = directPower(aPlusB, Expr{-1, alloc}, alloc);
+    // (a + b)^2*sin(a + b)*(a + b)^(-1):
+    const Expr original = directProduct({square, sinAPlusB, inverse}, alloc);
+    const Expr shared = shareSubtrees(original, alloc);
+
+    SUBCASE("Repeated subtrees are stored once")
+    {
+        CHECK(hasReferences(shared));
+        CHECK_FALSE(hasReferences(original));
+        CHECK(nBlobs(shared) < nBlobs(original));
+        CHECK(nBlobs(shared) == nBlobs(original) - 2 * (nBlobs(aPlusB) - 1));
+    }
+
+    SUBCASE("Equality follows references")
+    {
+        CHECK(shared == original);
+        CHECK(original == shared);
+        CHECK(shared == shareSubtrees(shared, alloc));
+        CHECK(shared != directProduct({square, sinAPlusB, square}, alloc));
+        CHECK(shared != shareSubtrees(directProduct({square, sinAPlusB, square}, alloc), alloc));
+    }
+
+    SUBCASE("Operands are resolved")
+    {
+        const OperandsView ops = OperandsView::operandsOf(shared);
+
+        CHECK_RANGES_EQ(ops, OperandsView::operandsOf(original));
+        CHECK(nOperands(shared) == 3);
+        CHECK(get<std::string_view>(nthOperand(shared, 1)) == "sin");
+        CHECK(firstOperand(nthOperand(shared, 1)) == aPlusB);
+        CHECK(firstOperand(nthOperand(shared, 2)) == aPlusB);
+        CHECK(is<sum>(firstOperand(nthOperand(shared, 2))));
+        CHECK(nOperands(firstOperand(nthOperand(shared, 2))) == 2);
+        CHECK(secondOperand(firstOperand(nthOperand(shared, 2))) == b);
+    }
+
+    SUBCASE("Duplicating operands that refer outside of themselves")
+    {
+        const ExprView<> sin = nthOperand(shared, 1);
+        const Expr duplicate{sin, alloc};
+
+        CHECK(duplicate == sinAPlusB);
+        CHECK(Expr{nthOperand(shared, 2), alloc} == inverse);
+        CHECK(directSum({sin, nthOperand(shared, 2)}, alloc)
+          == directSum({sinAPlusB, inverse}, alloc));
+
+        ExprVector exprs{alloc};
+
+        exprs.push_back(sin);
+        exprs.push_back(shared);
+
+        CHECK(exprs[0] == sinAPlusB);
+        CHECK(exprs[1] == original);
+    }
+
+    SUBCASE("Identical references to different subtrees aren't equal")
+    {
+        const Expr c{"c", alloc};
+        const Expr d{"d", alloc};
+        const Expr cPlusD = directSum({c, d}, alloc);
+        const Expr sinCPlusD{"sin", cPlusD, std::sin, alloc};
+        const Expr lhs = shareSubtrees(directProduct({aPlusB, sinAPlusB}, alloc), alloc);
+        const Expr rhs = shareSubtrees(directProduct({cPlusD, sinCPlusD}, alloc), alloc);
+        const ExprView<> lhsSin = secondOperand(lhs);
+        const ExprView<> rhsSin = secondOperand(rhs);
+
+        REQUIRE(hasReferences(lhs));
+        CHECK(lhsSin == sinAPlusB);
+        CHECK(rhsSin == sinCPlusD);
+        CHECK(lhsSin != rhsSin);
+        CHECK(autoSum(lhsSin, rhsSin, alloc) == directSum({sinAPlusB, sinCPlusD}, alloc));
+    }
+
+    SUBCASE("Duplicating self-contained trees keeps references")
+    {
+        const Expr copy{ExprView<>{shared}, alloc};
+        const Expr pw = directPower(shared, 3_ex, alloc);
+
+        CHECK(hasReferences(copy));
+        CHECK(nBlobs(copy) == nBlobs(shared));
+        CHECK(hasReferences(pw));
+        CHECK(firstOperand(pw) == original);
+    }
+
+    SUBCASE("Nothing to share")
+    {
+        const Expr unique = shareSubtrees(aPlusB, alloc);
+
+        CHECK_FALSE(hasReferences(unique));
+        CHECK(nBlobs(unique) == nBlobs(aPlusB));
+        CHECK(unique == aPlusB);
+    }
+}
@@ -0,0 +1,189 @@
+#include <array>
+#include <cmath>
+#include <vector>
+#include "doctest/doctest.h"
+#include "sym2/autosimpl.h"
+#include "sym2/expr.h"
+#include "sym2/parallel.h"
+#include "sym2/simplificationcache.h"
+
+using namespace sym2;
+
+TEST_CASE("Simplification cache")
+{
+    const Expr::allocator_type alloc{};
+    using Operation = SimplificationCache::Operation;
+    const Expr a{"a", alloc};
+    const Expr b{"b", alloc};
+    const Expr c{"c", alloc};
+    const Expr sinA{"sin", a, std::sin, alloc};
+    const std::array<ExprView<>, 2> ab{a, b};
+    const std::array<ExprView<>, 2> ba{b, a};
+    const Expr sum = autoSum(a, b, alloc);
+
+    SUBCASE("Lookup and insertion")
+    {
+        SimplificationCache cache{10};
+
+        CHECK_FALSE(cache.lookup(Operation::sum, ab, alloc));
+
+        cache.insert(Operation::sum, ab, sum);
+
+        CHECK(cache.lookup(Operation::sum, ab, alloc) == sum);
+        CHECK_FALSE(cache.lookup(Operation::product, ab, alloc));
+        CHECK_FALSE(cache.lookup(Operation::sum, ba, alloc));
+        CHECK(cache.size() == 1);
+
+        const SimplificationCache::Statistics stats = cache.statistics();
+
+        CHECK(stats.hits == 1);
+        CHECK(stats.misses == 3);
+        CHECK(stats.evictions == 0);
+    }
+
+    SUBCASE("Zero capacity")
+    {
+        SimplificationCache cache{0};
+
+        cache.insert(Operation::sum, ab, sum);
+
+        CHECK(cache.size() == 0);
+        CHECK_FALSE(cache.lookup(Operation::sum, ab, alloc));
+    }
+
+    SUBCASE("Operand counts beyond 16 bit")
+    {
+        SimplificationCache cache{1};
+        const std::vector<ExprView<>> manyOps(65537, a);
+
+        cache.insert(Operation::sum, manyOps, sum);
+
+        CHECK(cache.lookup(Operation::sum, manyOps, alloc) == sum);
+        CHECK_FALSE(cache.lookup(Operation::sum, std::span{manyOps}.first(1), alloc));
+
+        cache.insert(Operation::sum, ab, sum);
+
+        CHECK(cache.size() == 1);
+        CHECK(cache.statistics().evictions == 1);
+        CHECK(cache.lookup(Operation::sum, ab, alloc) == sum);
+    }
+
+    SUBCASE("Least recently used results are evicted")
+    {
+        SimplificationCache cache{2};
+        const std::array<ExprView<>, 2> ac{a, c};
+        const std::array<ExprView<>, 2> bc{b, c};
+
+        cache.insert(Operation::sum, ab, sum);
+        cache.insert(Operation::sum, ac, autoSum(a, c, alloc));
+
+        REQUIRE(cache.lookup(Operation::sum, ab, alloc));
+
+        cache.insert(Operation::sum, bc, autoSum(b, c, alloc));
+
+        CHECK(cache.size() == 2);
+        CHECK(cache.statistics().evictions == 1);
+        CHECK(cache.lookup(Operation::sum, ab, alloc) == sum);
+        CHECK(cache.lookup(Operation::sum, bc, alloc) == autoSum(b, c, alloc));
+        CHECK_FALSE(cache.lookup(Operation::sum, ac, alloc));
+    }
+
+    SUBCASE("Results survive compaction")
+    {
+        SimplificationCache cache{3};
+
+        for (int i = 0; i < 50; ++i) {
+            const Expr n{i, alloc};
+            const std::array<ExprView<>, 2> ops{sinA, n};
+
+            cache.insert(Operation::product, ops, autoProduct(sinA, n, alloc));
+        }
+
+        CHECK(cache.size() == 3);
+        CHECK(cache.statistics().evictions == 47);
+
+        for (int i = 47; i < 50; ++i) {
+            const Expr n{i, alloc};
+            const std::array<ExprView<>, 2> ops{sinA, n};
+
+            CHECK(cache.lookup(Operation::product, ops, alloc) == autoProduct(sinA, n, alloc));
+        }
+    }
+
+    SUBCASE("Clear and reset statistics")
+    {
+        SimplificationCache cache{10};
+
+        cache.insert(Operation::sum, ab, sum);
+        cache.clear();
+
+        CHECK(cache.size() == 0);
+        CHECK_FALSE(cache.lookup(Operation::sum, ab, alloc));
+        CHECK(cache.statistics().misses == 1);
+
+        cache.resetStatistics();
+
+        CHECK(cache.statistics().misses == 0);
+    }
+
+    SUBCASE("Memoized simplification")
+    {
+        SimplificationCache cache{100};
+        const Expr half{1, 2, alloc};
+        const Expr sqrtTwo = autoPower(2_ex, half, alloc);
+        const Expr expected = autoProduct({3_ex, sqrtTwo, sinA}, alloc);
+
+        CHECK(autoProduct({3_ex, sqrtTwo, sinA}, cache, alloc) == expected);
+
+        const SimplificationCache::Statistics first = cache.statistics();
+
+        CHECK(first.hits == 0);
+        CHECK(first.misses > 0);
+
+        CHECK(autoProduct({3_ex, sqrtTwo, sinA}, cache, alloc) == expected);
+        CHECK(cache.statistics().hits == 1);
+        CHECK(cache.statistics().misses == first.misses);
+
+        CHECK(autoPower(8_ex, half, cache, alloc) == autoPower(8_ex, half, alloc));
+        CHECK(autoPower(8_ex, half, cache, alloc) == autoPower(8_ex, half, alloc));
+        CHECK(cache.statistics().hits == 2);
+    }
+
+    SUBCASE("Recursive steps are memoized")
+    {
+        SimplificationCache cache{100};
+        const Expr aSquared = autoPower(a, 2_ex, alloc);
+        const Expr twoPlusB = autoSum(2_ex, b, alloc);
+        const Expr expected = autoPower(a, twoPlusB, alloc);
+
+        CHECK(autoProduct(aSquared, autoPower(a, b, alloc), cache, alloc) == expected);
+
+        const std::array<ExprView<>, 2> power{a, twoPlusB};
+
+        CHECK(cache.lookup(Operation::power, power, alloc) == expected);
+    }
+
+    SUBCASE("Shared between threads")
+    {
+        SimplificationCache cache{16, SimplificationCache::Sharing::shared};
+        ScopedLocalVec<Expr> results{alloc};
+
+        for (std::size_t i = 0; i < 64; ++i)
+            results.emplace_back(0);
+
+        parallelFor(results.size(), [&](std::size_t i) {
+            const Expr n{static_cast<int>(i % 8), alloc};
+            results[i] = autoSum({a, autoProduct(n, b, alloc), n}, cache, alloc);
+        });
+
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            const Expr n{static_cast<int>(i % 8), alloc};
+            CHECK(results[i] == autoSum({a, autoProduct(n, b, alloc), n}, alloc));
+        }
+
+        const SimplificationCache::Statistics stats = cache.statistics();
+
+        CHECK(stats.hits + stats.misses > 0);
+        CHECK(cache.size() <= 16);
+    }
+}
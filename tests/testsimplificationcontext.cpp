@@ -0,0 +1,115 @@
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <optional>
+#include <string>
+#include <vector>
+#include "doctest/doctest.h"
+#include "sym2/autosimpl.h"
+#include "sym2/expr.h"
+#include "sym2/simplificationcontext.h"
+
+using namespace sym2;
+
+TEST_CASE("Simplification context")
+{
+    const Expr::allocator_type alloc{};
+    const Expr a{"a", alloc};
+    const Expr b{"b", alloc};
+    const Expr c{"c", alloc};
+    const Expr sinA{"sin", a, std::sin, alloc};
+    const auto reasonOf = [](auto&& simplify) -> std::optional<SimplificationAborted::Reason> {
+        try {
+            simplify();
+        } catch (const SimplificationAborted& aborted) {
+            return aborted.reason();
+        }
+
+        return std::nullopt;
+    };
+
+    SUBCASE("Results within the limits are unaffected")
+    {
+        SimplificationContext context{SimplificationLimits{
+          .deadline = std::chrono::steady_clock::now() + std::chrono::hours{1},
+          .maxBlobs = 10000}};
+
+        CHECK(autoSum({c, sinA, b, 2_ex, a, b}, context, alloc)
+          == autoSum({c, sinA, b, 2_ex, a, b}, alloc));
+        CHECK(autoProduct({c, a, b, a, 3_ex}, context, alloc)
+          == autoProduct({c, a, b, a, 3_ex}, alloc));
+        CHECK(autoPower(Expr{4, 9, alloc}, Expr{3, 2, alloc}, context, alloc)
+          == Expr{8, 27, alloc});
+
+        CHECK(context.steps() > 0);
+        CHECK(context.chargedBlobs() > 0);
+    }
+
+    SUBCASE("Usage accumulates")
+    {
+        SimplificationContext context{SimplificationLimits{}};
+
+        autoSum({a, b, c}, context, alloc);
+        const std::size_t steps = context.steps();
+        const std::size_t blobs = context.chargedBlobs();
+        autoSum({a, b, c}, context, alloc);
+
+        CHECK(context.steps() == 2 * steps);
+        CHECK(context.chargedBlobs() == 2 * blobs);
+    }
+
+    SUBCASE("Cancellation")
+    {
+        CancellationToken token;
+        SimplificationContext context{
+          SimplificationLimits{.cancellation = &token, .checkInterval = 1}};
+
+        CHECK_NOTHROW(autoSum({a, b, c}, context, alloc));
+
+        token.cancel();
+
+        CHECK(token.isCancelled());
+        CHECK(reasonOf([&]() { autoSum({a, b, c}, context, alloc); })
+          == SimplificationAborted::Reason::cancelled);
+    }
+
+    SUBCASE("Deadline")
+    {
+        SimplificationContext context{SimplificationLimits{
+          .deadline = std::chrono::steady_clock::now(), .checkInterval = 1}};
+
+        CHECK(reasonOf([&]() { autoProduct({a, b, c, sinA}, context, alloc); })
+          == SimplificationAborted::Reason::deadline);
+    }
+
+    SUBCASE("Huge rational powers exceed the memory budget before they are evaluated")
+    {
+        SimplificationContext context{SimplificationLimits{.maxBlobs = 1000}};
+        const Expr base{4, alloc};
+        const Expr exp{LargeRational{2000000001, 2}, alloc};
+
+        CHECK(reasonOf([&]() { autoPower(base, exp, context, alloc); })
+          == SimplificationAborted::Reason::memoryBudget);
+    }
+
+    SUBCASE("Merging long operand lists exceeds the recursion depth")
+    {
+        std::deque<Expr> symbols;
+
+        for (int i = 0; i < 100; ++i)
+            symbols.emplace_back("x" + std::to_string(i), alloc);
+
+        const std::vector<ExprView<>> evenOps(symbols.begin(), symbols.begin() + 50);
+        const std::vector<ExprView<>> oddOps(symbols.begin() + 50, symbols.end());
+        const Expr lhs = autoSum(evenOps, alloc);
+        const Expr rhs = autoSum(oddOps, alloc);
+        SimplificationContext shallow{SimplificationLimits{.maxDepth = 16}};
+        SimplificationContext deep{SimplificationLimits{.maxDepth = 1000}};
+
+        CHECK(reasonOf([&]() { autoSum(lhs, rhs, shallow, alloc); })
+          == SimplificationAborted::Reason::recursionDepth);
+        CHECK(autoSum(lhs, rhs, deep, alloc) == autoSum(lhs, rhs, alloc));
+        // The depth is restored when aborting, so the context remains usable for small inputs:
+        CHECK_NOTHROW(autoSum(a, b, shallow, alloc));
+    }
+}
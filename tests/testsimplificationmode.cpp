@@ -0,0 +1,80 @@
+#include <cmath>
+#include "doctest/doctest.h"
+#include "sym2/autosimpl.h"
+#include "sym2/expr.h"
+#include "sym2/predicates.h"
+#include "sym2/query.h"
+
+using namespace sym2;
+
+TEST_CASE("Simplification modes")
+{
+    const Expr::allocator_type alloc{};
+    const auto fast = SimplificationMode::fastIntermediate;
+    const Expr a{"a", alloc};
+    const Expr b{"b", alloc};
+    const Expr c{"c", alloc};
+    const Expr d{"d", alloc};
+    const Expr half{1, 2, alloc};
+    const Expr sinA{"sin", a, std::sin, alloc};
+
+    SUBCASE("Sums with like terms")
+    {
+        const Expr twoAB = autoProduct({2_ex, a, b}, fast, alloc);
+        const Expr threeBA = autoProduct({3_ex, b, a}, fast, alloc);
+        const Expr lhs = autoSum({twoAB, c, 5_ex, sinA}, fast, alloc);
+        const Expr rhs = autoSum({d, threeBA, 7_ex, autoMinus(c, alloc)}, fast, alloc);
+        const Expr result = autoSum(lhs, rhs, fast, alloc);
+        const Expr expected = autoSum({autoProduct({5_ex, a, b}, alloc), 12_ex, sinA, d}, alloc);
+
+        CHECK(nOperands(result) == nOperands(expected));
+        CHECK(canonicalize(result, alloc) == expected);
+    }
+
+    SUBCASE("Products with equal bases")
+    {
+        const Expr lhs = autoProduct({a, autoPower(b, 2_ex, alloc), sinA, 3_ex}, fast, alloc);
+        const Expr rhs = autoProduct({autoPower(a, c, alloc), b, half, d}, fast, alloc);
+        const Expr result = autoProduct(lhs, rhs, fast, alloc);
+        const Expr expected = autoProduct(
+          {autoPower(a, autoSum(1_ex, c, alloc), alloc), autoPower(b, 3_ex, alloc), sinA,
+            Expr{3, 2, alloc}, d},
+          alloc);
+
+        CHECK(nOperands(result) == nOperands(expected));
+        CHECK(canonicalize(result, alloc) == expected);
+    }
+
+    SUBCASE("Nested steps")
+    {
+        const auto pipeline = [&](SimplificationMode mode) {
+            const Expr sum = autoSum({a, b, c}, mode, alloc);
+            const Expr power = autoPower(autoProduct(sum, d, mode, alloc), 2_ex, mode, alloc);
+
+            return autoProduct({power, sum, autoPower(d, half, mode, alloc)}, mode, alloc);
+        };
+
+        CHECK(canonicalize(pipeline(fast), alloc) == pipeline(SimplificationMode::canonical));
+    }
+
+    SUBCASE("Reorder canonical input")
+    {
+        const Expr canonical = autoSum({autoProduct(2_ex, a, alloc), b, sinA, c}, alloc);
+        const Expr intermediate = reorder(canonical, fast, alloc);
+        const Expr threeA = autoProduct(3_ex, a, alloc);
+        const Expr result = autoSum(intermediate, threeA, fast, alloc);
+
+        CHECK(canonicalize(intermediate, alloc) == canonical);
+        CHECK(canonicalize(result, alloc) == autoSum(canonical, threeA, alloc));
+    }
+
+    SUBCASE("Canonical results are unchanged")
+    {
+        const Expr e = autoSum({autoProduct({2_ex, a, sinA}, alloc),
+                                 autoPower(autoSum(b, c, alloc), half, alloc), d},
+          alloc);
+
+        CHECK(canonicalize(e, alloc) == e);
+        CHECK(canonicalize(a, alloc) == a);
+    }
+}
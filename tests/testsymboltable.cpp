@@ -0,0 +1,122 @@
+
+#include <cmath>
+#include <stdexcept>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "doctest/doctest.h"
+#include "orderrelation.h"
+#include "sym2/blob.h"
+#include "sym2/eval.h"
+#include "sym2/expr.h"
+#include "sym2/get.h"
+#include "sym2/predicates.h"
+#include "sym2/query.h"
+#include "sym2/symboltable.h"
+#include "testutils.h"
+
+using namespace sym2;
+
+TEST_CASE("Symbol table")
+{
+    const Expr::allocator_type alloc{};
+    const std::string_view longName = "a_descriptive_and_rather_long_symbol_name";
+    const SymbolId id = internSymbol(longName);
+
+    SUBCASE("Interning")
+    {
+        CHECK(internSymbol(longName) == id);
+        CHECK(internSymbol(std::string{longName}) == id);
+        CHECK(internSymbol("another_long_symbol_name") != id);
+        CHECK(internedName(id) == longName);
+        CHECK(nInternedSymbols() >= 2);
+        CHECK_THROWS_AS(internSymbol(""), std::invalid_argument);
+    }
+
+    SUBCASE("Interned symbols occupy a single blob")
+    {
+        const Expr interned{id, DomainFlag::real, alloc};
+
+        CHECK(is<symbol>(interned));
+        CHECK(is<internedSymbol>(interned));
+        CHECK(is < scalar && realDomain > (interned));
+        CHECK_FALSE(is<internedSymbol>(Expr{longName, alloc}));
+        CHECK(get<SymbolId>(interned) == id);
+        CHECK(get<std::string_view>(interned) == longName);
+        CHECK(remoteExtent(ExprView<>{interned}.get()) == 0);
+        CHECK(remoteExtent(ExprView<>{Expr{longName, alloc}}.get()) > 0);
+    }
+
+    SUBCASE("Equality")
+    {
+        const Expr interned{id, alloc};
+
+        CHECK(interned == Expr{internSymbol(longName), alloc});
+        CHECK(interned != Expr{id, DomainFlag::positive, alloc});
+        CHECK(interned != Expr{longName, alloc});
+    }
+
+    SUBCASE("Order relation")
+    {
+        const Expr interned{id, alloc};
+        const Expr plain{longName, alloc};
+        const Expr positive{id, DomainFlag::positive, alloc};
+        const Expr earlier{internSymbol("a_descriptive"), alloc};
+
+        CHECK_FALSE(orderLessThan(interned, interned));
+        CHECK(orderLessThan(positive, interned));
+        CHECK(orderLessThan(earlier, interned));
+        CHECK(orderLessThan(plain, interned) != orderLessThan(interned, plain));
+        CHECK(orderLessThan("a"_ex, interned));
+        CHECK(orderLessThan(interned, "b"_ex));
+    }
+
+    SUBCASE("Interned names are ordered independent of the interning sequence")
+    {
+        const SymbolId zeta = internSymbol("zeta_interned_first");
+        const SymbolId alpha = internSymbol("alpha_interned_second");
+        // Shares the first eight characters with longName:
+        const SymbolId common = internSymbol("a_descriptive_but_shorter");
+
+        CHECK(internedNameLess(alpha, zeta));
+        CHECK_FALSE(internedNameLess(zeta, alpha));
+        CHECK_FALSE(internedNameLess(zeta, zeta));
+        CHECK(internedNameLess(id, common));
+        CHECK_FALSE(internedNameLess(common, id));
+        CHECK(orderLessThan(Expr{alpha, alloc}, Expr{zeta, alloc}));
+        CHECK(orderLessThan(Expr{id, alloc}, Expr{common, alloc}));
+    }
+
+    SUBCASE("Concurrent interning and lookup")
+    {
+        const auto internAll = [](std::vector<SymbolId>& ids) {
+            for (int i = 0; i < 2000; ++i)
+                ids.push_back(internSymbol("concurrent_" + std::to_string(i)));
+        };
+        std::vector<SymbolId> lhs;
+        std::vector<SymbolId> rhs;
+        std::thread other{internAll, std::ref(lhs)};
+
+        internAll(rhs);
+        other.join();
+
+        CHECK(lhs == rhs);
+        CHECK(internedName(lhs[1234]) == "concurrent_1234");
+        CHECK(internedNameLess(lhs[10], lhs[2]));
+    }
+
+    SUBCASE("Evaluation and composites")
+    {
+        const Expr interned{id, alloc};
+        const Expr s = directSum({2_ex, interned}, alloc);
+        const double result = evalReal(s, [&](std::string_view name) {
+            CHECK(name == longName);
+            return 1.5;
+        });
+
+        CHECK(result == doctest::Approx(3.5));
+        CHECK(contains(interned, s));
+        CHECK(secondOperand(s) == interned);
+    }
+}
@@ -0,0 +1,174 @@
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <ranges>
+#include <string>
+#include <vector>
+#include "doctest/doctest.h"
+#include "sym2/blob.h"
+#include "sym2/constants.h"
+#include "sym2/expr.h"
+#include "sym2/operandsview.h"
+#include "sym2/query.h"
+#include "sym2/traversal.h"
+#include "testutils.h"
+
+using namespace sym2;
+
+namespace {
+    void collectRecursively(ExprView<> e, TraversalOrder order, std::vector<ExprView<>>& result)
+    {
+        if (order == TraversalOrder::preorder)
+            result.push_back(e);
+
+        for (const ExprView<> op : OperandsView::operandsOf(e))
+            collectRecursively(op, order, result);
+
+        if (order == TraversalOrder::postorder)
+            result.push_back(e);
+    }
+
+    std::vector<ExprView<>> expected(ExprView<> e, TraversalOrder order)
+    {
+        std::vector<ExprView<>> result;
+
+        collectRecursively(e, order, result);
+
+        return result;
+    }
+
+    std::vector<ExprView<>> collect(Traversal traversal)
+    {
+        std::vector<ExprView<>> result;
+
+        for (const ExprView<> e : traversal)
+            result.push_back(e);
+
+        return result;
+    }
+
+    // Compares pointers, since equal subtrees at different positions must be distinguished:
+    bool identical(const std::vector<ExprView<>>& lhs, const std::vector<ExprView<>>& rhs)
+    {
+        return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+          [](ExprView<> a, ExprView<> b) { return a.get() == b.get(); });
+    }
+}
+
+TEST_CASE("Tree traversal")
+{
+    const Expr::allocator_type alloc{};
+
+    SUBCASE("Scalars are visited once")
+    {
+        const Expr n{42, alloc};
+        const Expr a{"a", alloc};
+        const Expr cx = directComplex(2_ex, 3.5_ex, alloc);
+        const Expr longSymbol{"a_long_symbol_name", alloc};
+
+        for (const ExprView<> e : {ExprView<>{n}, ExprView<>{a}, ExprView<>{pi},
+               ExprView<>{cx}, ExprView<>{longSymbol}}) {
+            CHECK(identical(collect(preorder(e)), {e}));
+            CHECK(identical(collect(postorder(e)), {e}));
+        }
+    }
+
+    SUBCASE("Nested composites with payload blobs")
+    {
+        const Expr fp{1.5, alloc};
+        const Expr li{LargeInt{"2323498273984729837498234029380492839489234902384"}, alloc};
+        const Expr longSymbol{"a_long_symbol_name", alloc};
+        const Expr pw = directPower(longSymbol, fp, alloc);
+        const Expr atan2{"atan2", pw, li, std::atan2, alloc};
+        const Expr pr = directProduct({fp, atan2, "b"_ex, pi}, alloc);
+        const Expr sinPr{"a_long_function_name", pr, std::sin, alloc};
+        const Expr root = directSum({li, sinPr, pr, 2_ex}, alloc);
+
+        for (const TraversalOrder order : {TraversalOrder::preorder, TraversalOrder::postorder}) {
+            const auto result = collect(Traversal{root, order});
+
+            CHECK(result.size() == 22);
+            CHECK(identical(result, expected(root, order)));
+        }
+
+        CHECK(collect(preorder(root)).front() == root);
+        CHECK(collect(postorder(root)).front() == li);
+        CHECK(collect(postorder(root)).back() == root);
+    }
+
+    SUBCASE("Trees deeper than the cached ancestors")
+    {
+        Expr deep{"a", alloc};
+
+        for (int i = 0; i < 100; ++i) {
+            const Expr name{"s" + std::to_string(i), alloc};
+            const Expr pw = directPower(name, Expr{i, alloc}, alloc);
+
+            deep = directSum({pw, deep, name}, alloc);
+        }
+
+        for (const TraversalOrder order : {TraversalOrder::preorder, TraversalOrder::postorder})
+            CHECK(identical(collect(Traversal{deep, order}), expected(deep, order)));
+    }
+
+    SUBCASE("Shared subtrees deeper than the cached ancestors")
+    {
+        Expr deep{"a", alloc};
+
+        for (int i = 0; i < 50; ++i) {
+            const Expr name{"s" + std::to_string(i), alloc};
+
+            deep = directSum({directPower(name, Expr{i, alloc}, alloc), deep, name}, alloc);
+        }
+
+        const Expr unshared = directProduct({deep, "b"_ex, directPower(deep, 2_ex, alloc)}, alloc);
+        const Expr root = shareSubtrees(unshared, alloc);
+
+        REQUIRE(hasSummaryFlag(ExprView<>{root}.get(), SummaryFlag::containsReference));
+
+        for (const TraversalOrder order : {TraversalOrder::preorder, TraversalOrder::postorder}) {
+            const auto result = collect(Traversal{root, order});
+
+            CHECK(result.size() == 2 * collect(preorder(deep)).size() + 4);
+            CHECK(identical(result, expected(root, order)));
+        }
+    }
+
+    SUBCASE("Nested references on the path to deep nodes")
+    {
+        // Each chain element refers to the previous one, which is stored as an earlier operand of
+        // the root. The last element hence leads through a reference per element. Both fewer and
+        // more references than cached ancestors are covered:
+        for (const int length : {20, 40}) {
+            std::deque<Expr> chain;
+
+            chain.emplace_back("a", alloc);
+
+            for (int i = 1; i < length; ++i) {
+                const Expr name{"s" + std::to_string(i), alloc};
+                const Expr arg = directSum({chain.back(), name}, alloc);
+
+                chain.emplace_back("sin", arg, static_cast<UnaryDoubleFctPtr>(std::sin), alloc);
+            }
+
+            const std::vector<ExprView<>> views(chain.begin(), chain.end());
+            const Expr root = shareSubtrees(Expr{CompositeType::sum, views, alloc}, alloc);
+
+            for (const TraversalOrder order : {TraversalOrder::preorder, TraversalOrder::postorder})
+                CHECK(identical(collect(Traversal{root, order}), expected(root, order)));
+        }
+    }
+
+    SUBCASE("Usable with standard range algorithms")
+    {
+        static_assert(std::ranges::input_range<Traversal>);
+
+        const Expr root = directSum({"a"_ex, directProduct({2_ex, "b"_ex}, alloc)}, alloc);
+
+        CHECK(std::ranges::count_if(preorder(root), [](ExprView<> e) { return is<symbol>(e); })
+          == 2);
+        CHECK(contains("b"_ex, root));
+        CHECK_FALSE(contains("c"_ex, root));
+    }
+}
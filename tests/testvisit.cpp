@@ -0,0 +1,63 @@
+
+#include <cmath>
+#include <string_view>
+#include "doctest/doctest.h"
+#include "sym2/constants.h"
+#include "sym2/expr.h"
+#include "sym2/visit.h"
+#include "testutils.h"
+
+using namespace sym2;
+
+namespace {
+    std::string_view kindOf(ExprView<> e)
+    {
+        return visit(e,
+          overloaded{[](ExprView<symbol>) { return "symbol"; },
+            [](ExprView<constant>) { return "constant"; },
+            [](ExprView<number>) { return "number"; }, [](ExprView<sum>) { return "sum"; },
+            [](ExprView<product>) { return "product"; }, [](ExprView<power>) { return "power"; },
+            [](ExprView<function>) { return "function"; }});
+    }
+}
+
+TEST_CASE("Visit expressions")
+{
+    const Expr::allocator_type alloc{};
+
+    SUBCASE("Dispatch to typed handlers")
+    {
+        CHECK(kindOf("a"_ex) == "symbol");
+        CHECK(kindOf(Expr{"a_long_symbol_name", alloc}) == "symbol");
+        CHECK(kindOf(pi) == "constant");
+        CHECK(kindOf(42_ex) == "number");
+        CHECK(kindOf(Expr{2, 3, alloc}) == "number");
+        CHECK(kindOf(1.5_ex) == "number");
+        CHECK(kindOf(Expr{LargeInt{"12345678901234567890"}, alloc}) == "number");
+        CHECK(kindOf(directComplex(2_ex, 3_ex, alloc)) == "number");
+        CHECK(kindOf(directSum({"a"_ex, "b"_ex}, alloc)) == "sum");
+        CHECK(kindOf(directProduct({"a"_ex, "b"_ex}, alloc)) == "product");
+        CHECK(kindOf(directPower("a"_ex, "b"_ex, alloc)) == "power");
+        CHECK(kindOf(Expr{"sin", "a"_ex, std::sin, alloc}) == "function");
+    }
+
+    SUBCASE("Generic fallback")
+    {
+        const auto isPowerHandled = [](ExprView<> e) {
+            return visit(e,
+              overloaded{[](ExprView<power>) { return true; }, [](auto) { return false; }});
+        };
+
+        CHECK(isPowerHandled(directPower("a"_ex, "b"_ex, alloc)));
+        CHECK_FALSE(isPowerHandled(directProduct({"a"_ex, "b"_ex}, alloc)));
+        CHECK_FALSE(isPowerHandled("a"_ex));
+    }
+
+    SUBCASE("Common result type")
+    {
+        const double result = visit(42_ex,
+          overloaded{[](ExprView<number>) { return 1.0; }, [](auto) { return 0; }});
+
+        CHECK(result == 1.0);
+    }
+}